@@ -0,0 +1,1188 @@
+// GuessDraw 渲染内核基准测试（与 Win32 无关，可在 Linux 上构建运行）
+// 用法：guessdraw_bench [宽] [高]                 各内核的正确性校验与耗时
+//       guessdraw_bench --pipeline [选项]          渲染流水线分段计时（见 RunPipeline）
+//       guessdraw_bench --check [名称...]          只做正确性校验、不计时，供 ctest 调用（见 RunChecks）
+#include "effects.h"
+#include "resample.h"
+#include "mipmap.h"
+#include "dirindex.h"
+#include "tiles.h"
+#include "cachefile.h"
+#include "qoi.h"
+#include "inifile.h"
+#include "frametrace.h"
+#include "orient.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// 生成可复现的合成图片：渐变 + 噪声 + 大块白底，覆盖去白底的两种分支
+static std::vector<uint32_t> MakeSyntheticImage(int width, int height) {
+    std::vector<uint32_t> pixels((size_t)width * height);
+    uint32_t seed = 12345;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            seed = seed * 1664525u + 1013904223u;
+            uint32_t noise = seed >> 24;
+            uint32_t b = (x * 255 / width + noise) & 0xFF;
+            uint32_t g = (y * 255 / height) & 0xFF;
+            uint32_t r = (noise * 3) & 0xFF;
+            uint32_t a = 255 - ((noise & 0x3) * 20);
+            if (((x / 64) + (y / 64)) % 3 == 0) b = g = r = 250; // 白底区域
+            pixels[(size_t)y * width + x] = b | (g << 8) | (r << 16) | (a << 24);
+        }
+    }
+    return pixels;
+}
+
+// --check 模式：各项只运行一次，不做计时循环
+static bool s_checkOnly = false;
+
+// 重复运行直到累计超过 minSeconds，返回单次平均耗时（秒）
+template <class Fn>
+static double TimeIt(Fn&& fn, double minSeconds = 0.3) {
+    using clock = std::chrono::steady_clock;
+    if (s_checkOnly) minSeconds = 0.0;
+    else fn(); // 预热
+    int iterations = 0;
+    auto start = clock::now();
+    double elapsed = 0.0;
+    do {
+        fn();
+        iterations++;
+        elapsed = std::chrono::duration<double>(clock::now() - start).count();
+    } while (elapsed < minSeconds);
+    return elapsed / iterations;
+}
+
+static int BenchEffects(int width, int height) {
+    std::vector<uint32_t> src = MakeSyntheticImage(width, height);
+    std::vector<uint32_t> ref(src.size()), out(src.size());
+    double pixels = (double)width * height;
+
+    struct Case { const char* name; EffectParams params; };
+    Case cases[] = {
+        { "opacity",             { false, false, 0.5f } },
+        { "grayscale",           { false, true,  0.5f } },
+        { "remove-white",        { true,  false, 0.5f } },
+        { "remove-white+gray",   { true,  true,  0.7f } },
+    };
+    EffectKernel kernels[] = { EffectKernel::Scalar, EffectKernel::SSE2, EffectKernel::AVX2 };
+
+    int failures = 0;
+    printf("effects %dx%d\n", width, height);
+    printf("%-20s %-8s %10s %10s\n", "case", "kernel", "ns/px", "ms");
+    for (const Case& c : cases) {
+        ApplyEffects(src.data(), width, ref.data(), width, width, height, c.params, EffectKernel::Scalar);
+        for (EffectKernel k : kernels) {
+            if (!IsEffectKernelSupported(k)) continue;
+            double t = TimeIt([&] {
+                ApplyEffects(src.data(), width, out.data(), width, width, height, c.params, k);
+            });
+            // SIMD 实现必须与标量参考逐位一致
+            bool match = memcmp(ref.data(), out.data(), ref.size() * 4) == 0;
+            if (!match) failures++;
+            printf("%-20s %-8s %10.3f %10.2f%s\n", c.name, EffectKernelName(k),
+                   t * 1e9 / pixels, t * 1e3, match ? "" : "  MISMATCH");
+        }
+    }
+    return failures;
+}
+
+// 两幅图逐通道最大误差
+static int MaxChannelDiff(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) {
+    int maxDiff = 0;
+    for (size_t i = 0; i < a.size(); i++) {
+        for (int c = 0; c < 32; c += 8) {
+            int d = (int)((a[i] >> c) & 0xFF) - (int)((b[i] >> c) & 0xFF);
+            maxDiff = std::max(maxDiff, d < 0 ? -d : d);
+        }
+    }
+    return maxDiff;
+}
+
+static int BenchResample(int width, int height) {
+    // 重采样输入为预乘像素
+    std::vector<uint32_t> src = MakeSyntheticImage(width, height);
+    ApplyEffects(src.data(), width, src.data(), width, width, height, EffectParams());
+
+    const float scales[] = { 0.1f, 0.25f, 0.5f, 1.5f };
+    const ResampleFilter filters[] = { ResampleFilter::Bilinear, ResampleFilter::Bicubic, ResampleFilter::Lanczos3 };
+
+    int failures = 0;
+    printf("\nresample %dx%d (ns/px relative to destination pixels)\n", width, height);
+    printf("%-6s %-9s %-8s %8s %10s %10s\n", "scale", "filter", "kernel", "threads", "ns/px", "ms");
+    for (float scale : scales) {
+        int dw = std::max(1, (int)(width * scale));
+        int dh = std::max(1, (int)(height * scale));
+        double pixels = (double)dw * dh;
+        std::vector<uint32_t> ref((size_t)dw * dh), out((size_t)dw * dh);
+        for (ResampleFilter f : filters) {
+            ResampleImage(src.data(), width, height, width, ref.data(), dw, dh, dw, f, 1, ResampleKernel::Scalar);
+            struct Run { ResampleKernel kernel; int threads; };
+            const Run runs[] = { { ResampleKernel::Scalar, 1 }, { ResampleKernel::SSE2, 1 }, { ResampleKernel::Auto, 0 } };
+            for (const Run& r : runs) {
+                if (!IsResampleKernelSupported(r.kernel)) continue;
+                double t = TimeIt([&] {
+                    ResampleImage(src.data(), width, height, width, out.data(), dw, dh, dw, f, r.threads, r.kernel);
+                });
+                bool match = memcmp(ref.data(), out.data(), ref.size() * 4) == 0;
+                if (!match) failures++;
+                printf("%-6.2f %-9s %-8s %8s %10.3f %10.2f%s\n", scale, ResampleFilterName(f),
+                       ResampleKernelName(r.kernel), r.threads == 0 ? "auto" : "1",
+                       t * 1e9 / pixels, t * 1e3, match ? "" : "  MISMATCH");
+            }
+        }
+    }
+
+    // 与浮点参考实现对比（参考实现很慢，只跑一次中等尺寸）。
+    // 定点版两趟各舍入一次，中间值为 8 位，每通道最多偏差 kReferenceTolerance
+    const int kReferenceTolerance = 2;
+    int rw = std::min(width, 1500), rh = std::min(height, 1000);
+    int dw = rw / 2, dh = rh / 2;
+    std::vector<uint32_t> ref((size_t)dw * dh), out((size_t)dw * dh);
+    for (ResampleFilter f : filters) {
+        ResampleImageReference(src.data(), rw, rh, width, ref.data(), dw, dh, dw, f);
+        ResampleImage(src.data(), rw, rh, width, out.data(), dw, dh, dw, f);
+        int diff = MaxChannelDiff(ref, out);
+        if (diff > kReferenceTolerance) failures++;
+        printf("reference %s %dx%d -> %dx%d max channel diff %d (tolerance %d)%s\n", ResampleFilterName(f), rw, rh,
+               dw, dh, diff, kReferenceTolerance, diff > kReferenceTolerance ? "  FAIL" : "");
+    }
+    return failures;
+}
+
+// mip 链构建耗时，以及“从最近级别重采样”与“直接从原图重采样”的对比
+static int BenchMipmap(int width, int height) {
+    std::vector<uint32_t> src = MakeSyntheticImage(width, height);
+
+    printf("\nmipmap %dx%d\n", width, height);
+    MipChain chain;
+    double t = TimeIt([&] {
+        chain.Reset(src.data(), width, height);
+        chain.SelectLevel(1, 1);
+    });
+    printf("build full chain %10.2f ms, %zu extra bytes\n", t * 1e3, chain.MemoryBytes());
+
+    // 缓存命中：已建好的级别不再重复构建
+    t = TimeIt([&] { chain.SelectLevel(1, 1); });
+    printf("select (cached)  %10.4f ms\n", t * 1e3);
+
+    const float scales[] = { 0.05f, 0.1f, 0.25f, 0.5f };
+    printf("%-6s %6s %14s %14s %10s\n", "scale", "level", "direct ms", "mip ms", "speedup");
+    for (float scale : scales) {
+        int dw = std::max(1, (int)(width * scale));
+        int dh = std::max(1, (int)(height * scale));
+        std::vector<uint32_t> out((size_t)dw * dh);
+        int level = chain.SelectLevel(dw, dh);
+        double direct = TimeIt([&] {
+            ResampleImage(src.data(), width, height, width, out.data(), dw, dh, dw, ResampleFilter::Bicubic);
+        });
+        double mip = TimeIt([&] {
+            int lw = chain.Width(level), lh = chain.Height(level);
+            ResampleImage(chain.Pixels(level), lw, lh, lw, out.data(), dw, dh, dw, ResampleFilter::Bicubic);
+        });
+        printf("%-6.2f %6d %14.2f %14.2f %9.1fx\n", scale, level, direct * 1e3, mip * 1e3, direct / mip);
+    }
+    return 0;
+}
+
+// 目录索引：用合成的增删改事件驱动，与暴力扫描的结果逐步比对，并统计单次操作耗时
+static int BenchDirIndex(int files) {
+    std::map<std::wstring, int64_t> truth; // 模拟的目录内容（含非图片文件）
+    DirectoryIndex index;
+    const wchar_t* exts[] = { L".png", L".JPG", L".webp", L".txt", L".ini" };
+    uint32_t seed = 777;
+    auto rnd = [&seed]() { seed = seed * 1664525u + 1013904223u; return seed >> 8; };
+    auto makeName = [&](uint32_t id) {
+        wchar_t buf[32];
+        swprintf(buf, 32, L"img_%06u%ls", id, exts[id % 5]);
+        return std::wstring(buf);
+    };
+
+    // 初始扫描
+    std::vector<DirectoryEntry> scan;
+    for (int i = 0; i < files; i++) {
+        std::wstring name = makeName(rnd() % (files * 2));
+        int64_t mtime = rnd() % 1000000;
+        truth[name] = mtime;
+        scan.push_back({ name, mtime });
+    }
+    double resetTime = TimeIt([&] { index.Reset(scan); }, 0.1);
+    std::vector<DirectoryEntry> unique;
+    for (const auto& [name, mtime] : truth) unique.push_back({ name, mtime });
+    index.Reset(unique);
+
+    // 暴力求解：与原先逐个遍历目录的逻辑一致
+    auto bruteLatest = [&](DirectoryEntry* out) {
+        bool found = false;
+        for (const auto& [name, mtime] : truth) {
+            if (!DirectoryIndex::IsImageName(name)) continue;
+            if (!found || mtime > out->mtime || (mtime == out->mtime && name > out->name)) {
+                out->name = name;
+                out->mtime = mtime;
+                found = true;
+            }
+        }
+        return found;
+    };
+    auto bruteNeighbor = [&](const std::wstring& current, int direction, std::wstring* out) {
+        std::vector<std::wstring> images;
+        for (const auto& [name, mtime] : truth) {
+            if (DirectoryIndex::IsImageName(name)) images.push_back(name);
+        }
+        if (images.empty()) return false;
+        int cur = -1;
+        for (int i = 0; i < (int)images.size(); i++) {
+            if (images[i] == current) { cur = i; break; }
+        }
+        int n = (int)images.size();
+        int next = cur < 0 ? (direction > 0 ? 0 : n - 1) : ((cur + direction) % n + n) % n;
+        *out = images[next];
+        return true;
+    };
+
+    int failures = 0;
+    const int events = 2000;
+    for (int i = 0; i < events; i++) {
+        std::wstring name = makeName(rnd() % (files * 2));
+        switch (rnd() % 3) {
+        case 0: // 新增或修改
+        case 1: {
+            int64_t mtime = rnd() % 1100000;
+            truth[name] = mtime;
+            index.Upsert(name, mtime);
+            break;
+        }
+        default: // 删除
+            truth.erase(name);
+            index.Remove(name);
+            break;
+        }
+
+        // 抽样比对（暴力求解较慢，小目录时每个事件后都比对）
+        if (i % (files <= 1000 ? 1 : 50) != 0) continue;
+        DirectoryEntry a, b;
+        bool ha = index.Latest(&a), hb = bruteLatest(&b);
+        if (ha != hb || (ha && (a.name != b.name || a.mtime != b.mtime))) failures++;
+        for (int direction : { -1, 1 }) {
+            std::wstring current = makeName(rnd() % (files * 2));
+            std::wstring na, nb;
+            bool ra = index.Neighbor(current, direction, &na), rb = bruteNeighbor(current, direction, &nb);
+            if (ra != rb || na != nb) failures++;
+        }
+    }
+
+    // 单次操作耗时
+    DirectoryEntry latest;
+    std::wstring neighbor;
+    double latestTime = TimeIt([&] { index.Latest(&latest); }, 0.1);
+    double neighborTime = TimeIt([&] { index.Neighbor(latest.name, 1, &neighbor); }, 0.1);
+    double upsertTime = TimeIt([&] { index.Upsert(latest.name, latest.mtime + 1); index.Latest(&latest); }, 0.1);
+
+    printf("\ndirindex %d files (%zu images)\n", files, index.Size());
+    printf("reset %10.3f ms, latest %8.1f ns, neighbor %8.1f ns, upsert %8.1f ns%s\n",
+           resetTime * 1e3, latestTime * 1e9, neighborTime * 1e9, upsertTime * 1e9,
+           failures ? "  MISMATCH" : "");
+    return failures;
+}
+
+// 分块图像：视口→块矩形的覆盖性、拼接结果与直接裁剪 mip 级别逐像素比对、缓存上限，以及超大图片的内存占用
+static int BenchTiles(int width, int height) {
+    std::vector<uint32_t> src = MakeSyntheticImage(width, height);
+    MipChain chain;
+    chain.Reset(src.data(), width, height);
+    chain.SelectLevel(1, 1);
+
+    // 按 mip 级别切出前三级的全部块
+    const int levels = 3;
+    TileCache full;
+    full.SetCapacity(SIZE_MAX);
+    int failures = 0;
+    for (int level = 0; level < levels; level++) {
+        int lw, lh;
+        TileLevelSize(width, height, level, &lw, &lh);
+        if (lw != chain.Width(level) || lh != chain.Height(level)) failures++;
+        for (int ty = 0; ty * kTileSize < lh; ty++) {
+            for (int tx = 0; tx * kTileSize < lw; tx++) {
+                auto tile = std::make_shared<TilePixels>();
+                tile->width = std::min(kTileSize, lw - tx * kTileSize);
+                tile->height = std::min(kTileSize, lh - ty * kTileSize);
+                tile->pixels.resize((size_t)tile->width * tile->height);
+                for (int y = 0; y < tile->height; y++) {
+                    memcpy(tile->pixels.data() + (size_t)y * tile->width,
+                           chain.Pixels(level) + (size_t)(ty * kTileSize + y) * lw + tx * kTileSize,
+                           (size_t)tile->width * 4);
+                }
+                full.Insert({ level, tx, ty }, tile);
+            }
+        }
+    }
+
+    uint32_t seed = 4242;
+    auto rnd = [&seed]() { seed = seed * 1664525u + 1013904223u; return seed >> 8; };
+    int viewW = 1920, viewH = 1080;
+    int uncovered = 0, composeMismatch = 0, missingMismatch = 0;
+    const int top = chain.SelectLevel(1, 1);
+    for (int i = 0; i < 60; i++) {
+        TileView view;
+        view.imageW = width;
+        view.imageH = height;
+        view.scale = 0.2f + (rnd() % 1000) / 1000.0f * 1.3f;
+        view.rotation = (int)(rnd() % 36) * 10;
+        view.centerX = (float)((int)(rnd() % (viewW * 2)) - viewW / 2);
+        view.centerY = (float)((int)(rnd() % (viewH * 2)) - viewH / 2);
+        view.viewW = viewW;
+        view.viewH = viewH;
+        int level = std::min(levels - 1, SelectTileLevel(width, height, view.scale));
+        int lw = chain.Width(level), lh = chain.Height(level);
+        TileRect rect;
+        if (!VisibleTileRect(view, level, &rect)) continue;
+
+        // 视口内落在图片上的每个采样点都必须在矩形内
+        double rad = view.rotation * 3.14159265358979 / 180.0;
+        for (int k = 0; k < 200; k++) {
+            double dx = rnd() % viewW - view.centerX, dy = rnd() % viewH - view.centerY;
+            double ix = ( dx * cos(rad) + dy * sin(rad)) / view.scale + width * 0.5;
+            double iy = (-dx * sin(rad) + dy * cos(rad)) / view.scale + height * 0.5;
+            if (ix < 0 || iy < 0 || ix >= width || iy >= height) continue;
+            double lx = ix * lw / width, ly = iy * lh / height;
+            if (lx < rect.x || ly < rect.y || lx >= rect.x + rect.width || ly >= rect.y + rect.height) uncovered++;
+        }
+
+        // 全部块都在：拼接结果应与直接裁剪完全一致
+        std::vector<uint32_t> region((size_t)rect.width * rect.height);
+        ComposeTileRegion(full, level, lw, lh, rect, nullptr, 0, 0, region.data());
+        for (int y = 0; y < rect.height; y++) {
+            if (memcmp(region.data() + (size_t)y * rect.width,
+                       chain.Pixels(level) + (size_t)(rect.y + y) * lw + rect.x, (size_t)rect.width * 4) != 0) {
+                composeMismatch++;
+                break;
+            }
+        }
+
+        // 只有棋盘格一半的块：缺失数应与实际缺的块数一致
+        TileCache partial;
+        partial.SetCapacity(SIZE_MAX);
+        int expectedMissing = 0;
+        for (const TileKey& t : TilesInRect(level, rect, 0.0f, 0.0f)) {
+            if ((t.x + t.y) % 2 == 0) partial.Insert(t, full.Find(t));
+            else expectedMissing++;
+        }
+        int missing = ComposeTileRegion(partial, level, lw, lh, rect, chain.Pixels(top),
+                                        chain.Width(top), chain.Height(top), region.data());
+        if (missing != expectedMissing) missingMismatch++;
+    }
+
+    // 缓存上限
+    TileCache bounded;
+    size_t tileBytes = (size_t)kTileSize * kTileSize * 4;
+    bounded.SetCapacity(tileBytes * 10);
+    for (int i = 0; i < 100; i++) bounded.Insert({ 0, i, 0 }, full.Find({ 0, 0, 0 }));
+    bool overCap = bounded.Bytes() > tileBytes * 10;
+
+    // 拼接耗时：1080p 视口、原尺寸
+    TileView view;
+    view.imageW = width;
+    view.imageH = height;
+    view.centerX = width * 0.5f - 200;
+    view.centerY = height * 0.5f - 100;
+    view.viewW = viewW;
+    view.viewH = viewH;
+    TileRect rect;
+    std::vector<uint32_t> region;
+    double composeTime = 0.0;
+    if (VisibleTileRect(view, 0, &rect)) {
+        region.resize((size_t)rect.width * rect.height);
+        composeTime = TimeIt([&] { ComposeTileRegion(full, 0, width, height, rect, nullptr, 0, 0, region.data()); }, 0.1);
+    }
+
+    failures += uncovered + composeMismatch + missingMismatch + (overCap ? 1 : 0);
+    printf("\ntiles %dx%d (tile %d)\n", width, height, kTileSize);
+    printf("uncovered %d, compose mismatch %d, missing mismatch %d, cache %zu/%zu bytes%s\n",
+           uncovered, composeMismatch, missingMismatch, bounded.Bytes(), tileBytes * 10,
+           failures ? "  MISMATCH" : "");
+    printf("compose %dx%d region %8.2f ms\n", rect.width, rect.height, composeTime * 1e3);
+
+    // 40000x40000 的超大图片在 4K 视口上实际需要的像素量（整张解码约 6.4 GB）
+    printf("%-6s %-4s %6s %12s %8s %10s\n", "scale", "rot", "level", "region", "tiles", "MB");
+    const int hugeW = 40000, hugeH = 40000;
+    for (float scale : { 1.0f, 0.5f, 0.2f, 0.1f }) {
+        for (int rotation : { 0, 45 }) {
+            TileView huge;
+            huge.imageW = hugeW;
+            huge.imageH = hugeH;
+            huge.scale = scale;
+            huge.rotation = rotation;
+            huge.centerX = 1920.0f;
+            huge.centerY = 1080.0f;
+            huge.viewW = 3840;
+            huge.viewH = 2160;
+            int level = SelectTileLevel(hugeW, hugeH, scale);
+            TileRect r;
+            if (!VisibleTileRect(huge, level, &r)) continue;
+            size_t tiles = TilesInRect(level, r, 0.0f, 0.0f).size();
+            printf("%-6.2f %-4d %6d %5dx%-6d %8zu %10.1f\n", scale, rotation, level, r.width, r.height, tiles,
+                   (double)r.width * r.height * 4 / (1024.0 * 1024.0));
+        }
+    }
+    return failures;
+}
+
+// 磁盘缓存格式：blob 写入/解析与原 mip 级别逐像素比对、损坏文件的拒绝、外部级别接入 MipChain，
+// 以及索引的 LRU 淘汰与序列化往返
+static int BenchDiskCache(int width, int height) {
+    std::vector<uint32_t> src = MakeSyntheticImage(width, height);
+    MipChain chain;
+    chain.Reset(src.data(), width, height);
+    chain.SelectLevel(std::max(1, width / 8), std::max(1, height / 8));
+
+    CacheBlobInfo info;
+    info.mtime = 133000000000000000ull;
+    info.size = 12345678;
+    info.keyHash = CacheKeyHash(L"C:\\Pictures\\ref.png", info.mtime, info.size);
+    info.width = width;
+    info.height = height;
+    info.levels = chain.LevelCount();
+    std::vector<const uint32_t*> levels;
+    for (int i = 0; i < info.levels; i++) levels.push_back(chain.Pixels(i));
+
+    int failures = 0;
+    std::vector<uint8_t> blob(CacheBlobBytes(info));
+    double fillTime = TimeIt([&] { FillCacheBlob(info, levels.data(), blob.data()); });
+
+    CacheBlobInfo parsed;
+    const uint32_t* level0 = nullptr;
+    double parseTime = TimeIt([&] {
+        if (ParseCacheBlob(blob.data(), blob.size(), &parsed)) level0 = CacheBlobLevel(blob.data(), parsed, 0);
+    });
+    if (!level0 || parsed.keyHash != info.keyHash || parsed.mtime != info.mtime || parsed.size != info.size ||
+        parsed.width != width || parsed.height != height || parsed.levels != info.levels) {
+        failures++;
+    }
+
+    // 各级内容一致、起点按 64 字节对齐；由 blob 接入的 mip 链继续构建更小级别时与原链一致
+    int mismatches = 0;
+    MipChain mapped;
+    mapped.Reset(CacheBlobLevel(blob.data(), parsed, 0), width, height);
+    for (int i = 0; i < info.levels; i++) {
+        size_t offset = CacheBlobLevelOffset(width, height, i);
+        const uint32_t* p = CacheBlobLevel(blob.data(), parsed, i);
+        if (offset % kCacheBlobAlign != 0 ||
+            memcmp(p, chain.Pixels(i), (size_t)chain.Width(i) * chain.Height(i) * 4) != 0) {
+            mismatches++;
+        }
+        if (i > 0) mapped.AdoptLevel(p, chain.Width(i), chain.Height(i));
+    }
+    int deep = chain.SelectLevel(1, 1);
+    if (mapped.SelectLevel(1, 1) != deep ||
+        memcmp(mapped.Pixels(deep - 1), chain.Pixels(deep - 1), (size_t)chain.Width(deep - 1) * chain.Height(deep - 1) * 4) != 0) {
+        mismatches++;
+    }
+    failures += mismatches;
+
+    // 写入中断、被改写的文件必须被拒绝
+    int accepted = 0;
+    if (ParseCacheBlob(blob.data(), blob.size() - 1, &parsed)) accepted++;
+    std::vector<uint8_t> bad(blob.begin(), blob.begin() + kCacheBlobHeaderBytes);
+    bad.resize(blob.size());
+    bad[0] ^= 0xFF;
+    if (ParseCacheBlob(bad.data(), bad.size(), &parsed)) accepted++;
+    bad[0] ^= 0xFF;
+    bad[40] = 60; // 级别数超出 mip 链长度
+    if (ParseCacheBlob(bad.data(), bad.size(), &parsed)) accepted++;
+    failures += accepted;
+
+    double mb = blob.size() / (1024.0 * 1024.0);
+    printf("disk cache %dx%d, %d levels, blob %.1f MB\n", width, height, info.levels, mb);
+    printf("  write %8.2f ms (%.2f GB/s)   open %8.3f us   level mismatches %d   corrupt accepted %d\n",
+           fillTime * 1e3, mb / 1024.0 / fillTime, parseTime * 1e6, mismatches, accepted);
+
+    // 索引：2000 张各 1 MB，最早的 100 张被再次访问后上限减半，应淘汰其余最久未用的 1000 张
+    DiskCacheIndex index;
+    std::vector<uint64_t> removed;
+    const int entries = 2000;
+    auto entryPath = [](int i) { return L"D:\\Art\\Reference\\image_" + std::to_wstring(i) + L".png"; };
+    for (int i = 0; i < entries; i++) {
+        DiskCacheEntry e;
+        e.path = entryPath(i);
+        e.mtime = 1000 + i;
+        e.size = 5000 + i;
+        e.bytes = 1024 * 1024;
+        index.Insert(e, &removed);
+    }
+    for (int i = 0; i < 100; i++) {
+        if (!index.Find(entryPath(i), 1000 + i, 5000 + i)) failures++;
+    }
+    if (index.Find(entryPath(0), 999, 5000)) failures++;                     // 修改时间不同
+    if (!index.Find(L"d:\\art\\REFERENCE\\image_1.png", 1001, 5001)) failures++; // 路径不区分大小写
+    index.Trim((uint64_t)entries / 2 * 1024 * 1024, &removed);
+    int lostRecent = 0;
+    for (int i = 0; i < 100; i++) {
+        if (!index.Find(entryPath(i), 1000 + i, 5000 + i)) lostRecent++;
+    }
+    if (removed.size() != entries / 2 || index.Count() != entries / 2 || lostRecent != 0) failures++;
+
+    // 同一路径的新版本替换旧版本
+    removed.clear();
+    DiskCacheEntry changed;
+    changed.path = entryPath(1);
+    changed.mtime = 9999;
+    changed.size = 5001;
+    changed.bytes = 2 * 1024 * 1024;
+    index.Insert(changed, &removed);
+    if (removed.size() != 1 || removed[0] != CacheKeyHash(entryPath(1), 1001, 5001) || index.Count() != entries / 2) {
+        failures++;
+    }
+
+    std::vector<uint8_t> file = index.Serialize();
+    DiskCacheIndex loaded;
+    bool roundTrip = loaded.Parse(file.data(), file.size()) && loaded.Count() == index.Count() &&
+                     loaded.Bytes() == index.Bytes() && loaded.Keys() == index.Keys() &&
+                     loaded.Find(entryPath(1), 9999, 5001) != nullptr;
+    if (!roundTrip) failures++;
+    bool truncatedRejected = !loaded.Parse(file.data(), file.size() - 3) && loaded.Count() == 0;
+    if (!truncatedRejected) failures++;
+
+    printf("  index %zu entries, %.1f KB (%.0f B/entry)   round trip %s   truncated rejected %s   recent evicted %d\n",
+           index.Count(), file.size() / 1024.0, (double)file.size() / index.Count(),
+           roundTrip ? "ok" : "FAIL", truncatedRejected ? "ok" : "FAIL", lostRecent);
+    return failures;
+}
+
+// QOI：合成图片（含半透明）与不透明的"截图"式图片都必须逐位还原，并与编码吞吐一起报告；
+// 截断、篡改文件头的数据必须被拒绝
+static int BenchQoi(int width, int height) {
+    std::vector<uint32_t> photo = MakeSyntheticImage(width, height);
+    // 不透明、大面积纯色与少量渐变，接近界面截图
+    std::vector<uint32_t> screen((size_t)width * height);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            uint32_t c = ((x / 200) + (y / 120)) % 4 == 0 ? 0xFFF3F3F3 : 0xFFFFFFFF;
+            if (y % 40 < 18 && x % 300 < 220) c = 0xFF202020 + (uint32_t)((x * 7 + y) % 5); // 文字行
+            if (x < 240) c = 0xFF000000 | ((uint32_t)(y * 255 / height) << 8) | 0x30;       // 侧栏渐变
+            screen[(size_t)y * width + x] = c;
+        }
+    }
+
+    struct Case { const char* name; const std::vector<uint32_t>* pixels; int channels; };
+    Case cases[] = { { "synthetic-rgba", &photo, 4 }, { "screen-rgb", &screen, 3 } };
+
+    int failures = 0;
+    double megabytes = (double)width * height * 4 / (1024.0 * 1024.0);
+    printf("qoi %dx%d\n", width, height);
+    printf("%-16s %10s %10s %12s %12s\n", "case", "ratio", "bytes/px", "enc MB/s", "dec MB/s");
+    for (const Case& c : cases) {
+        std::vector<uint8_t> encoded;
+        double encodeTime = TimeIt([&] { encoded = EncodeQoi(c.pixels->data(), width, height, c.channels); });
+        std::vector<uint32_t> decoded;
+        QoiHeader header;
+        bool ok = false;
+        double decodeTime = TimeIt([&] { ok = DecodeQoi(encoded.data(), encoded.size(), &decoded, &header); });
+        bool match = ok && header.width == width && header.height == height && header.channels == c.channels &&
+                     decoded == *c.pixels;
+        if (!match) failures++;
+
+        // 截断（包括只缺结束标记）与错误的魔数都必须失败，且不越界
+        bool rejected = !DecodeQoi(encoded.data(), encoded.size() / 2, &decoded, nullptr) &&
+                        !DecodeQoi(encoded.data(), encoded.size() - kQoiPaddingBytes, &decoded, nullptr);
+        std::vector<uint8_t> corrupt = encoded;
+        corrupt[0] = 'x';
+        rejected = rejected && !DecodeQoi(corrupt.data(), corrupt.size(), &decoded, nullptr);
+        if (!rejected) failures++;
+
+        printf("%-16s %10.3f %10.3f %12.0f %12.0f   round trip %s   corrupt rejected %s\n", c.name,
+               (double)encoded.size() / (c.pixels->size() * 4), (double)encoded.size() / c.pixels->size(),
+               megabytes / encodeTime, megabytes / decodeTime, match ? "ok" : "FAIL", rejected ? "ok" : "FAIL");
+    }
+
+    // 边界：1x1、只有游程、超过 62 的游程与索引命中
+    std::vector<uint32_t> tiny = { 0x80123456 };
+    std::vector<uint32_t> runs(1000, 0xFF000000);
+    for (size_t i = 500; i < runs.size(); i += 3) runs[i] = 0x00000000;
+    for (const auto* edge : { &tiny, &runs }) {
+        int w = (int)edge->size();
+        std::vector<uint8_t> data = EncodeQoi(edge->data(), w, 1, 4);
+        std::vector<uint32_t> back;
+        if (!DecodeQoi(data.data(), data.size(), &back, nullptr) || back != *edge) failures++;
+    }
+
+    // 其他编码器的文件：以初始像素的游程开头，之后用 QOI_OP_INDEX 引用它（槽位 53），解码器必须在游程后也写入索引
+    std::vector<uint8_t> indexed = { 'q', 'o', 'i', 'f', 0, 0, 0, 3, 0, 0, 0, 1, 4, 0,
+                                     0xC0, 0xFE, 0x10, 0x20, 0x30, 0x35,
+                                     0, 0, 0, 0, 0, 0, 0, 1 };
+    std::vector<uint32_t> back;
+    std::vector<uint32_t> expected = { 0xFF000000, 0xFF102030, 0xFF000000 };
+    bool indexOk = DecodeQoi(indexed.data(), indexed.size(), &back, nullptr) && back == expected;
+    if (!indexOk) failures++;
+    printf("run then index: %s\n", indexOk ? "ok" : "FAIL");
+    return failures;
+}
+
+// INI 文档：与 Win32 INI 函数一致的语义（大小写、重复键、引号、整数解析）、注释与未知键保留、
+// 编码往返；并测量一次完整的载入（解码 + 解析 + 读取全部配置项）与保存（写入全部配置项 + 序列化 + 编码）
+static int BenchIni() {
+    int failures = 0;
+    auto check = [&failures](bool ok, const char* what) {
+        if (!ok) {
+            failures++;
+            printf("  ini FAIL: %s\n", what);
+        }
+    };
+
+    IniDocument doc;
+    doc.Parse(L"; 手工写的注释\r\n[Image]\r\nDirectory = \"C:\\图片\\zGuess\"\r\nOpacity=35\r\nopacity=90\r\n"
+              L"Custom=keep me\r\n\r\n[window]\nMonitor=-1\nFitToImage=abc\nScale=12px\n");
+    check(doc.GetString(L"image", L"DIRECTORY", L"") == L"C:\\图片\\zGuess", "quoted value, case-insensitive names");
+    check(doc.GetInt(L"Image", L"Opacity", 0) == 35, "first duplicate key wins");
+    check(doc.GetInt(L"Window", L"Monitor", 0) == -1, "negative int");
+    check(doc.GetInt(L"Window", L"FitToImage", 7) == 0, "non-numeric int is 0");
+    check(doc.GetInt(L"Window", L"Scale", 7) == 12, "leading digits");
+    check(doc.GetInt(L"Window", L"Missing", 7) == 7, "missing key fallback");
+    check(doc.GetInt(L"Nowhere", L"Monitor", 3) == 3, "missing section fallback");
+
+    doc.SetInt(L"Image", L"OPACITY", 40);
+    doc.SetInt(L"Window", L"RefineDelayMs", 150);
+    doc.Set(L"Drag", L"MouseButton", L"1");
+    std::wstring text = doc.Serialize();
+    check(text.find(L"; 手工写的注释\r\n") == 0, "comment kept");
+    check(text.find(L"Custom=keep me") != std::wstring::npos, "unknown key kept");
+    check(text.find(L"OPACITY") == std::wstring::npos && doc.GetInt(L"Image", L"Opacity", 0) == 40,
+          "existing key updated in place");
+    check(text.find(L"RefineDelayMs=150\r\n") < text.find(L"[Drag]"), "new key appended to its section");
+
+    IniDocument reparsed;
+    reparsed.Parse(text);
+    check(reparsed.Serialize() == text, "serialize round trip");
+
+    std::vector<uint8_t> bytes = EncodeIniText(text);
+    std::wstring decoded;
+    check(DecodeIniText(bytes.data(), bytes.size(), &decoded) && decoded == text, "UTF-16LE round trip");
+    const uint8_t utf8[] = { 0xEF, 0xBB, 0xBF, 'A', '=', 0xE5, 0x9B, 0xBE, 0xF0, 0x9F, 0x98, 0x80, '\n' };
+    check(DecodeIniText(utf8, sizeof(utf8), &decoded) && decoded.size() >= 5 && decoded[2] == 0x56FE,
+          "UTF-8 with BOM");
+    const uint8_t ansi[] = { 'A', '=', '1' };
+    check(!DecodeIniText(ansi, sizeof(ansi), &decoded), "no BOM left to the caller");
+
+    // 与程序实际配置规模相当：7 个节、约 45 个键
+    static const wchar_t* sections[] = { L"Image", L"Window", L"Render", L"Cache", L"Screenshot", L"Hotkeys", L"Drag" };
+    IniDocument config;
+    int keys = 0;
+    for (int i = 0; i < 46; i++) {
+        config.SetInt(sections[i % 7], L"Key" + std::to_wstring(i), i * 37);
+        keys++;
+    }
+    config.Set(L"Image", L"Directory", L"C:\\Users\\someone\\Pictures\\zGuess");
+    std::vector<uint8_t> file = EncodeIniText(config.Serialize());
+
+    int sum = 0;
+    double loadTime = TimeIt([&] {
+        std::wstring t;
+        DecodeIniText(file.data(), file.size(), &t);
+        IniDocument d;
+        d.Parse(t);
+        for (int i = 0; i < keys; i++) sum += d.GetInt(sections[i % 7], L"Key" + std::to_wstring(i), 0);
+    }, 0.1);
+    size_t saved = 0;
+    double saveTime = TimeIt([&] {
+        for (int i = 0; i < keys; i++) config.SetInt(sections[i % 7], L"Key" + std::to_wstring(i), i * 41);
+        saved += EncodeIniText(config.Serialize()).size();
+    }, 0.1);
+    check(sum != 0 && saved != 0, "benchmark sanity");
+    printf("ini %d keys, %zu bytes   load %.1f us   save %.1f us   semantics %s\n", keys, file.size(),
+           loadTime * 1e6, saveTime * 1e6, failures == 0 ? "ok" : "FAIL");
+    return failures;
+}
+
+static int BenchOrient(int width, int height) {
+    std::vector<uint32_t> src = MakeSyntheticImage(width, height);
+    std::vector<uint32_t> out(src.size()), ref(src.size());
+    int failures = 0;
+
+    // 顺时针 90°：目标左上角取自源左下角；左右镜像后再转则取自右下角
+    const uint32_t tiny[6] = { 1, 2, 3, 4, 5, 6 }; // 3x2
+    uint32_t turned[6];
+    Orientation cw;
+    cw.quarterTurns = 1;
+    OrientImage(tiny, 3, 2, 3, turned, 2, cw);
+    const uint32_t expectCw[6] = { 4, 1, 5, 2, 6, 3 };
+    Orientation mirrored = cw;
+    mirrored.mirrorH = true;
+    uint32_t mirroredOut[6];
+    OrientImage(tiny, 3, 2, 3, mirroredOut, 2, mirrored);
+    const uint32_t expectMirrored[6] = { 6, 3, 5, 2, 4, 1 };
+    if (memcmp(turned, expectCw, sizeof(turned)) != 0 || memcmp(mirroredOut, expectMirrored, sizeof(turned)) != 0) {
+        printf("  orient FAIL: clockwise / mirror semantics\n");
+        failures++;
+    }
+
+    printf("%-18s %10s %10s %8s   %s\n", "orientation", "ref ms", "block ms", "ns/px", "check");
+    static const char* names[] = { "r0", "r90", "r180", "r270" };
+    for (int turns = 0; turns < 4; turns++) {
+        for (int mirror = 0; mirror < 3; mirror++) {
+            Orientation o;
+            o.quarterTurns = turns;
+            o.mirrorH = mirror == 1;
+            o.mirrorV = mirror == 2;
+            int dw, dh;
+            OrientedSize(width, height, o, &dw, &dh);
+            OrientImageReference(src.data(), width, height, width, ref.data(), dw, o);
+            OrientImage(src.data(), width, height, width, out.data(), dw, o);
+            bool ok = out == ref;
+            if (!ok) failures++;
+            // 参考实现逐像素计算坐标，只在第一组上计时作对照
+            double tRef = mirror == 0 ? TimeIt([&] {
+                OrientImageReference(src.data(), width, height, width, ref.data(), dw, o);
+            }, 0.1) : 0.0;
+            double t = TimeIt([&] { OrientImage(src.data(), width, height, width, out.data(), dw, o); }, 0.1);
+            char label[32];
+            snprintf(label, sizeof(label), "%s%s", names[turns], mirror == 1 ? "+mirrorH" : mirror == 2 ? "+mirrorV" : "");
+            printf("%-18s %10.2f %10.2f %8.3f   %s\n", label, tRef * 1e3, t * 1e3, t * 1e9 / src.size(),
+                   ok ? "ok" : "MISMATCH");
+        }
+    }
+
+    // 先左右再上下镜像等于旋转 180°
+    Orientation both;
+    both.mirrorH = both.mirrorV = true;
+    Orientation half;
+    half.quarterTurns = 2;
+    OrientImage(src.data(), width, height, width, out.data(), width, both);
+    OrientImage(src.data(), width, height, width, ref.data(), width, half);
+    if (out != ref) {
+        printf("  orient FAIL: mirrorH + mirrorV != 180\n");
+        failures++;
+    }
+    return failures;
+}
+
+static int BenchFrameTrace() {
+    int failures = 0;
+    auto check = [&failures](bool ok, const char* what) {
+        if (!ok) {
+            failures++;
+            printf("  trace FAIL: %s\n", what);
+        }
+    };
+
+    // 容量 64 的缓冲写入 100 次，只保留最新的 64 次
+    FrameTrace trace(64);
+    for (int i = 0; i < 100; i++) {
+        trace.BeginFrame();
+        trace.Record(TRACE_RESAMPLE, i, (i * 37) % 100 + 1);
+    }
+    check(trace.Summarize(TRACE_RESAMPLE, 1000).samples == 64, "ring keeps only the newest events");
+    check(trace.Summarize(TRACE_EFFECTS).samples == 0, "empty stage");
+
+    // 100..1 ms 依次写入
+    FrameTrace full(256);
+    for (int i = 100; i >= 1; i--) full.Record(TRACE_FRAME, 100 - i, i);
+    StageSummary s = full.Summarize(TRACE_FRAME, 100);
+    check(s.samples == 100 && s.p50 == 50 && s.p95 == 95 && s.max == 100, "nearest-rank percentiles");
+    s = full.Summarize(TRACE_FRAME, 10); // 最近 10 次为 10..1
+    check(s.samples == 10 && s.max == 10 && s.p50 == 5, "window takes the newest events");
+
+    full.Count(TRACE_CACHE_MISS);
+    full.Count(TRACE_CACHE_MISS);
+    TraceExportInfo info;
+    std::string csv = full.ToCsv(&info);
+    size_t lines = std::count(csv.begin(), csv.end(), '\n');
+    check(full.Counter(TRACE_CACHE_MISS) == 2 && lines == 104, "counters appear in the CSV");
+    check(csv.rfind("# all 102 events", 0) == 0 && info.events == 102 && info.dropped == 0,
+          "CSV states it covers the whole session");
+    check(csv.find("\nframe,start_ms,stage,duration_ms\n") != std::string::npos && csv.find(",cache_miss,") != std::string::npos,
+          "CSV header and names");
+
+    // 写满后导出的只是最近一段，首行注明被覆盖的条数与帧范围
+    csv = trace.ToCsv(&info);
+    check(info.events == 64 && info.dropped == 36 && info.firstFrame == 37 && info.lastFrame == 100 &&
+          csv.rfind("# newest 64 events (ring capacity 64), frames 37-100; 36 older events overwritten\n", 0) == 0,
+          "CSV states the window after the ring wraps");
+
+    // 渲染线程每帧约十次记录，单次开销应远小于 1 us
+    double recordTime = TimeIt([&] {
+        for (int i = 0; i < 1000; i++) {
+            ScopedTraceStage stage(TRACE_COMPOSE);
+        }
+    }, 0.1) / 1000;
+    FrameTrace& session = SessionTrace();
+    for (int i = 0; i < 20000; i++) session.Record(TRACE_FRAME, i, i % 17);
+    double summarizeTime = TimeIt([&] { session.Summarize(TRACE_FRAME); }, 0.1);
+    printf("trace record %.0f ns   summarize %.1f us   semantics %s\n", recordTime * 1e9, summarizeTime * 1e6,
+           failures == 0 ? "ok" : "FAIL");
+    return failures;
+}
+
+// ============ 渲染流水线基准 ============
+// 按 DrawTransparentWindow 的步骤逐段计时：解码 → mip → 效果 → 缩放 → 旋转 → 合成到显示器后备缓冲，
+// 图片为固定的合成语料（1 MP 起），结果以 ns/px 与每秒帧数给出，可写成 JSON 并与提交的基线比对
+
+struct PipelineResult {
+    std::string key;      // 语料/阶段/用例，如 "4MP/resample/x0.50"
+    double nsPerPixel = 0; // 相对该阶段输出像素
+    double fps = 0;        // 每秒可完成的次数
+};
+
+// 与 drawing.cpp 相同的旋转包围盒
+static void RotatedBounds(int w, int h, int degrees, int* outW, int* outH) {
+    float rad = degrees * 3.14159265f / 180.0f;
+    float cosA = fabsf(cosf(rad));
+    float sinA = fabsf(sinf(rad));
+    *outW = std::max(1, (int)(w * cosA + h * sinA));
+    *outH = std::max(1, (int)(w * sinA + h * cosA));
+}
+
+// 任意角度旋转的可移植模型：预乘像素绕包围盒中心旋转，双线性采样。
+// 程序中这一步由 GDI+ 完成，这里只用来跟踪该阶段的量级（与 GDI+ 的耗时并不相同）
+static void RotateBilinear(const uint32_t* src, int w, int h, uint32_t* dst, int dw, int dh, int degrees) {
+    float rad = degrees * 3.14159265f / 180.0f;
+    float c = cosf(rad), s = sinf(rad);
+    float cx = w / 2.0f, cy = h / 2.0f, dcx = dw / 2.0f, dcy = dh / 2.0f;
+    for (int y = 0; y < dh; y++) {
+        float ry = y + 0.5f - dcy;
+        // 逆变换：目标像素中心 → 源坐标
+        float sx = (0.5f - dcx) * c + ry * s + cx - 0.5f;
+        float sy = -(0.5f - dcx) * s + ry * c + cy - 0.5f;
+        uint32_t* row = dst + (size_t)y * dw;
+        for (int x = 0; x < dw; x++, sx += c, sy -= s) {
+            int x0 = (int)floorf(sx), y0 = (int)floorf(sy);
+            if (x0 < -1 || y0 < -1 || x0 >= w || y0 >= h) {
+                row[x] = 0;
+                continue;
+            }
+            uint32_t fx = (uint32_t)((sx - x0) * 256.0f), fy = (uint32_t)((sy - y0) * 256.0f);
+            auto at = [&](int px, int py) -> uint32_t {
+                return (px < 0 || py < 0 || px >= w || py >= h) ? 0 : src[(size_t)py * w + px];
+            };
+            uint32_t p00 = at(x0, y0), p10 = at(x0 + 1, y0), p01 = at(x0, y0 + 1), p11 = at(x0 + 1, y0 + 1);
+            uint32_t out = 0;
+            for (int ch = 0; ch < 32; ch += 8) {
+                uint32_t top = ((p00 >> ch) & 0xFF) * (256 - fx) + ((p10 >> ch) & 0xFF) * fx;
+                uint32_t bottom = ((p01 >> ch) & 0xFF) * (256 - fx) + ((p11 >> ch) & 0xFF) * fx;
+                out |= ((top * (256 - fy) + bottom * fy + 32768) >> 16) << ch;
+            }
+            row[x] = out;
+        }
+    }
+}
+
+// 与 RenderSurface 相同的分派：90° 整数倍走无损重排，其余角度走旋转采样
+static void RotateStage(const uint32_t* src, int w, int h, uint32_t* dst, int dw, int dh, int degrees) {
+    if (degrees % 90 == 0) {
+        Orientation o;
+        o.quarterTurns = degrees / 90;
+        OrientImage(src, w, h, w, dst, dw, o);
+    } else {
+        RotateBilinear(src, w, h, dst, dw, dh, degrees);
+    }
+}
+
+// 全屏模式的合成：清掉上一帧的图片区域，再把结果拷到后备缓冲的新位置（与 BlitToDib 相同的裁剪）
+struct ComposeTarget {
+    std::vector<uint32_t> pixels;
+    int width = 3840;
+    int height = 2160;
+    int dirtyX = 0, dirtyY = 0, dirtyW = 0, dirtyH = 0;
+};
+
+static void ComposeFrame(ComposeTarget& target, const uint32_t* surface, int w, int h, int x, int y) {
+    for (int row = 0; row < target.dirtyH; row++) {
+        memset(target.pixels.data() + (size_t)(target.dirtyY + row) * target.width + target.dirtyX, 0,
+               (size_t)target.dirtyW * 4);
+    }
+    int x0 = std::max(0, x), y0 = std::max(0, y);
+    int x1 = std::min(target.width, x + w), y1 = std::min(target.height, y + h);
+    target.dirtyW = target.dirtyH = 0;
+    if (x0 >= x1 || y0 >= y1) return;
+    for (int row = y0; row < y1; row++) {
+        memcpy(target.pixels.data() + (size_t)row * target.width + x0, surface + (size_t)(row - y) * w + (x0 - x),
+               (size_t)(x1 - x0) * 4);
+    }
+    target.dirtyX = x0;
+    target.dirtyY = y0;
+    target.dirtyW = x1 - x0;
+    target.dirtyH = y1 - y0;
+}
+
+// 与基线比对需要稳定的数字：取若干轮中最快的一轮，排除调度和频率波动（平均值在共享机器上可相差 30%）
+template <typename Fn>
+static double TimeBest(Fn&& fn, double minSeconds) {
+    const int rounds = 5;
+    double best = TimeIt(fn, minSeconds / rounds);
+    for (int i = 1; i < rounds; i++) best = std::min(best, TimeIt(fn, minSeconds / rounds));
+    return best;
+}
+
+static void PipelineImage(int megapixels, std::vector<PipelineResult>* results) {
+    // 3:2 画幅，宽高取偶数
+    int width = ((int)sqrt(megapixels * 1e6 * 1.5) + 1) & ~1;
+    int height = ((int)(width / 1.5) + 1) & ~1;
+    char corpus[16];
+    snprintf(corpus, sizeof(corpus), "%dMP", megapixels);
+    double minSeconds = megapixels >= 36 ? 0.05 : 0.2; // 大图单次就要数百毫秒
+    printf("\npipeline %s (%dx%d)\n", corpus, width, height);
+    printf("%-34s %12s %12s\n", "stage", "ns/px", "fps");
+
+    auto record = [&](const std::string& stage, double seconds, double pixels) {
+        PipelineResult r;
+        r.key = std::string(corpus) + "/" + stage;
+        r.nsPerPixel = seconds * 1e9 / pixels;
+        r.fps = 1.0 / seconds;
+        printf("%-34s %12.3f %12.1f\n", r.key.c_str(), r.nsPerPixel, r.fps);
+        results->push_back(r);
+    };
+
+    std::vector<uint32_t> source = MakeSyntheticImage(width, height);
+    double sourcePixels = (double)width * height;
+
+    // 解码：可移植的解码器只有 QOI（截图格式），作为整图解码的代表
+    std::vector<uint8_t> encoded = EncodeQoi(source.data(), width, height, 4);
+    std::vector<uint32_t> decoded;
+    record("decode/qoi", TimeBest([&] { DecodeQoi(encoded.data(), encoded.size(), &decoded, nullptr); }, minSeconds),
+           sourcePixels);
+    encoded.clear();
+    encoded.shrink_to_fit();
+
+    // mip 链：按最小缩放比例需要的级别冷构建
+    MipChain chain;
+    record("mipmap/build", TimeBest([&] {
+        chain.Reset(decoded.data(), width, height);
+        chain.SelectLevel(std::max(1, width / 4), std::max(1, height / 4));
+    }, minSeconds), sourcePixels);
+
+    // 效果：在第 0 级上分别测单项与组合（输出预乘）
+    struct EffectCase { const char* name; EffectParams params; };
+    const EffectCase effects[] = {
+        { "opacity",      { false, false, 0.5f } },
+        { "grayscale",    { false, true,  1.0f } },
+        { "remove-white", { true,  false, 1.0f } },
+        { "all",          { true,  true,  0.5f } },
+    };
+    std::vector<uint32_t> premultiplied((size_t)width * height);
+    for (const EffectCase& e : effects) {
+        record(std::string("effects/") + e.name, TimeBest([&] {
+            ApplyEffects(decoded.data(), width, premultiplied.data(), width, width, height, e.params);
+        }, minSeconds), sourcePixels);
+    }
+
+    // 缩放：从最近的 mip 级别做双三次重采样（与完整质量的绘制相同）
+    ComposeTarget target;
+    target.pixels.assign((size_t)target.width * target.height, 0);
+    const float scales[] = { 0.25f, 0.5f, 1.0f };
+    std::vector<uint32_t> levelPremultiplied, scaled;
+    for (float scale : scales) {
+        int dw = std::max(1, (int)(width * scale)), dh = std::max(1, (int)(height * scale));
+        int level = chain.SelectLevel(dw, dh);
+        int lw = chain.Width(level), lh = chain.Height(level);
+        levelPremultiplied.resize((size_t)lw * lh);
+        ApplyEffects(chain.Pixels(level), lw, levelPremultiplied.data(), lw, lw, lh, effects[0].params);
+        scaled.resize((size_t)dw * dh);
+        char stage[48];
+        snprintf(stage, sizeof(stage), "resample/x%.2f", scale);
+        record(stage, TimeBest([&] {
+            ResampleImage(levelPremultiplied.data(), lw, lh, lw, scaled.data(), dw, dh, dw, ResampleFilter::Bicubic);
+        }, minSeconds), (double)dw * dh);
+    }
+
+    // 旋转与整帧：缩放 0.5，参数变化后的冷渲染（效果 + 缩放 + 旋转 + 合成）
+    int sw = std::max(1, width / 2), sh = std::max(1, height / 2);
+    int level = chain.SelectLevel(sw, sh);
+    int lw = chain.Width(level), lh = chain.Height(level);
+    levelPremultiplied.resize((size_t)lw * lh);
+    scaled.resize((size_t)sw * sh);
+    ResampleImage(chain.Pixels(level), lw, lh, lw, scaled.data(), sw, sh, sw, ResampleFilter::Bicubic);
+    const int rotations[] = { 0, 10, 45, 90 };
+    std::vector<uint32_t> rotated;
+    for (int degrees : rotations) {
+        int rw = sw, rh = sh;
+        if (degrees % 180 == 90) std::swap(rw, rh);
+        else if (degrees % 90 != 0) RotatedBounds(sw, sh, degrees, &rw, &rh);
+        rotated.resize((size_t)rw * rh);
+        char stage[48];
+        if (degrees != 0) {
+            snprintf(stage, sizeof(stage), "rotate/r%d", degrees);
+            record(stage, TimeBest([&] { RotateStage(scaled.data(), sw, sh, rotated.data(), rw, rh, degrees); },
+                                 minSeconds), (double)rw * rh);
+        }
+        const uint32_t* surface = degrees != 0 ? rotated.data() : scaled.data();
+        snprintf(stage, sizeof(stage), "compose/r%d", degrees);
+        record(stage, TimeBest([&] {
+            ComposeFrame(target, surface, rw, rh, (target.width - rw) / 2, (target.height - rh) / 2);
+        }, minSeconds), (double)rw * rh);
+
+        snprintf(stage, sizeof(stage), "frame/x0.50/r%d", degrees);
+        record(stage, TimeBest([&] {
+            ApplyEffects(chain.Pixels(level), lw, levelPremultiplied.data(), lw, lw, lh, effects[0].params);
+            ResampleImage(levelPremultiplied.data(), lw, lh, lw, scaled.data(), sw, sh, sw, ResampleFilter::Bicubic);
+            if (degrees != 0) RotateStage(scaled.data(), sw, sh, rotated.data(), rw, rh, degrees);
+            ComposeFrame(target, surface, rw, rh, (target.width - rw) / 2, (target.height - rh) / 2);
+        }, minSeconds), (double)rw * rh);
+    }
+}
+
+// 每个结果单独一行，基线读取时按行解析
+static bool WritePipelineJson(const char* path, const std::vector<PipelineResult>& results) {
+    FILE* file = fopen(path, "w");
+    if (!file) return false;
+    fprintf(file, "{\n  \"format\": \"guessdraw-pipeline-1\",\n  \"unit\": \"ns_per_px\",\n  \"results\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        fprintf(file, "    {\"key\": \"%s\", \"ns_per_px\": %.4f, \"fps\": %.2f}%s\n", results[i].key.c_str(),
+                results[i].nsPerPixel, results[i].fps, i + 1 < results.size() ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    return fclose(file) == 0;
+}
+
+static bool ReadPipelineJson(const char* path, std::map<std::string, double>* nsPerPixel) {
+    FILE* file = fopen(path, "r");
+    if (!file) return false;
+    char line[512];
+    while (fgets(line, sizeof(line), file)) {
+        const char* key = strstr(line, "\"key\": \"");
+        const char* value = strstr(line, "\"ns_per_px\": ");
+        if (!key || !value) continue;
+        key += 8;
+        const char* end = strchr(key, '"');
+        if (!end) continue;
+        (*nsPerPixel)[std::string(key, end)] = atof(value + 13);
+    }
+    fclose(file);
+    return true;
+}
+
+// 与基线比对：逐项打印变化，但按阶段（去掉语料前缀，如 "resample/x0.50"）对各尺寸取几何平均后再判定，
+// 单个尺寸上的偶发波动不会误报；阶段整体慢于基线 threshold（比例）以上记为退化。只有一方有的项只提示不计
+static int ComparePipeline(const std::vector<PipelineResult>& results, const std::map<std::string, double>& baseline,
+                           double threshold) {
+    std::map<std::string, std::pair<double, int>> stages; // 阶段 -> (log 比值之和, 项数)
+    printf("\nbaseline comparison\n");
+    for (const PipelineResult& r : results) {
+        auto it = baseline.find(r.key);
+        if (it == baseline.end() || it->second <= 0 || r.nsPerPixel <= 0) {
+            printf("%-34s %12s\n", r.key.c_str(), "new");
+            continue;
+        }
+        double ratio = r.nsPerPixel / it->second;
+        printf("%-34s %+11.1f%%\n", r.key.c_str(), (ratio - 1.0) * 100);
+        auto& stage = stages[r.key.substr(r.key.find('/') + 1)];
+        stage.first += log(ratio);
+        stage.second++;
+    }
+
+    int regressions = 0;
+    printf("\nper stage (geometric mean over corpus, threshold +%.0f%%)\n", threshold * 100);
+    for (const auto& stage : stages) {
+        double change = exp(stage.second.first / stage.second.second) - 1.0;
+        bool regressed = change > threshold;
+        if (regressed) regressions++;
+        printf("%-34s %+11.1f%%%s\n", stage.first.c_str(), change * 100, regressed ? "  REGRESSION" : "");
+    }
+    printf("%d stages compared, %d regressions\n", (int)stages.size(), regressions);
+    return regressions;
+}
+
+static int RunPipeline(int argc, char** argv) {
+    const char* corpus = "quick";
+    const char* jsonPath = nullptr;
+    const char* baselinePath = nullptr;
+    double threshold = 0.15;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--corpus" && i + 1 < argc) corpus = argv[++i];
+        else if (arg == "--json" && i + 1 < argc) jsonPath = argv[++i];
+        else if (arg == "--baseline" && i + 1 < argc) baselinePath = argv[++i];
+        else if (arg == "--threshold" && i + 1 < argc) threshold = atof(argv[++i]) / 100.0;
+        else {
+            fprintf(stderr, "usage: %s --pipeline [--corpus quick|full] [--json out.json] "
+                            "[--baseline baseline.json] [--threshold percent]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    // quick 适合日常比对；full 覆盖到 100 MP，需要约 3 GB 内存
+    std::vector<int> sizes = strcmp(corpus, "full") == 0 ? std::vector<int>{ 1, 4, 16, 36, 100 }
+                                                         : std::vector<int>{ 1, 4, 16 };
+    std::vector<PipelineResult> results;
+    for (int mp : sizes) PipelineImage(mp, &results);
+
+    if (jsonPath && !WritePipelineJson(jsonPath, results)) {
+        fprintf(stderr, "cannot write %s\n", jsonPath);
+        return 2;
+    }
+    if (!baselinePath) return 0;
+    std::map<std::string, double> baseline;
+    if (!ReadPipelineJson(baselinePath, &baseline)) {
+        fprintf(stderr, "cannot read %s\n", baselinePath);
+        return 2;
+    }
+    return ComparePipeline(results, baseline, threshold) == 0 ? 0 : 1;
+}
+
+// ============ 正确性校验（ctest） ============
+// 复用各 Bench* 的校验部分：小尺寸、每项只运行一次，几秒内跑完。不带名称时运行全部
+struct CheckCase {
+    const char* name;
+    int (*run)();
+};
+
+static const CheckCase kChecks[] = {
+    { "effects",   [] { return BenchEffects(640, 480); } },
+    { "resample",  [] { return BenchResample(640, 480); } },
+    { "dirindex",  [] { return BenchDirIndex(500); } },
+    { "diskcache", [] { return BenchDiskCache(640, 480); } },
+    { "qoi",       [] { return BenchQoi(640, 480); } },
+    { "ini",       BenchIni },
+    { "orient",    [] { return BenchOrient(257, 131); } }, // 奇数尺寸，跨越 64 像素块边界
+    { "frametrace", BenchFrameTrace },
+};
+
+static int RunChecks(int argc, char** argv) {
+    s_checkOnly = true;
+    int failures = 0;
+    bool matched = argc <= 2;
+    for (const CheckCase& c : kChecks) {
+        bool selected = argc <= 2;
+        for (int i = 2; i < argc; i++) selected = selected || strcmp(argv[i], c.name) == 0;
+        if (!selected) continue;
+        matched = true;
+        int f = c.run();
+        printf("check %s: %s\n\n", c.name, f == 0 ? "ok" : "FAIL");
+        failures += f;
+    }
+    if (!matched) {
+        fprintf(stderr, "unknown check\n");
+        return 2;
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && strcmp(argv[1], "--pipeline") == 0) return RunPipeline(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "--check") == 0) return RunChecks(argc, argv);
+
+    int width = argc > 1 ? atoi(argv[1]) : 6000;
+    int height = argc > 2 ? atoi(argv[2]) : 4000;
+    if (width <= 0 || height <= 0) {
+        fprintf(stderr, "usage: %s [width] [height]\n       %s --pipeline [options]\n       %s --check [name...]\n",
+                argv[0], argv[0], argv[0]);
+        return 2;
+    }
+    int failures = BenchEffects(width, height);
+    failures += BenchResample(width, height);
+    failures += BenchMipmap(width, height);
+    failures += BenchDirIndex(20000);
+    failures += BenchTiles(width, height);
+    failures += BenchDiskCache(width, height);
+    failures += BenchQoi(width, height);
+    failures += BenchIni();
+    failures += BenchOrient(width, height);
+    failures += BenchFrameTrace();
+    return failures == 0 ? 0 : 1;
+}
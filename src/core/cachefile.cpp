@@ -0,0 +1,269 @@
+#include "cachefile.h"
+#include <algorithm>
+#include <cstring>
+#include <cwctype>
+
+static const uint32_t kBlobMagic = 0x31434447;  // "GDC1"
+static const uint32_t kIndexMagic = 0x49434447; // "GDCI"
+static const uint32_t kFormatVersion = 1;
+
+template <class T>
+static void Put(uint8_t* dst, size_t offset, T value) {
+    memcpy(dst + offset, &value, sizeof(T));
+}
+
+template <class T>
+static T Get(const uint8_t* src, size_t offset) {
+    T value;
+    memcpy(&value, src + offset, sizeof(T));
+    return value;
+}
+
+static void HashBytes(uint64_t* hash, const void* data, size_t bytes) {
+    const uint8_t* p = (const uint8_t*)data;
+    for (size_t i = 0; i < bytes; i++) {
+        *hash ^= p[i];
+        *hash *= 0x100000001B3ull;
+    }
+}
+
+uint64_t CacheKeyHash(const std::wstring& path, uint64_t mtime, uint64_t size) {
+    // FNV-1a；路径按 UTF-16 代码单元参与计算，Windows 与其他平台结果一致
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (wchar_t c : path) {
+        uint16_t unit = (uint16_t)std::towlower(c);
+        HashBytes(&hash, &unit, sizeof(unit));
+    }
+    HashBytes(&hash, &mtime, sizeof(mtime));
+    HashBytes(&hash, &size, sizeof(size));
+    return hash;
+}
+
+std::wstring CacheBlobName(uint64_t keyHash) {
+    static const wchar_t digits[] = L"0123456789abcdef";
+    std::wstring name(16, L'0');
+    for (int i = 15; i >= 0; i--, keyHash >>= 4) name[i] = digits[keyHash & 0xF];
+    return name + L".gdc";
+}
+
+// ============ blob ============
+
+static size_t AlignUp(size_t value) {
+    return (value + kCacheBlobAlign - 1) / kCacheBlobAlign * kCacheBlobAlign;
+}
+
+size_t CacheBlobLevelOffset(int width, int height, int level) {
+    size_t offset = kCacheBlobHeaderBytes;
+    int w = std::max(1, width), h = std::max(1, height);
+    for (int i = 0; i < level; i++) {
+        offset = AlignUp(offset + (size_t)w * h * 4);
+        w = std::max(1, w / 2);
+        h = std::max(1, h / 2);
+    }
+    return offset;
+}
+
+size_t CacheBlobBytes(const CacheBlobInfo& info) {
+    return CacheBlobLevelOffset(info.width, info.height, info.levels);
+}
+
+void FillCacheBlob(const CacheBlobInfo& info, const uint32_t* const* levels, uint8_t* dst) {
+    memset(dst, 0, kCacheBlobHeaderBytes);
+    Put<uint32_t>(dst, 0, kBlobMagic);
+    Put<uint32_t>(dst, 4, kFormatVersion);
+    Put<uint64_t>(dst, 8, info.keyHash);
+    Put<uint64_t>(dst, 16, info.mtime);
+    Put<uint64_t>(dst, 24, info.size);
+    Put<int32_t>(dst, 32, info.width);
+    Put<int32_t>(dst, 36, info.height);
+    Put<int32_t>(dst, 40, info.levels);
+    Put<uint64_t>(dst, 48, (uint64_t)CacheBlobBytes(info));
+
+    int w = info.width, h = info.height;
+    for (int level = 0; level < info.levels; level++) {
+        size_t offset = CacheBlobLevelOffset(info.width, info.height, level);
+        size_t bytes = (size_t)w * h * 4;
+        memcpy(dst + offset, levels[level], bytes);
+        size_t next = CacheBlobLevelOffset(info.width, info.height, level + 1);
+        memset(dst + offset + bytes, 0, next - offset - bytes);
+        w = std::max(1, w / 2);
+        h = std::max(1, h / 2);
+    }
+}
+
+bool ParseCacheBlob(const uint8_t* data, size_t bytes, CacheBlobInfo* info) {
+    if (!data || bytes < kCacheBlobHeaderBytes) return false;
+    if (Get<uint32_t>(data, 0) != kBlobMagic || Get<uint32_t>(data, 4) != kFormatVersion) return false;
+
+    CacheBlobInfo parsed;
+    parsed.keyHash = Get<uint64_t>(data, 8);
+    parsed.mtime = Get<uint64_t>(data, 16);
+    parsed.size = Get<uint64_t>(data, 24);
+    parsed.width = Get<int32_t>(data, 32);
+    parsed.height = Get<int32_t>(data, 36);
+    parsed.levels = Get<int32_t>(data, 40);
+    if (parsed.width <= 0 || parsed.height <= 0 || parsed.width > (1 << 20) || parsed.height > (1 << 20)) return false;
+    if (parsed.levels < 1 || parsed.levels > kCacheBlobMaxLevels) return false;
+
+    // 级别数不能超过 mip 链的实际长度，总字节数必须与文件一致（写入中断的文件在这里被拒绝）
+    int w = parsed.width, h = parsed.height, maxLevels = 1;
+    while (w > 1 || h > 1) {
+        w = std::max(1, w / 2);
+        h = std::max(1, h / 2);
+        maxLevels++;
+    }
+    if (parsed.levels > maxLevels) return false;
+    uint64_t total = Get<uint64_t>(data, 48);
+    if (total != CacheBlobBytes(parsed) || total > bytes) return false;
+
+    *info = parsed;
+    return true;
+}
+
+const uint32_t* CacheBlobLevel(const uint8_t* data, const CacheBlobInfo& info, int level) {
+    if (level < 0 || level >= info.levels) return nullptr;
+    return (const uint32_t*)(data + CacheBlobLevelOffset(info.width, info.height, level));
+}
+
+// ============ 索引 ============
+
+// 路径比较不区分大小写，与 CacheKeyHash 一致
+static bool SamePath(const std::wstring& a, const std::wstring& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (std::towlower(a[i]) != std::towlower(b[i])) return false;
+    }
+    return true;
+}
+
+const DiskCacheEntry* DiskCacheIndex::Find(const std::wstring& path, uint64_t mtime, uint64_t size) {
+    auto it = m_entries.find(CacheKeyHash(path, mtime, size));
+    if (it == m_entries.end()) return nullptr;
+    DiskCacheEntry& e = it->second;
+    if (e.mtime != mtime || e.size != size || !SamePath(e.path, path)) return nullptr; // 哈希碰撞
+    e.lastUse = ++m_clock;
+    return &e;
+}
+
+uint64_t DiskCacheIndex::Insert(const DiskCacheEntry& entry, std::vector<uint64_t>* removed) {
+    uint64_t key = CacheKeyHash(entry.path, entry.mtime, entry.size);
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        if (it->first == key || SamePath(it->second.path, entry.path)) {
+            if (it->first != key) removed->push_back(it->first);
+            m_bytes -= it->second.bytes;
+            it = m_entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    DiskCacheEntry& e = m_entries[key];
+    e = entry;
+    e.lastUse = ++m_clock;
+    m_bytes += e.bytes;
+    return key;
+}
+
+bool DiskCacheIndex::Remove(uint64_t keyHash) {
+    auto it = m_entries.find(keyHash);
+    if (it == m_entries.end()) return false;
+    m_bytes -= it->second.bytes;
+    m_entries.erase(it);
+    return true;
+}
+
+void DiskCacheIndex::Trim(uint64_t capacity, std::vector<uint64_t>* removed) {
+    if (m_bytes <= capacity) return;
+    std::vector<std::pair<uint64_t, uint64_t>> byUse; // (lastUse, key)
+    byUse.reserve(m_entries.size());
+    for (const auto& e : m_entries) byUse.emplace_back(e.second.lastUse, e.first);
+    std::sort(byUse.begin(), byUse.end());
+    for (const auto& u : byUse) {
+        if (m_bytes <= capacity) break;
+        Remove(u.second);
+        removed->push_back(u.second);
+    }
+}
+
+void DiskCacheIndex::Clear() {
+    m_entries.clear();
+    m_bytes = 0;
+    m_clock = 0;
+}
+
+std::vector<uint64_t> DiskCacheIndex::Keys() const {
+    std::vector<uint64_t> keys;
+    keys.reserve(m_entries.size());
+    for (const auto& e : m_entries) keys.push_back(e.first);
+    return keys;
+}
+
+// 索引文件：24 字节文件头（魔数、版本、条目数、逻辑时钟），
+// 每个条目为 mtime、size、bytes、lastUse 各 8 字节 + 路径长度 4 字节 + UTF-16 路径
+std::vector<uint8_t> DiskCacheIndex::Serialize() const {
+    size_t total = 24;
+    for (const auto& e : m_entries) total += 36 + e.second.path.size() * 2;
+    std::vector<uint8_t> out(total);
+    uint8_t* p = out.data();
+    Put<uint32_t>(p, 0, kIndexMagic);
+    Put<uint32_t>(p, 4, kFormatVersion);
+    Put<uint64_t>(p, 8, (uint64_t)m_entries.size());
+    Put<uint64_t>(p, 16, m_clock);
+
+    size_t offset = 24;
+    for (const auto& kv : m_entries) {
+        const DiskCacheEntry& e = kv.second;
+        Put<uint64_t>(p, offset, e.mtime);
+        Put<uint64_t>(p, offset + 8, e.size);
+        Put<uint64_t>(p, offset + 16, e.bytes);
+        Put<uint64_t>(p, offset + 24, e.lastUse);
+        Put<uint32_t>(p, offset + 32, (uint32_t)e.path.size());
+        offset += 36;
+        for (wchar_t c : e.path) {
+            Put<uint16_t>(p, offset, (uint16_t)c);
+            offset += 2;
+        }
+    }
+    return out;
+}
+
+bool DiskCacheIndex::Parse(const uint8_t* data, size_t bytes) {
+    Clear();
+    if (!data || bytes < 24) return false;
+    if (Get<uint32_t>(data, 0) != kIndexMagic || Get<uint32_t>(data, 4) != kFormatVersion) return false;
+    uint64_t count = Get<uint64_t>(data, 8);
+    uint64_t clock = Get<uint64_t>(data, 16);
+
+    size_t offset = 24;
+    for (uint64_t i = 0; i < count; i++) {
+        if (bytes - offset < 36) {
+            Clear();
+            return false;
+        }
+        DiskCacheEntry e;
+        e.mtime = Get<uint64_t>(data, offset);
+        e.size = Get<uint64_t>(data, offset + 8);
+        e.bytes = Get<uint64_t>(data, offset + 16);
+        e.lastUse = Get<uint64_t>(data, offset + 24);
+        uint32_t length = Get<uint32_t>(data, offset + 32);
+        offset += 36;
+        if ((bytes - offset) / 2 < length) {
+            Clear();
+            return false;
+        }
+        e.path.resize(length);
+        for (uint32_t c = 0; c < length; c++) e.path[c] = (wchar_t)Get<uint16_t>(data, offset + c * 2);
+        offset += (size_t)length * 2;
+
+        uint64_t key = CacheKeyHash(e.path, e.mtime, e.size);
+        if (m_entries.count(key)) continue;
+        m_bytes += e.bytes;
+        m_entries[key] = std::move(e);
+    }
+    if (offset != bytes) {
+        Clear();
+        return false;
+    }
+    m_clock = clock;
+    for (const auto& e : m_entries) m_clock = std::max(m_clock, e.second.lastUse);
+    return true;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// ============ 磁盘缓存格式（与 Win32 无关，可在任意平台编译） ============
+// 每张图片一个 blob 文件：64 字节文件头 + 各 mip 级别的直通 alpha 32 位 BGRA 像素，
+// 每级起点按 64 字节对齐，映射文件后可直接作为 MipChain 的各级使用，无需解码或拷贝。
+// 另有一个紧凑的索引文件记录各 blob 对应的 路径 + 修改时间 + 文件大小 以及最近使用顺序，按总大小做 LRU 淘汰
+
+constexpr size_t kCacheBlobHeaderBytes = 64;
+constexpr size_t kCacheBlobAlign = 64;
+constexpr int kCacheBlobMaxLevels = 32;
+
+// 以 路径（不区分大小写）+ 修改时间 + 文件大小 计算缓存键，文件变化后键随之改变
+uint64_t CacheKeyHash(const std::wstring& path, uint64_t mtime, uint64_t size);
+// 缓存键对应的 blob 文件名（16 位十六进制 + .gdc）
+std::wstring CacheBlobName(uint64_t keyHash);
+
+struct CacheBlobInfo {
+    uint64_t keyHash = 0;
+    uint64_t mtime = 0;   // 源文件修改时间
+    uint64_t size = 0;    // 源文件大小
+    int width = 0;        // 第 0 级尺寸
+    int height = 0;
+    int levels = 1;       // 保存的级别数（含第 0 级），各级尺寸与 MipChain 相同
+};
+
+// 第 level 级像素在 blob 中的字节偏移；level == info.levels 时为 blob 总字节数
+size_t CacheBlobLevelOffset(int width, int height, int level);
+size_t CacheBlobBytes(const CacheBlobInfo& info);
+
+// 把文件头和 levels[0..info.levels) 写入 dst（至少 CacheBlobBytes(info) 字节），对齐填充置 0
+void FillCacheBlob(const CacheBlobInfo& info, const uint32_t* const* levels, uint8_t* dst);
+// 校验 blob（魔数、版本、尺寸与总字节数一致），成功时填写 info
+bool ParseCacheBlob(const uint8_t* data, size_t bytes, CacheBlobInfo* info);
+// 已校验的 blob 中第 level 级的像素
+const uint32_t* CacheBlobLevel(const uint8_t* data, const CacheBlobInfo& info, int level);
+
+struct DiskCacheEntry {
+    std::wstring path;    // 源图片完整路径
+    uint64_t mtime = 0;
+    uint64_t size = 0;
+    uint64_t bytes = 0;   // blob 文件大小
+    uint64_t lastUse = 0; // 最近使用的逻辑时钟，越大越新
+};
+
+// 磁盘缓存索引：缓存键 → 条目。本身不加锁，由调用方保证互斥
+class DiskCacheIndex {
+public:
+    // 查找与 路径 + 修改时间 + 文件大小 完全匹配的条目，命中时记为最近使用
+    const DiskCacheEntry* Find(const std::wstring& path, uint64_t mtime, uint64_t size);
+    // 插入或替换条目并记为最近使用；同一路径的旧版本（文件已变化）一并移除，其键追加到 removed
+    uint64_t Insert(const DiskCacheEntry& entry, std::vector<uint64_t>* removed);
+    bool Remove(uint64_t keyHash);
+    bool Contains(uint64_t keyHash) const { return m_entries.count(keyHash) != 0; }
+    // 从最久未用的开始淘汰，直到总大小不超过 capacity；被淘汰的键追加到 removed
+    void Trim(uint64_t capacity, std::vector<uint64_t>* removed);
+    void Clear();
+
+    std::vector<uint64_t> Keys() const;
+    uint64_t Bytes() const { return m_bytes; }
+    size_t Count() const { return m_entries.size(); }
+
+    // 序列化为索引文件内容；路径按 UTF-16 代码单元保存
+    std::vector<uint8_t> Serialize() const;
+    // 解析索引文件，格式不符或数据截断时返回 false 且索引为空
+    bool Parse(const uint8_t* data, size_t bytes);
+
+private:
+    std::map<uint64_t, DiskCacheEntry> m_entries;
+    uint64_t m_bytes = 0;
+    uint64_t m_clock = 0;
+};
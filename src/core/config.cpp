@@ -1,4 +1,5 @@
 #include "globals.h"
+#include "inifile.h"
 
 // ============ 快捷键默认配置（序号对应 HotkeyAction 枚举） ============
 HotkeyBinding g_hotkeys[HK_COUNT] = {
@@ -14,7 +15,10 @@ HotkeyBinding g_hotkeys[HK_COUNT] = {
     { VK_RIGHT,   false, false, false },  // HK_NEXT_IMAGE
     { VK_NUMPAD6, false, false, false },  // HK_ROTATE_CW
     { VK_NUMPAD4, false, false, false },  // HK_ROTATE_CCW
+    { VK_NUMPAD5, false, false, false },  // HK_MIRROR_H
+    { VK_NUMPAD7, false, false, false },  // HK_MIRROR_V
     { VK_F1,      false, false, false },  // HK_SCREENSHOT
+    { VK_F9,      false, false, false },  // HK_TOGGLE_STATS
 };
 
 // 返回快捷键动作的中文名称
@@ -32,7 +36,10 @@ const wchar_t* GetHotkeyActionName(int action) {
         L"下一张图片",
         L"顺时针旋转",
         L"逆时针旋转",
+        L"左右镜像",
+        L"上下镜像",
         L"区域截图",
+        L"帧耗时统计",
     };
     if (action >= 0 && action < HK_COUNT) return names[action];
     return L"未知";
@@ -84,12 +91,81 @@ std::wstring VKeyToString(const HotkeyBinding& hk) {
 }
 
 // ============ 配置读写 ============
-// 配置文件位于 imageDirectory 下的 GuessDraw.ini
+// 配置文件位于图片目录下的 GuessDraw.ini。整个文件读入一次、在内存中读写，保存时整体写回
+static IniDocument s_ini;
+static std::wstring s_iniPath;              // s_ini 对应的文件路径
+static bool s_savePending = false;          // 已安排延迟保存，尚未写盘
+static const UINT_PTR TIMER_SAVE_CONFIG = 0x5C; // 主窗口上的定时器，与截图的 TIMER_CAPTURE 区分
+static const UINT kSaveConfigDelayMs = 500;
+
 const wchar_t* GetConfigPath() {
-    static wchar_t path[MAX_PATH] = {};
-    // 每次基于 imageDirectory 重新拼路径（目录可能被用户修改）
-    swprintf(path, MAX_PATH, L"%ls\\GuessDraw.ini", imageDirectory.c_str());
-    return path;
+    // 只在图片目录变化时重新拼路径
+    static std::wstring dir;
+    static std::wstring path;
+    std::wstring current = GetImageDirectory();
+    if (path.empty() || current != dir) {
+        dir = current;
+        path = dir + L"\\GuessDraw.ini";
+    }
+    return path.c_str();
+}
+
+static bool ReadConfigText(std::wstring* text) {
+    HANDLE file = CreateFileW(GetConfigPath(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING,
+                              FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    std::vector<uint8_t> data;
+    LARGE_INTEGER size;
+    DWORD read = 0;
+    bool ok = GetFileSizeEx(file, &size) && size.QuadPart < 16 * 1024 * 1024;
+    if (ok) {
+        data.resize((size_t)size.QuadPart);
+        ok = data.empty() || (ReadFile(file, data.data(), (DWORD)data.size(), &read, nullptr) && read == data.size());
+    }
+    CloseHandle(file);
+    if (!ok) return false;
+    if (DecodeIniText(data.data(), data.size(), text)) return true;
+
+    // 没有 BOM：旧版本用 WritePrivateProfileString 生成的文件为本地代码页，也可能是手工保存的 UTF-8
+    for (UINT codePage : { (UINT)CP_UTF8, (UINT)CP_ACP }) {
+        DWORD flags = codePage == CP_UTF8 ? MB_ERR_INVALID_CHARS : 0;
+        int length = data.empty() ? 0 : MultiByteToWideChar(codePage, flags, (const char*)data.data(), (int)data.size(), nullptr, 0);
+        if (length <= 0 && !data.empty()) continue;
+        text->resize(length);
+        if (length > 0) MultiByteToWideChar(codePage, flags, (const char*)data.data(), (int)data.size(), text->data(), length);
+        return true;
+    }
+    return false;
+}
+
+// 先写临时文件再替换，写入中途出错也不会留下半个配置文件
+static bool WriteConfigText(const std::wstring& text) {
+    std::vector<uint8_t> data = EncodeIniText(text);
+    std::wstring path = GetConfigPath();
+    std::wstring temp = path + L".tmp";
+    HANDLE file = CreateFileW(temp.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    DWORD written = 0;
+    bool ok = WriteFile(file, data.data(), (DWORD)data.size(), &written, nullptr) && written == data.size();
+    CloseHandle(file);
+    if (ok && MoveFileExW(temp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING)) return true;
+    DeleteFileW(temp.c_str());
+    return false;
+}
+
+const std::wstring& GetLocalDataDirectory() {
+    static const std::wstring dir = [] {
+        wchar_t base[MAX_PATH];
+        if (FAILED(SHGetFolderPathW(nullptr, CSIDL_LOCAL_APPDATA | CSIDL_FLAG_CREATE, nullptr, 0, base))) {
+            return std::wstring();
+        }
+        std::wstring path = std::wstring(base) + L"\\GuessDraw";
+        CreateDirectoryW(path.c_str(), nullptr);
+        DWORD attributes = GetFileAttributesW(path.c_str());
+        if (attributes == INVALID_FILE_ATTRIBUTES || !(attributes & FILE_ATTRIBUTE_DIRECTORY)) return std::wstring();
+        return path;
+    }();
+    return dir;
 }
 
 // INI 中快捷键的键名，序号对应 HotkeyAction
@@ -99,81 +175,135 @@ static const wchar_t* s_hotkeyKeys[] = {
     L"ScaleUp", L"ScaleDown", L"DragModifier",
     L"PrevImage", L"NextImage",
     L"RotateCW", L"RotateCCW",
-    L"Screenshot"
+    L"MirrorH", L"MirrorV",
+    L"Screenshot", L"ToggleStats"
 };
 
 // 从 INI 加载配置，文件不存在则生成默认配置
 void LoadConfig() {
     // 如果配置文件不存在，生成默认配置
-    if (GetFileAttributesW(GetConfigPath()) == INVALID_FILE_ATTRIBUTES) {
+    std::wstring text;
+    s_iniPath = GetConfigPath();
+    if (!ReadConfigText(&text)) {
+        s_ini.Clear();
         SaveConfig();
         return;
     }
-
-    wchar_t buf[MAX_PATH];
+    s_ini.Parse(text);
 
     // [Image]
-    GetPrivateProfileStringW(L"Image", L"Directory", imageDirectory.c_str(), buf, MAX_PATH, GetConfigPath());
-    imageDirectory = buf;
-    GetPrivateProfileStringW(L"Image", L"ImagePath", currentImagePath.c_str(), buf, MAX_PATH, GetConfigPath());
-    currentImagePath = buf;
-
-    opacityFactor = GetPrivateProfileIntW(L"Image", L"Opacity", 50, GetConfigPath()) / 100.0f;
-    scaleFactor   = GetPrivateProfileIntW(L"Image", L"Scale", 50, GetConfigPath()) / 100.0f;
-    grayscaleEnabled = GetPrivateProfileIntW(L"Image", L"Grayscale", 0, GetConfigPath()) != 0;
-    removeWhiteBg    = GetPrivateProfileIntW(L"Image", L"RemoveWhite", 0, GetConfigPath()) != 0;
-    autoLoadLatest   = GetPrivateProfileIntW(L"Image", L"AutoLoad", 1, GetConfigPath()) != 0;
-    rotationAngle    = GetPrivateProfileIntW(L"Image", L"Rotation", 0, GetConfigPath());
+    SetImageDirectory(s_ini.GetString(L"Image", L"Directory", GetImageDirectory()));
+    SetCurrentImagePath(s_ini.GetString(L"Image", L"ImagePath", GetCurrentImagePath()));
+
+    opacityFactor = s_ini.GetInt(L"Image", L"Opacity", 50) / 100.0f;
+    scaleFactor   = s_ini.GetInt(L"Image", L"Scale", 50) / 100.0f;
+    grayscaleEnabled = s_ini.GetInt(L"Image", L"Grayscale", 0) != 0;
+    removeWhiteBg    = s_ini.GetInt(L"Image", L"RemoveWhite", 0) != 0;
+    autoLoadLatest   = s_ini.GetInt(L"Image", L"AutoLoad", 1) != 0;
+    rotationAngle    = s_ini.GetInt(L"Image", L"Rotation", 0);
+    mirrorHorizontal = s_ini.GetInt(L"Image", L"MirrorH", 0) != 0;
+    mirrorVertical   = s_ini.GetInt(L"Image", L"MirrorV", 0) != 0;
+
+    // [Window]
+    fitWindowToImage = s_ini.GetInt(L"Window", L"FitToImage", 1) != 0;
+    targetMonitor    = s_ini.GetInt(L"Window", L"Monitor", 0);
+
+    // [Render]
+    refineDelayMs = s_ini.GetInt(L"Render", L"RefineDelayMs", 150);
+
+    // [Cache]
+    prefetchCount = s_ini.GetInt(L"Cache", L"PrefetchCount", 2);
+    cacheMemoryMB = s_ini.GetInt(L"Cache", L"MemoryMB", 768);
+    tileMemoryMB  = s_ini.GetInt(L"Cache", L"TileMemoryMB", 256);
+    diskCacheMB   = s_ini.GetInt(L"Cache", L"DiskCacheMB", 1024);
+
+    // [Screenshot]
+    screenshotFormat = s_ini.GetInt(L"Screenshot", L"Format", 0);
+    pngCompression   = s_ini.GetInt(L"Screenshot", L"PngCompression", 2);
 
     // [Hotkeys]
     for (int i = 0; i < HK_COUNT; i++) {
-        g_hotkeys[i].vkey  = GetPrivateProfileIntW(L"Hotkeys", s_hotkeyKeys[i], g_hotkeys[i].vkey, GetConfigPath());
-        wchar_t modKey[64];
-        swprintf(modKey, 64, L"%ls_Mod", s_hotkeyKeys[i]);
-        int mod = GetPrivateProfileIntW(L"Hotkeys", modKey, 0, GetConfigPath());
+        g_hotkeys[i].vkey = s_ini.GetInt(L"Hotkeys", s_hotkeyKeys[i], g_hotkeys[i].vkey);
+        int mod = s_ini.GetInt(L"Hotkeys", std::wstring(s_hotkeyKeys[i]) + L"_Mod", 0);
         g_hotkeys[i].ctrl  = (mod & 1) != 0;  // bit0=Ctrl
         g_hotkeys[i].shift = (mod & 2) != 0;  // bit1=Shift
         g_hotkeys[i].alt   = (mod & 4) != 0;  // bit2=Alt
     }
 
     // [Drag]
-    g_dragMouseButton = GetPrivateProfileIntW(L"Drag", L"MouseButton", VK_LBUTTON, GetConfigPath());
+    g_dragMouseButton = s_ini.GetInt(L"Drag", L"MouseButton", VK_LBUTTON);
 }
 
-// 将当前全局状态写入 INI 文件
+// 将当前全局状态写入 INI 文件（其余键和注释保持原样）
 void SaveConfig() {
-    wchar_t buf[MAX_PATH];
+    if (s_savePending) {
+        s_savePending = false;
+        if (g_hwndMain) KillTimer(g_hwndMain, TIMER_SAVE_CONFIG);
+    }
+
+    // 图片目录改变后配置路径随之改变：目标位置已有配置文件时先读入，在它的基础上写入当前设置，
+    // 否则整体写回会丢掉那个文件里的注释、未知键和其他节
+    if (s_iniPath != GetConfigPath()) {
+        std::wstring text;
+        if (ReadConfigText(&text)) s_ini.Parse(text);
+        s_iniPath = GetConfigPath();
+    }
 
     // [Image]
-    WritePrivateProfileStringW(L"Image", L"Directory", imageDirectory.c_str(), GetConfigPath());
-    WritePrivateProfileStringW(L"Image", L"ImagePath", currentImagePath.c_str(), GetConfigPath());
-
-    swprintf(buf, MAX_PATH, L"%d", (int)(opacityFactor * 100));
-    WritePrivateProfileStringW(L"Image", L"Opacity", buf, GetConfigPath());
-    swprintf(buf, MAX_PATH, L"%d", (int)(scaleFactor * 100));
-    WritePrivateProfileStringW(L"Image", L"Scale", buf, GetConfigPath());
-    swprintf(buf, MAX_PATH, L"%d", (int)grayscaleEnabled.load());
-    WritePrivateProfileStringW(L"Image", L"Grayscale", buf, GetConfigPath());
-    swprintf(buf, MAX_PATH, L"%d", (int)removeWhiteBg.load());
-    WritePrivateProfileStringW(L"Image", L"RemoveWhite", buf, GetConfigPath());
-    swprintf(buf, MAX_PATH, L"%d", (int)autoLoadLatest.load());
-    WritePrivateProfileStringW(L"Image", L"AutoLoad", buf, GetConfigPath());
-    swprintf(buf, MAX_PATH, L"%d", rotationAngle.load());
-    WritePrivateProfileStringW(L"Image", L"Rotation", buf, GetConfigPath());
+    s_ini.Set(L"Image", L"Directory", GetImageDirectory());
+    s_ini.Set(L"Image", L"ImagePath", GetCurrentImagePath());
+    s_ini.SetInt(L"Image", L"Opacity", (int)(opacityFactor * 100));
+    s_ini.SetInt(L"Image", L"Scale", (int)(scaleFactor * 100));
+    s_ini.SetInt(L"Image", L"Grayscale", (int)grayscaleEnabled.load());
+    s_ini.SetInt(L"Image", L"RemoveWhite", (int)removeWhiteBg.load());
+    s_ini.SetInt(L"Image", L"AutoLoad", (int)autoLoadLatest.load());
+    s_ini.SetInt(L"Image", L"Rotation", rotationAngle.load());
+    s_ini.SetInt(L"Image", L"MirrorH", (int)mirrorHorizontal.load());
+    s_ini.SetInt(L"Image", L"MirrorV", (int)mirrorVertical.load());
+
+    // [Window]
+    s_ini.SetInt(L"Window", L"FitToImage", (int)fitWindowToImage.load());
+    s_ini.SetInt(L"Window", L"Monitor", targetMonitor.load());
+
+    // [Render]
+    s_ini.SetInt(L"Render", L"RefineDelayMs", refineDelayMs.load());
+
+    // [Cache]
+    s_ini.SetInt(L"Cache", L"PrefetchCount", prefetchCount.load());
+    s_ini.SetInt(L"Cache", L"MemoryMB", cacheMemoryMB.load());
+    s_ini.SetInt(L"Cache", L"TileMemoryMB", tileMemoryMB.load());
+    s_ini.SetInt(L"Cache", L"DiskCacheMB", diskCacheMB.load());
+
+    // [Screenshot]
+    s_ini.SetInt(L"Screenshot", L"Format", screenshotFormat.load());
+    s_ini.SetInt(L"Screenshot", L"PngCompression", pngCompression.load());
 
     // [Hotkeys]
     for (int i = 0; i < HK_COUNT; i++) {
-        swprintf(buf, MAX_PATH, L"%d", g_hotkeys[i].vkey);
-        WritePrivateProfileStringW(L"Hotkeys", s_hotkeyKeys[i], buf, GetConfigPath());
-
-        wchar_t modKey[64];
-        swprintf(modKey, 64, L"%ls_Mod", s_hotkeyKeys[i]);
+        s_ini.SetInt(L"Hotkeys", s_hotkeyKeys[i], g_hotkeys[i].vkey);
         int mod = (g_hotkeys[i].ctrl ? 1 : 0) | (g_hotkeys[i].shift ? 2 : 0) | (g_hotkeys[i].alt ? 4 : 0);
-        swprintf(buf, MAX_PATH, L"%d", mod);
-        WritePrivateProfileStringW(L"Hotkeys", modKey, buf, GetConfigPath());
+        s_ini.SetInt(L"Hotkeys", std::wstring(s_hotkeyKeys[i]) + L"_Mod", mod);
     }
 
     // [Drag]
-    swprintf(buf, MAX_PATH, L"%d", g_dragMouseButton.load());
-    WritePrivateProfileStringW(L"Drag", L"MouseButton", buf, GetConfigPath());
+    s_ini.SetInt(L"Drag", L"MouseButton", g_dragMouseButton.load());
+
+    WriteConfigText(s_ini.Serialize());
+}
+
+void RequestSaveConfig() {
+    if (!g_hwndMain) {
+        SaveConfig();
+        return;
+    }
+    // 重设同一个定时器即推迟到最后一次修改之后，连续修改只写一次盘
+    s_savePending = true;
+    SetTimer(g_hwndMain, TIMER_SAVE_CONFIG, kSaveConfigDelayMs, [](HWND hwnd, UINT, UINT_PTR id, DWORD) {
+        KillTimer(hwnd, id);
+        SaveConfig();
+    });
+}
+
+void FlushConfig() {
+    if (s_savePending) SaveConfig();
 }
@@ -0,0 +1,84 @@
+#include "dirindex.h"
+#include <cwctype>
+
+bool DirectoryIndex::IsImageName(const std::wstring& name) {
+    size_t dot = name.find_last_of(L'.');
+    if (dot == std::wstring::npos) return false;
+    std::wstring ext = name.substr(dot);
+    for (wchar_t& c : ext) c = (wchar_t)towlower(c);
+    return ext == L".jpg" || ext == L".jpeg" || ext == L".png" || ext == L".bmp" ||
+           ext == L".gif" || ext == L".tiff" || ext == L".tif" || ext == L".ico" || ext == L".webp" ||
+           ext == L".qoi";
+}
+
+void DirectoryIndex::Reset(const std::vector<DirectoryEntry>& entries) {
+    m_byName.clear();
+    m_byTime.clear();
+    for (const DirectoryEntry& e : entries) {
+        if (!IsImageName(e.name)) continue;
+        auto [it, inserted] = m_byName.emplace(e.name, e.mtime);
+        if (!inserted) {
+            m_byTime.erase({ it->second, e.name });
+            it->second = e.mtime;
+        }
+        m_byTime.emplace(e.mtime, e.name);
+    }
+    m_version++;
+}
+
+void DirectoryIndex::Clear() {
+    m_byName.clear();
+    m_byTime.clear();
+    m_version++;
+}
+
+bool DirectoryIndex::Upsert(const std::wstring& name, int64_t mtime) {
+    if (!IsImageName(name)) return false;
+    auto it = m_byName.find(name);
+    if (it != m_byName.end()) {
+        if (it->second == mtime) return false;
+        m_byTime.erase({ it->second, name });
+        it->second = mtime;
+    } else {
+        m_byName.emplace(name, mtime);
+    }
+    m_byTime.emplace(mtime, name);
+    m_version++;
+    return true;
+}
+
+bool DirectoryIndex::Remove(const std::wstring& name) {
+    auto it = m_byName.find(name);
+    if (it == m_byName.end()) return false;
+    m_byTime.erase({ it->second, name });
+    m_byName.erase(it);
+    m_version++;
+    return true;
+}
+
+bool DirectoryIndex::Latest(DirectoryEntry* out) const {
+    if (m_byTime.empty()) return false;
+    const auto& last = *m_byTime.rbegin();
+    out->name = last.second;
+    out->mtime = last.first;
+    return true;
+}
+
+bool DirectoryIndex::Neighbor(const std::wstring& current, int direction, std::wstring* out) const {
+    if (m_byName.empty()) return false;
+
+    auto it = m_byName.find(current);
+    if (it == m_byName.end()) {
+        *out = direction > 0 ? m_byName.begin()->first : m_byName.rbegin()->first;
+        return true;
+    }
+    if (direction > 0) {
+        ++it;
+        if (it == m_byName.end()) it = m_byName.begin();
+    } else {
+        if (it == m_byName.begin()) it = m_byName.end();
+        --it;
+    }
+    *out = it->first;
+    return true;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+// ============ 图片目录索引（与 Win32 无关，可在任意平台编译） ============
+// 同时维护 文件名→修改时间 的有序映射和按修改时间排序的集合：
+// 取最新图片 O(1)，按文件名切换上/下一张、单个文件的增删改 O(log n)
+// 本身不加锁，由调用方保证线程安全
+
+struct DirectoryEntry {
+    std::wstring name;  // 文件名（不含目录）
+    int64_t mtime = 0;  // 修改时间，单位由调用方决定，只用于比较
+};
+
+class DirectoryIndex {
+public:
+    // 按扩展名判断是否为支持的图片格式（不区分大小写）
+    static bool IsImageName(const std::wstring& name);
+
+    // 用完整扫描结果重建索引（首次扫描或变更通知溢出后），非图片文件会被忽略
+    void Reset(const std::vector<DirectoryEntry>& entries);
+    void Clear();
+
+    // 新增或修改文件；非图片文件忽略。返回索引是否发生变化
+    bool Upsert(const std::wstring& name, int64_t mtime);
+    // 删除文件，返回索引是否发生变化
+    bool Remove(const std::wstring& name);
+
+    // 修改时间最新的图片（时间相同取文件名较大者），索引为空时返回 false
+    bool Latest(DirectoryEntry* out) const;
+
+    // 按文件名排序的上/下一张（首尾循环）
+    // current 不在索引中时，direction > 0 返回第一张，否则返回最后一张
+    bool Neighbor(const std::wstring& current, int direction, std::wstring* out) const;
+
+    size_t Size() const { return m_byName.size(); }
+    uint64_t Version() const { return m_version; } // 每次变化递增
+
+private:
+    std::map<std::wstring, int64_t> m_byName;
+    std::set<std::pair<int64_t, std::wstring>> m_byTime;
+    uint64_t m_version = 0;
+};
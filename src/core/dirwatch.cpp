@@ -0,0 +1,205 @@
+#include "dirwatch.h"
+#include "dirindex.h"
+#include "globals.h"
+#include "render.h"
+#include "frametrace.h"
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+static std::mutex s_indexMutex;              // 保护 s_index
+static DirectoryIndex s_index;
+
+static std::mutex s_controlMutex;            // 保护监视线程的启动/停止
+static std::wstring s_watchDir;
+static std::thread s_watchThread;
+static HANDLE s_stopEvent = nullptr;
+static std::atomic<bool> s_watchActive(false); // 监视正常运行，索引可直接信任
+
+static std::wstring JoinPath(const std::wstring& dir, const std::wstring& name) {
+    if (!dir.empty() && (dir.back() == L'\\' || dir.back() == L'/')) return dir + name;
+    return dir + L"\\" + name;
+}
+
+static int64_t FileTimeToInt(const FILETIME& ft) {
+    return (int64_t)(((ULONGLONG)ft.dwHighDateTime << 32) | ft.dwLowDateTime);
+}
+
+// 最新图片是否与 before 不同
+static bool LatestChanged(const DirectoryEntry& before, bool hadBefore) {
+    DirectoryEntry now;
+    bool hasNow = s_index.Latest(&now);
+    return hasNow != hadBefore || (hasNow && (now.name != before.name || now.mtime != before.mtime));
+}
+
+// 完整扫描目录并重建索引，返回最新图片是否变化
+static bool RescanDirectory(const std::wstring& dir) {
+    ScopedTraceStage trace(TRACE_SCAN);
+    std::vector<DirectoryEntry> entries;
+    WIN32_FIND_DATAW fd;
+    HANDLE find = FindFirstFileExW(JoinPath(dir, L"*").c_str(), FindExInfoBasic, &fd,
+                                   FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH);
+    if (find != INVALID_HANDLE_VALUE) {
+        do {
+            if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) continue;
+            entries.push_back({ fd.cFileName, FileTimeToInt(fd.ftLastWriteTime) });
+        } while (FindNextFileW(find, &fd));
+        FindClose(find);
+    }
+
+    std::lock_guard<std::mutex> lock(s_indexMutex);
+    DirectoryEntry before;
+    bool hadBefore = s_index.Latest(&before);
+    s_index.Reset(entries);
+    return LatestChanged(before, hadBefore);
+}
+
+// 应用一批变更通知，返回最新图片是否变化
+static bool ApplyNotifications(const std::wstring& dir, const BYTE* buffer) {
+    ScopedTraceStage trace(TRACE_SCAN);
+    struct Change { std::wstring name; bool exists; int64_t mtime; };
+    std::vector<Change> changes;
+
+    // 先在锁外查询文件属性，再一次性更新索引
+    const FILE_NOTIFY_INFORMATION* info = (const FILE_NOTIFY_INFORMATION*)buffer;
+    while (true) {
+        Change c;
+        c.name.assign(info->FileName, info->FileNameLength / sizeof(WCHAR));
+        c.exists = false;
+        c.mtime = 0;
+        if (info->Action == FILE_ACTION_ADDED || info->Action == FILE_ACTION_MODIFIED ||
+            info->Action == FILE_ACTION_RENAMED_NEW_NAME) {
+            WIN32_FILE_ATTRIBUTE_DATA fad;
+            if (GetFileAttributesExW(JoinPath(dir, c.name).c_str(), GetFileExInfoStandard, &fad) &&
+                !(fad.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+                c.exists = true;
+                c.mtime = FileTimeToInt(fad.ftLastWriteTime);
+            }
+        }
+        if (DirectoryIndex::IsImageName(c.name)) changes.push_back(std::move(c));
+        if (info->NextEntryOffset == 0) break;
+        info = (const FILE_NOTIFY_INFORMATION*)((const BYTE*)info + info->NextEntryOffset);
+    }
+
+    std::lock_guard<std::mutex> lock(s_indexMutex);
+    DirectoryEntry before;
+    bool hadBefore = s_index.Latest(&before);
+    for (const Change& c : changes) {
+        if (c.exists) s_index.Upsert(c.name, c.mtime);
+        else s_index.Remove(c.name);
+    }
+    return LatestChanged(before, hadBefore);
+}
+
+// 监视线程：先挂起第一次 ReadDirectoryChangesW 再做初始扫描，保证两者之间的变化不会丢失
+static void WatchThread(std::wstring dir, HANDLE stopEvent, std::promise<bool> ready) {
+    HANDLE hDir = CreateFileW(dir.c_str(), FILE_LIST_DIRECTORY,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                              OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+    OVERLAPPED ov = {};
+    ov.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    std::vector<DWORD> buffer(16 * 1024); // 64KB，DWORD 对齐
+    const DWORD filter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE;
+
+    auto issueRead = [&]() {
+        return ReadDirectoryChangesW(hDir, buffer.data(), (DWORD)(buffer.size() * sizeof(DWORD)), FALSE,
+                                     filter, nullptr, &ov, nullptr) != 0;
+    };
+
+    bool ok = hDir != INVALID_HANDLE_VALUE && ov.hEvent && issueRead();
+    RescanDirectory(dir);
+    // 先于 set_value 写入：线程随后立即失败时置的 false 不会被调用方覆盖
+    s_watchActive = ok;
+    ready.set_value(ok);
+
+    if (ok) {
+        HANDLE handles[2] = { ov.hEvent, stopEvent };
+        while (WaitForMultipleObjects(2, handles, FALSE, INFINITE) == WAIT_OBJECT_0) {
+            DWORD bytes = 0;
+            if (!GetOverlappedResult(hDir, &ov, &bytes, FALSE)) break; // 目录被删除等
+
+            // bytes 为 0 表示缓冲区溢出、事件已丢失，只能完整重扫
+            bool changed = bytes == 0 ? RescanDirectory(dir)
+                                      : ApplyNotifications(dir, (const BYTE*)buffer.data());
+            if (changed && autoLoadLatest) RequestRender(); // 自动加载模式下重绘时会切换到新图片
+            if (!issueRead()) break;
+        }
+        s_watchActive = false;
+
+        // 取消挂起的请求并等待其完成，之后才能释放缓冲区
+        DWORD bytes = 0;
+        CancelIoEx(hDir, &ov);
+        GetOverlappedResult(hDir, &ov, &bytes, TRUE);
+    }
+
+    if (ov.hEvent) CloseHandle(ov.hEvent);
+    if (hDir != INVALID_HANDLE_VALUE) CloseHandle(hDir);
+}
+
+// 调用方持有 s_controlMutex
+static void StopWatcherLocked() {
+    if (s_watchThread.joinable()) {
+        SetEvent(s_stopEvent);
+        s_watchThread.join();
+    }
+    if (s_stopEvent) {
+        CloseHandle(s_stopEvent);
+        s_stopEvent = nullptr;
+    }
+    s_watchActive = false;
+    s_watchDir.clear();
+}
+
+// 确保正在监视 dir；监视不可用时（如部分网络盘）退回每次查询完整扫描
+static void EnsureWatching(const std::wstring& dir) {
+    std::lock_guard<std::mutex> lock(s_controlMutex);
+    if (s_watchThread.joinable() && s_watchDir == dir) {
+        if (!s_watchActive) RescanDirectory(dir);
+        return;
+    }
+
+    StopWatcherLocked();
+    s_watchDir = dir;
+    s_stopEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    std::promise<bool> ready;
+    std::future<bool> started = ready.get_future();
+    s_watchThread = std::thread(WatchThread, dir, s_stopEvent, std::move(ready));
+    started.wait(); // 等待初始扫描完成，首次查询即可得到结果；s_watchActive 由监视线程设置
+}
+
+bool QueryLatestImage(const std::wstring& dir, std::wstring* path, int64_t* mtime) {
+    EnsureWatching(dir);
+    DirectoryEntry latest;
+    {
+        std::lock_guard<std::mutex> lock(s_indexMutex);
+        if (!s_index.Latest(&latest)) return false;
+    }
+    *path = JoinPath(dir, latest.name);
+    if (mtime) *mtime = latest.mtime;
+    return true;
+}
+
+bool QueryNeighborImage(const std::wstring& dir, const std::wstring& current, int direction, std::wstring* path) {
+    EnsureWatching(dir);
+
+    // 当前图片不在该目录下时按“不在索引中”处理
+    std::wstring prefix = JoinPath(dir, L"");
+    std::wstring name;
+    if (current.size() > prefix.size() && current.compare(0, prefix.size(), prefix) == 0) {
+        name = current.substr(prefix.size());
+    }
+
+    std::wstring neighbor;
+    {
+        std::lock_guard<std::mutex> lock(s_indexMutex);
+        if (!s_index.Neighbor(name, direction, &neighbor)) return false;
+    }
+    *path = JoinPath(dir, neighbor);
+    return true;
+}
+
+void StopDirectoryWatcher() {
+    std::lock_guard<std::mutex> lock(s_controlMutex);
+    StopWatcherLocked();
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <windows.h>
+#include <cstdint>
+#include <string>
+
+// ============ 图片目录监视 ============
+// 后台线程通过 ReadDirectoryChangesW 增量维护目录索引，查询直接读内存，不再遍历目录
+// 目录变化时自动切换监视对象；自动加载模式下最新图片变化时请求重绘
+
+// 目录中修改时间最新的图片（完整路径），mtime 为 FILETIME 计数
+bool QueryLatestImage(const std::wstring& dir, std::wstring* path, int64_t* mtime);
+// 按文件名排序的上/下一张图片（完整路径，首尾循环）
+bool QueryNeighborImage(const std::wstring& dir, const std::wstring& current, int direction, std::wstring* path);
+// 退出前停止监视线程
+void StopDirectoryWatcher();
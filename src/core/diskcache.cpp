@@ -0,0 +1,235 @@
+#include "diskcache.h"
+#include "cachefile.h"
+#include "globals.h"
+#include <algorithm>
+#include <mutex>
+#include <set>
+
+static std::mutex s_diskMutex;                // 保护以下全部状态
+static DiskCacheIndex s_diskIndex;
+static std::wstring s_diskDir;                // 缓存目录（末尾带反斜杠），为空表示不可用
+static bool s_diskOpened = false;
+static bool s_indexDirty = false;             // 最近使用顺序有变化，尚未写回索引文件
+
+// 只读映射整个 blob；映射建立后即可关闭文件与映射句柄，视图本身保持映射有效
+struct MappedCacheBlob {
+    const uint8_t* view = nullptr;
+    size_t bytes = 0;
+
+    ~MappedCacheBlob() {
+        if (view) UnmapViewOfFile(view);
+    }
+};
+
+static uint64_t DiskCapacity() {
+    return (uint64_t)std::max(0, diskCacheMB.load()) * 1024 * 1024;
+}
+
+static std::wstring BlobPath(uint64_t keyHash) {
+    return s_diskDir + CacheBlobName(keyHash);
+}
+
+static bool ReadWholeFile(const std::wstring& path, std::vector<uint8_t>* data) {
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER size;
+    bool ok = GetFileSizeEx(file, &size) && size.QuadPart < 64 * 1024 * 1024;
+    DWORD read = 0;
+    if (ok) {
+        data->resize((size_t)size.QuadPart);
+        ok = data->empty() || (ReadFile(file, data->data(), (DWORD)data->size(), &read, nullptr) && read == data->size());
+    }
+    CloseHandle(file);
+    return ok;
+}
+
+// 先写临时文件再替换，中途崩溃不会留下半个索引
+static void SaveIndexLocked() {
+    std::vector<uint8_t> data = s_diskIndex.Serialize();
+    std::wstring path = s_diskDir + L"index.bin";
+    std::wstring temp = path + L".tmp";
+    HANDLE file = CreateFileW(temp.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return;
+    DWORD written = 0;
+    bool ok = WriteFile(file, data.data(), (DWORD)data.size(), &written, nullptr) && written == data.size();
+    CloseHandle(file);
+    if (ok && MoveFileExW(temp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+        s_indexDirty = false;
+    } else {
+        DeleteFileW(temp.c_str());
+    }
+}
+
+static void DeleteBlobs(const std::vector<uint64_t>& keys) {
+    for (uint64_t key : keys) DeleteFileW(BlobPath(key).c_str());
+}
+
+// 首次使用时定位缓存目录并载入索引；索引与目录内容不一致（崩溃、手动删除）时以两者交集为准
+static bool OpenDiskCacheLocked() {
+    if (s_diskOpened) return !s_diskDir.empty();
+    s_diskOpened = true;
+
+    if (GetLocalDataDirectory().empty()) return false;
+    std::wstring dir = GetLocalDataDirectory() + L"\\ImageCache";
+    CreateDirectoryW(dir.c_str(), nullptr);
+    DWORD attributes = GetFileAttributesW(dir.c_str());
+    if (attributes == INVALID_FILE_ATTRIBUTES || !(attributes & FILE_ATTRIBUTE_DIRECTORY)) return false;
+    s_diskDir = dir + L"\\";
+
+    std::vector<uint8_t> data;
+    if (ReadWholeFile(s_diskDir + L"index.bin", &data)) s_diskIndex.Parse(data.data(), data.size());
+
+    std::set<std::wstring> onDisk;
+    WIN32_FIND_DATAW fd;
+    HANDLE find = FindFirstFileW((s_diskDir + L"*").c_str(), &fd);
+    if (find != INVALID_HANDLE_VALUE) {
+        do {
+            if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) continue;
+            std::wstring name = fd.cFileName;
+            if (name == L"index.bin") continue;
+            onDisk.insert(name);
+        } while (FindNextFileW(find, &fd));
+        FindClose(find);
+    }
+
+    std::set<std::wstring> indexed;
+    for (uint64_t key : s_diskIndex.Keys()) {
+        std::wstring name = CacheBlobName(key);
+        if (onDisk.count(name)) {
+            indexed.insert(name);
+        } else {
+            s_diskIndex.Remove(key);
+            s_indexDirty = true;
+        }
+    }
+    for (const std::wstring& name : onDisk) {
+        if (!indexed.count(name)) DeleteFileW((s_diskDir + name).c_str()); // 孤立的 blob 与写入中断的临时文件
+    }
+
+    std::vector<uint64_t> evicted;
+    s_diskIndex.Trim(DiskCapacity(), &evicted); // 上限可能已调小
+    DeleteBlobs(evicted);
+    if (!evicted.empty()) s_indexDirty = true;
+    if (s_indexDirty) SaveIndexLocked();
+    return true;
+}
+
+static std::shared_ptr<MappedCacheBlob> MapBlob(const std::wstring& path) {
+    // 允许删除：映射期间被淘汰的 blob 会在映射关闭后才真正消失
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return nullptr;
+    LARGE_INTEGER size;
+    HANDLE mapping = nullptr;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+        mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    }
+    CloseHandle(file);
+    if (!mapping) return nullptr;
+
+    auto blob = std::make_shared<MappedCacheBlob>();
+    blob->view = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    blob->bytes = (size_t)size.QuadPart;
+    CloseHandle(mapping);
+    return blob->view ? blob : nullptr;
+}
+
+std::shared_ptr<DecodedImage> LoadCachedImage(const std::wstring& path, ULONGLONG mtime, ULONGLONG size) {
+    std::lock_guard<std::mutex> lock(s_diskMutex);
+    if (DiskCapacity() == 0 || !OpenDiskCacheLocked()) return nullptr;
+    if (!s_diskIndex.Find(path, mtime, size)) return nullptr;
+    s_indexDirty = true;
+
+    uint64_t key = CacheKeyHash(path, mtime, size);
+    std::shared_ptr<MappedCacheBlob> blob = MapBlob(BlobPath(key));
+    CacheBlobInfo info;
+    if (!blob || !ParseCacheBlob(blob->view, blob->bytes, &info) ||
+        info.keyHash != key || info.mtime != mtime || info.size != size) {
+        // 文件被截断或被改写：作废这一项
+        blob.reset();
+        s_diskIndex.Remove(key);
+        DeleteFileW(BlobPath(key).c_str());
+        SaveIndexLocked();
+        return nullptr;
+    }
+
+    auto image = std::make_shared<DecodedImage>();
+    image->path = path;
+    image->mtime = mtime;
+    image->size = size;
+    image->generation = NewImageGeneration();
+    image->width = info.width;
+    image->height = info.height;
+    image->bytes = (size_t)info.width * info.height * 4 * 4 / 3; // 与解码结果的计量方式一致
+    image->mips.Reset(CacheBlobLevel(blob->view, info, 0), info.width, info.height);
+    for (int level = 1; level < info.levels; level++) {
+        int w = image->mips.Width(level - 1), h = image->mips.Height(level - 1);
+        image->mips.AdoptLevel(CacheBlobLevel(blob->view, info, level), std::max(1, w / 2), std::max(1, h / 2));
+    }
+    image->mapped = std::move(blob);
+    return image;
+}
+
+// 通过可写映射填充临时文件，成功后改名为正式 blob
+static bool WriteBlobFile(const std::wstring& path, const CacheBlobInfo& info, const std::vector<const uint32_t*>& levels) {
+    std::wstring temp = path + L".tmp";
+    HANDLE file = CreateFileW(temp.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER bytes;
+    bytes.QuadPart = (LONGLONG)CacheBlobBytes(info);
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READWRITE, (DWORD)(bytes.QuadPart >> 32),
+                                        (DWORD)(bytes.QuadPart & 0xFFFFFFFF), nullptr);
+    uint8_t* view = mapping ? (uint8_t*)MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, 0) : nullptr;
+    if (view) {
+        FillCacheBlob(info, levels.data(), view);
+        UnmapViewOfFile(view);
+    }
+    if (mapping) CloseHandle(mapping);
+    CloseHandle(file);
+
+    if (!view || !MoveFileExW(temp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+        DeleteFileW(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+void StoreCachedImage(const DecodedImage& image, const std::vector<const uint32_t*>& levels) {
+    if (image.tiled || image.mapped || levels.empty()) return;
+
+    std::lock_guard<std::mutex> lock(s_diskMutex);
+    uint64_t capacity = DiskCapacity();
+    if (capacity == 0 || !OpenDiskCacheLocked()) return;
+
+    CacheBlobInfo info;
+    info.keyHash = CacheKeyHash(image.path, image.mtime, image.size);
+    info.mtime = image.mtime;
+    info.size = image.size;
+    info.width = image.width;
+    info.height = image.height;
+    info.levels = std::min((int)levels.size(), kCacheBlobMaxLevels);
+    uint64_t bytes = CacheBlobBytes(info);
+    if (bytes > capacity / 2) return; // 单张占去一半以上的上限，缓存它只会挤掉其余所有图片
+    if (s_diskIndex.Contains(info.keyHash)) return;
+
+    if (!WriteBlobFile(BlobPath(info.keyHash), info, levels)) return;
+
+    DiskCacheEntry entry;
+    entry.path = image.path;
+    entry.mtime = image.mtime;
+    entry.size = image.size;
+    entry.bytes = bytes;
+    std::vector<uint64_t> evicted;
+    s_diskIndex.Insert(entry, &evicted); // 同一文件的旧版本
+    s_diskIndex.Trim(capacity, &evicted);
+    DeleteBlobs(evicted);
+    SaveIndexLocked();
+}
+
+void StopDiskCache() {
+    std::lock_guard<std::mutex> lock(s_diskMutex);
+    if (!s_diskDir.empty() && s_indexDirty) SaveIndexLocked();
+}
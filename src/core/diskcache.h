@@ -0,0 +1,21 @@
+#pragma once
+
+#include <windows.h>
+#include "imagecache.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// ============ 磁盘解码缓存 ============
+// 解码结果（含已构建的 mip 级别）以原始 BGRA 保存在 %LOCALAPPDATA%\GuessDraw\ImageCache，
+// 以 路径 + 修改时间 + 文件大小 为键。重新打开程序或再次浏览时直接映射文件，像素就地作为 mip 链使用，
+// 不解码也不拷贝；总大小受 [Cache] DiskCacheMB 约束，按最近使用淘汰。格式见 cachefile.h
+// 只由解码线程调用
+
+// 命中时返回以文件映射为像素的图片，未命中、缓存关闭或文件损坏时返回 nullptr
+std::shared_ptr<DecodedImage> LoadCachedImage(const std::wstring& path, ULONGLONG mtime, ULONGLONG size);
+// 把新解码的图片写入缓存；levels 为已构建各级的像素（须在图片放入内存缓存前取得），超大图片不写入
+void StoreCachedImage(const DecodedImage& image, const std::vector<const uint32_t*>& levels);
+// 退出前保存索引（须在 StopImageCache 之后调用）
+void StopDiskCache();
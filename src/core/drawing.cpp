@@ -1,258 +1,750 @@
 #include "drawing.h"
 #include "globals.h"
+#include "effects.h"
+#include "resample.h"
+#include "mipmap.h"
+#include "orient.h"
+#include "dirwatch.h"
+#include "imagecache.h"
+#include "tiledimage.h"
+#include "lastframe.h"
+#include "startuptrace.h"
+#include "frametrace.h"
 #include <algorithm>
 #include <vector>
-#include <filesystem>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 
 using namespace Gdiplus;
-namespace fs = std::filesystem;
-
-// 扫描目录，返回修改时间最新的图片路径，同时通过 outTime 返回其时间戳
-std::wstring FindLatestImage(const std::wstring& dir, std::filesystem::file_time_type* outTime = nullptr) {
-    std::wstring latestFile;
-    std::filesystem::file_time_type latestTime{};
-    bool found = false;
-
-    try {
-        for (const auto& entry : fs::directory_iterator(dir)) {
-            if (!entry.is_regular_file()) continue;
-            auto ext = entry.path().extension().wstring();
-            std::transform(ext.begin(), ext.end(), ext.begin(), ::towlower);
-            if (ext == L".jpg" || ext == L".jpeg" || ext == L".png" || ext == L".bmp" ||
-                ext == L".gif" || ext == L".tiff" || ext == L".tif" || ext == L".ico" || ext == L".webp") {
-                auto ftime = entry.last_write_time();
-                if (!found || ftime > latestTime) {
-                    latestTime = ftime;
-                    latestFile = entry.path().wstring();
-                    found = true;
-                }
-            }
-        }
-    } catch (...) {}
 
-    if (found && outTime) *outTime = latestTime;
-    return latestFile;
+// 返回目录中修改时间最新的图片路径，同时通过 outTime 返回其时间戳（直接查询目录索引，不遍历目录）
+std::wstring FindLatestImage(const std::wstring& dir, int64_t* outTime) {
+    std::wstring latest;
+    if (!QueryLatestImage(dir, &latest, outTime)) return L"";
+    return latest;
 }
 
 // 记录已知的最新文件时间戳，只有目录中出现更新的文件时才自动切换
-static std::filesystem::file_time_type s_knownLatestTime{};
-static bool s_knownLatestInitialized = false;
+// 快捷键线程（强制重载）与渲染线程（自动加载）都会读写
+static std::atomic<int64_t> s_knownLatestTime(0);
+static std::atomic<bool> s_knownLatestInitialized(false);
 
 // 切换到上/下一张图片 (direction: -1=上一张, +1=下一张)
 void SwitchImage(int direction) {
-    std::vector<std::wstring> images;
-    try {
-        for (const auto& entry : fs::directory_iterator(imageDirectory)) {
-            if (!entry.is_regular_file()) continue;
-            auto ext = entry.path().extension().wstring();
-            std::transform(ext.begin(), ext.end(), ext.begin(), ::towlower);
-            if (ext == L".jpg" || ext == L".jpeg" || ext == L".png" || ext == L".bmp" ||
-                ext == L".gif" || ext == L".tiff" || ext == L".tif" || ext == L".ico" || ext == L".webp") {
-                images.push_back(entry.path().wstring());
-            }
-        }
-    } catch (...) { return; }
-
-    if (images.empty()) return;
-    std::sort(images.begin(), images.end());
-
-    // 找到当前图片的位置
-    int curIdx = -1;
-    for (int i = 0; i < (int)images.size(); i++) {
-        if (images[i] == currentImagePath) { curIdx = i; break; }
+    std::wstring next;
+    if (QueryNeighborImage(GetImageDirectory(), GetCurrentImagePath(), direction, &next)) {
+        SetCurrentImagePath(next);
     }
-
-    // 切换
-    int newIdx;
-    if (curIdx < 0) {
-        newIdx = (direction > 0) ? 0 : (int)images.size() - 1;
-    } else {
-        newIdx = curIdx + direction;
-        if (newIdx < 0) newIdx = (int)images.size() - 1;
-        if (newIdx >= (int)images.size()) newIdx = 0;
-    }
-    currentImagePath = images[newIdx];
 }
 
 // 强制加载目录中最新图片并更新时间戳记录
 void ReloadLatestImage() {
-    std::filesystem::file_time_type latestTime{};
-    std::wstring latest = FindLatestImage(imageDirectory, &latestTime);
+    int64_t latestTime = 0;
+    std::wstring latest = FindLatestImage(GetImageDirectory(), &latestTime);
     if (!latest.empty()) {
         s_knownLatestTime = latestTime;
         s_knownLatestInitialized = true;
-        currentImagePath = latest;
+        SetCurrentImagePath(latest);
     }
 }
 
-// 绘制透明窗口，应用缩放/透明度/黑白化/去白底等效果
-void DrawTransparentWindow(HWND hwnd) {
-    if (autoLoadLatest) {
-        std::filesystem::file_time_type latestTime{};
-        std::wstring latest = FindLatestImage(imageDirectory, &latestTime);
-        if (!latest.empty()) {
-            if (!s_knownLatestInitialized) {
-                // 首次初始化，加载最新图片并记录时间戳
-                s_knownLatestTime = latestTime;
-                s_knownLatestInitialized = true;
-                currentImagePath = latest;
-            } else if (latestTime > s_knownLatestTime) {
-                // 目录中出现了新文件，自动切换
-                s_knownLatestTime = latestTime;
-                currentImagePath = latest;
-            }
-        }
+// 自动加载模式：目录中出现更新的图片时切换过去（发布新的渲染状态版本）
+void UpdateAutoLoadedImage() {
+    if (!autoLoadLatest) return;
+    int64_t latestTime = 0;
+    std::wstring latest = FindLatestImage(GetImageDirectory(), &latestTime);
+    if (latest.empty()) return;
+    if (!s_knownLatestInitialized) {
+        // 首次初始化，加载最新图片并记录时间戳
+        s_knownLatestTime = latestTime;
+        s_knownLatestInitialized = true;
+        SetCurrentImagePath(latest);
+    } else if (latestTime > s_knownLatestTime) {
+        // 目录中出现了新文件，自动切换
+        s_knownLatestTime = latestTime;
+        SetCurrentImagePath(latest);
     }
+}
 
-    HDC hdcScreen = GetDC(nullptr);
-    HDC hdcMem = CreateCompatibleDC(hdcScreen);
-
-    int screenWidth = GetSystemMetrics(SM_CXSCREEN);
-    int screenHeight = GetSystemMetrics(SM_CYSCREEN);
-    HBITMAP hBitmap = CreateCompatibleBitmap(hdcScreen, screenWidth, screenHeight);
-    HBITMAP hOldBitmap = (HBITMAP)SelectObject(hdcMem, hBitmap);
+// ============ 效果结果缓存 ============
+// 32 位自上而下 DIB，像素可直接读写，也可作为 GDI 源直接 BitBlt
+struct DibSurface {
+    HDC dc = nullptr;
+    HBITMAP bitmap = nullptr;
+    HGDIOBJ oldBitmap = nullptr;
+    uint32_t* bits = nullptr;
+    int width = 0;
+    int height = 0;
+};
+
+// 释放 DIB 及其内存 DC
+static void ReleaseDib(DibSurface& dib) {
+    if (dib.dc) {
+        SelectObject(dib.dc, dib.oldBitmap);
+        DeleteDC(dib.dc);
+    }
+    if (dib.bitmap) DeleteObject(dib.bitmap);
+    dib = DibSurface();
+}
 
-    Graphics graphics(hdcMem);
-    graphics.Clear(Color(0, 0, 0, 0));
-    graphics.SetInterpolationMode(InterpolationModeHighQualityBicubic);
-
-    Bitmap image(currentImagePath.c_str());
-    if (image.GetLastStatus() != Ok) {
-        SelectObject(hdcMem, hOldBitmap);
-        DeleteObject(hBitmap);
-        DeleteDC(hdcMem);
-        ReleaseDC(nullptr, hdcScreen);
-        return;
+// 按需重建 DIB，尺寸不变时直接复用
+static bool ResizeDib(DibSurface& dib, int width, int height) {
+    if (dib.bitmap && dib.width == width && dib.height == height) return true;
+    ReleaseDib(dib);
+    if (width <= 0 || height <= 0) return false;
+
+    BITMAPINFO bi = {};
+    bi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    bi.bmiHeader.biWidth = width;
+    bi.bmiHeader.biHeight = -height; // 自上而下
+    bi.bmiHeader.biPlanes = 1;
+    bi.bmiHeader.biBitCount = 32;
+    bi.bmiHeader.biCompression = BI_RGB;
+
+    void* bits = nullptr;
+    HBITMAP bitmap = CreateDIBSection(nullptr, &bi, DIB_RGB_COLORS, &bits, nullptr, 0);
+    if (!bitmap || !bits) {
+        if (bitmap) DeleteObject(bitmap);
+        return false;
     }
+    dib.dc = CreateCompatibleDC(nullptr);
+    dib.bitmap = bitmap;
+    dib.oldBitmap = SelectObject(dib.dc, bitmap);
+    dib.bits = (uint32_t*)bits;
+    dib.width = width;
+    dib.height = height;
+    return true;
+}
 
-    UINT imgWidth = image.GetWidth();
-    UINT imgHeight = image.GetHeight();
+// 影响最终像素的全部渲染参数；拖动偏移不在其中，因此拖动只需重新贴图
+struct SurfaceKey {
+    uint64_t image = 0; // DecodedImage::generation
+    float scale = 0.0f;
+    int rotation = 0;
+    bool mirrorH = false;
+    bool mirrorV = false;
+    bool gray = false;
+    bool removeWhite = false;
+    float opacity = 0.0f;
+    bool draft = false; // 交互预览：双线性重采样 + 低质量旋转
+
+    bool operator==(const SurfaceKey&) const = default;
+};
+
+// 缓存缩放、旋转、效果处理后的预乘 BGRA 结果，尺寸即旋转后的包围盒
+static DibSurface s_surface;
+static SurfaceKey s_surfaceKey;
+static bool s_surfaceValid = false;
+static float s_surfaceShiftX = 0.0f; // s_surface 中心相对整图中心的屏幕偏移（超大图片只渲染可见区域时非零）
+static float s_surfaceShiftY = 0.0f;
+static uint64_t s_surfaceFrameHash = 0; // 完整质量且来自普通图片时为内容哈希（见 FrameContentHash），否则为 0
+static std::wstring s_surfaceImagePath; // s_surface 的源图片标识，退出时随画面保存
+static uint64_t s_surfaceImageMtime = 0;
+static uint64_t s_surfaceImageSize = 0;
+
+// 效果层缓存：所选 mip 级别尺寸的预乘结果，只随图片、级别和效果参数变化
+// 级别内的缩放/旋转直接复用；大幅缩小时只需处理小得多的级别
+struct EffectKey {
+    uint64_t image = 0;
+    int level = 0;
+    bool gray = false;
+    bool removeWhite = false;
+    float opacity = 0.0f;
+
+    bool operator==(const EffectKey&) const = default;
+};
+static std::vector<uint32_t> s_effectPixels;
+static EffectKey s_effectKey;
+static bool s_effectValid = false;
+
+static std::vector<uint32_t> s_scaledPixels;   // 旋转/镜像前的缩放结果
+static std::vector<uint32_t> s_mirroredPixels; // 任意角度旋转前的镜像结果
+
+// 对 mip 第 level 级单趟完成去白底/黑白化/透明度/预乘，结果缓冲跨帧复用
+static void UpdateEffectPixels(const MipChain& mips, int level, const SurfaceKey& key) {
+    EffectKey effectKey;
+    effectKey.image = key.image;
+    effectKey.level = level;
+    effectKey.gray = key.gray;
+    effectKey.removeWhite = key.removeWhite;
+    effectKey.opacity = key.opacity;
+    if (s_effectValid && effectKey == s_effectKey) return;
+
+    EffectParams params;
+    params.removeWhite = key.removeWhite;
+    params.grayscale = key.gray;
+    params.opacity = key.opacity;
+    int w = mips.Width(level);
+    int h = mips.Height(level);
+    s_effectPixels.resize((size_t)w * h);
+    ScopedTraceStage trace(TRACE_EFFECTS);
+    ApplyEffects(mips.Pixels(level), w, s_effectPixels.data(), w, w, h, params);
+    s_effectKey = effectKey;
+    s_effectValid = true;
+}
 
-    float scale = scaleFactor.load();
-    int rotation = rotationAngle.load() % 360;
+// 将 mips 第 0 级的图像按 key 渲染到 s_surface（缩放 + 镜像/旋转 + 透明度/黑白化/去白底）
+static bool RenderSurface(MipChain& mips, const SurfaceKey& key) {
+    s_surfaceValid = false;
 
     // 原始缩放尺寸
-    UINT scaledW = static_cast<UINT>(imgWidth * scale);
-    UINT scaledH = static_cast<UINT>(imgHeight * scale);
+    int scaledW = static_cast<int>(mips.Width(0) * key.scale);
+    int scaledH = static_cast<int>(mips.Height(0) * key.scale);
+    if (scaledW <= 0 || scaledH <= 0) return false;
+
+    // 从不小于目标尺寸的最近 mip 级别重采样，缩小比例始终在 (0.5, 1] 内，滤波核宽度有界
+    int level = mips.SelectLevel(scaledW, scaledH);
+    int levelW = mips.Width(level);
+    int levelH = mips.Height(level);
+    UpdateEffectPixels(mips, level, key);
+    ResampleFilter filter = key.draft ? ResampleFilter::Bilinear : ResampleFilter::Bicubic;
+
+    // 90° 整数倍的旋转与镜像只是像素重排，不需要再次采样
+    Orientation orient;
+    orient.mirrorH = key.mirrorH;
+    orient.mirrorV = key.mirrorV;
+    bool exact = key.rotation % 90 == 0;
+    if (exact) orient.quarterTurns = key.rotation / 90;
+
+    if (exact && orient.IsIdentity()) {
+        // 无旋转：直接重采样到缓存 DIB，全程不经过 GDI+
+        if (!ResizeDib(s_surface, scaledW, scaledH)) return false;
+        ScopedTraceStage trace(TRACE_RESAMPLE);
+        ResampleImage(s_effectPixels.data(), levelW, levelH, levelW,
+                      s_surface.bits, scaledW, scaledH, scaledW, filter);
+        s_surfaceKey = key;
+        s_surfaceValid = true;
+        return true;
+    }
+
+    // 先按目标尺寸重采样，之后的镜像/旋转都是 1:1 的
+    s_scaledPixels.resize((size_t)scaledW * scaledH);
+    {
+        ScopedTraceStage trace(TRACE_RESAMPLE);
+        ResampleImage(s_effectPixels.data(), levelW, levelH, levelW,
+                      s_scaledPixels.data(), scaledW, scaledH, scaledW, filter);
+    }
+    ScopedTraceStage trace(TRACE_ROTATE);
+
+    if (exact) {
+        // 90°/180°/270° 与镜像：分块重排直接写入缓存 DIB，不经过 GDI+
+        int orientedW, orientedH;
+        OrientedSize(scaledW, scaledH, orient, &orientedW, &orientedH);
+        if (!ResizeDib(s_surface, orientedW, orientedH)) return false;
+        OrientImage(s_scaledPixels.data(), scaledW, scaledH, scaledW, s_surface.bits, orientedW, orient);
+        s_surfaceKey = key;
+        s_surfaceValid = true;
+        return true;
+    }
+
+    // 任意角度：镜像先在缩放结果上做完，GDI+ 只负责旋转
+    const uint32_t* rotateSource = s_scaledPixels.data();
+    if (key.mirrorH || key.mirrorV) {
+        s_mirroredPixels.resize(s_scaledPixels.size());
+        OrientImage(s_scaledPixels.data(), scaledW, scaledH, scaledW, s_mirroredPixels.data(), scaledW, orient);
+        rotateSource = s_mirroredPixels.data();
+    }
 
     // 计算旋转后的包围盒尺寸（用于屏幕居中）
-    float rad = rotation * 3.14159265f / 180.0f;
+    float rad = key.rotation * 3.14159265f / 180.0f;
     float cosA = fabsf(cosf(rad));
     float sinA = fabsf(sinf(rad));
-    UINT renderWidth  = static_cast<UINT>(scaledW * cosA + scaledH * sinA);
-    UINT renderHeight = static_cast<UINT>(scaledW * sinA + scaledH * cosA);
+    int renderWidth  = static_cast<int>(scaledW * cosA + scaledH * sinA);
+    int renderHeight = static_cast<int>(scaledW * sinA + scaledH * cosA);
 
-    int offsetX = windowOffsetX.load() + (screenWidth - (int)renderWidth) / 2;
-    int offsetY = windowOffsetY.load() + (screenHeight - (int)renderHeight) / 2;
+    if (!ResizeDib(s_surface, renderWidth, renderHeight)) return false;
 
-    float alpha = opacityFactor.load();
-    bool gray = grayscaleEnabled.load();
-    bool rmWhite = removeWhiteBg.load();
+    // 直接在 DIB 像素上以预乘 ARGB 格式绘制
+    Bitmap target(s_surface.width, s_surface.height, s_surface.width * 4, PixelFormat32bppPARGB,
+                  (BYTE*)s_surface.bits);
+    Graphics graphics(&target);
+    graphics.Clear(Color(0, 0, 0, 0));
+    graphics.SetInterpolationMode(key.draft ? InterpolationModeBilinear : InterpolationModeHighQualityBicubic);
 
-    // 应用旋转：绕包围盒中心旋转
     // 绘制矩形始终用原始缩放尺寸，居中于包围盒内
-    int drawX = offsetX + ((int)renderWidth - (int)scaledW) / 2;
-    int drawY = offsetY + ((int)renderHeight - (int)scaledH) / 2;
+    int drawX = (renderWidth - scaledW) / 2;
+    int drawY = (renderHeight - scaledH) / 2;
     Rect drawRect(drawX, drawY, scaledW, scaledH);
 
-    if (rotation != 0) {
-        float cx = offsetX + renderWidth / 2.0f;
-        float cy = offsetY + renderHeight / 2.0f;
-        graphics.TranslateTransform(cx, cy);
-        graphics.RotateTransform((float)rotation);
-        graphics.TranslateTransform(-cx, -cy);
+    // 绕包围盒中心旋转
+    float cx = renderWidth / 2.0f;
+    float cy = renderHeight / 2.0f;
+    graphics.TranslateTransform(cx, cy);
+    graphics.RotateTransform((float)key.rotation);
+    graphics.TranslateTransform(-cx, -cy);
+
+    Bitmap scaled(scaledW, scaledH, scaledW * 4, PixelFormat32bppPARGB, (BYTE*)rotateSource);
+    graphics.DrawImage(
+        &scaled,
+        drawRect,
+        0, 0, scaledW, scaledH,
+        UnitPixel
+    );
+
+    s_surfaceKey = key;
+    s_surfaceValid = true;
+    return true;
+}
+
+// ============ 交互预览 ============
+// 拖动、按住缩放/透明度键、拖动设置滑块时先用快速路径出图，停止操作后再以完整质量重绘
+static std::atomic<ULONGLONG> s_lastInteractionTick(0);
+
+void MarkInteraction() {
+    s_lastInteractionTick = GetTickCount64();
+}
+
+// 距上次交互不足 refineDelayMs 视为仍在交互中
+static bool IsInteracting() {
+    ULONGLONG last = s_lastInteractionTick.load();
+    int delay = refineDelayMs.load();
+    return delay > 0 && last != 0 && GetTickCount64() - last < (ULONGLONG)delay;
+}
+
+// 上一次提交给窗口的画面：模式、内容、位置都没变时无需再次提交
+static bool s_presentedValid = false;
+static bool s_presentedFit = false;     // 贴合模式下窗口只有图片包围盒大小
+static bool s_presentedHud = false;     // 提交的画面中是否带有统计面板
+static uint64_t s_presentedSerial = 0;
+static POINT s_presentedOrigin = { 0, 0 };
+static RECT s_presentedMonitor = { 0, 0, 0, 0 };
+static bool s_presentedEmpty = false;   // 上一次提交的是空画面（图片完全移出显示器）
+static uint64_t s_surfaceSerial = 0;    // s_surface 内容每次重新生成时递增
+
+// ============ 全屏后备缓冲 ============
+// 常驻的目标显示器尺寸 DIB，只在显示设置变化或切换到不同尺寸的显示器时重建；
+// 每帧只清除/写入图片实际覆盖的区域
+static DibSurface s_backBuffer;
+static RECT s_backDirty = { 0, 0, 0, 0 }; // 上一帧写入过像素的区域
+
+// 按目标显示器尺寸创建后备缓冲，尺寸不变时直接复用
+static bool EnsureBackBuffer(int width, int height) {
+    if (s_backBuffer.bitmap && s_backBuffer.width == width && s_backBuffer.height == height) return true;
+    if (!ResizeDib(s_backBuffer, width, height)) return false;
+    memset(s_backBuffer.bits, 0, (size_t)s_backBuffer.width * s_backBuffer.height * 4);
+    s_backDirty = { 0, 0, 0, 0 };
+    return true;
+}
+
+// 显示设置变化（分辨率/缩放/显示器增减）时丢弃后备缓冲，下一帧按新尺寸重建
+void OnDisplayChange() {
+    ReleaseDib(s_backBuffer);
+    s_presentedValid = false;
+    s_presentedEmpty = false;
+}
+
+// 用同一像素值填充 DIB 中的矩形（调用方保证矩形已裁剪到 DIB 内）
+static void FillDibRect(DibSurface& dib, const RECT& r, uint32_t value) {
+    for (LONG y = r.top; y < r.bottom; y++) {
+        uint32_t* row = dib.bits + (size_t)y * dib.width;
+        std::fill(row + r.left, row + r.right, value);
+    }
+}
+
+// 将 src 整块拷贝到 dst 的 (x, y) 处并裁剪到 dst 范围内，返回实际写入的矩形
+static RECT BlitToDib(DibSurface& dst, const DibSurface& src, int x, int y) {
+    RECT r;
+    r.left   = std::max(x, 0);
+    r.top    = std::max(y, 0);
+    r.right  = std::min(x + src.width, dst.width);
+    r.bottom = std::min(y + src.height, dst.height);
+    if (r.left >= r.right || r.top >= r.bottom) return { 0, 0, 0, 0 };
+
+    size_t rowBytes = (size_t)(r.right - r.left) * 4;
+    for (LONG row = r.top; row < r.bottom; row++) {
+        const uint32_t* s = src.bits + (size_t)(row - y) * src.width + (r.left - x);
+        memcpy(dst.bits + (size_t)row * dst.width + r.left, s, rowBytes);
     }
+    return r;
+}
 
-    if (!rmWhite) {
-        // 通过颜色矩阵实现透明度和黑白化
-        ColorMatrix colorMatrix;
-        if (gray) {
-            colorMatrix = {
-                0.299f, 0.299f, 0.299f, 0.0f, 0.0f,
-                0.587f, 0.587f, 0.587f, 0.0f, 0.0f,
-                0.114f, 0.114f, 0.114f, 0.0f, 0.0f,
-                0.0f,   0.0f,   0.0f,   alpha, 0.0f,
-                0.0f,   0.0f,   0.0f,   0.0f, 1.0f
-            };
+// 计算缓存结果在屏幕上的左上角：在目标显示器内居中后加上拖动偏移
+static POINT SurfaceOrigin(const RenderState& state) {
+    POINT pt;
+    pt.x = state.monitorX + state.offsetX + (state.monitorWidth - s_surface.width) / 2 + lroundf(s_surfaceShiftX);
+    pt.y = state.monitorY + state.offsetY + (state.monitorHeight - s_surface.height) / 2 + lroundf(s_surfaceShiftY);
+    return pt;
+}
+
+// ============ 超大图片：只渲染可见区域 ============
+// 按视口选出级别和块矩形，把已到达的块（缺失处用缩略级）拼成区域图，再走普通的效果/缩放/旋转流程。
+// 区域图只在块矩形变化或有新块到达时重新拼接，拖动时跨过块边界才需要重做
+
+struct RegionKey {
+    uint64_t image = 0;
+    int level = 0;
+    TileRect rect;
+    uint64_t stamp = 0;
+
+    bool operator==(const RegionKey&) const = default;
+};
+static RegionKey s_regionKey;
+static bool s_regionValid = false;
+static std::vector<uint32_t> s_regionPixels;
+static MipChain s_regionMips;
+static uint64_t s_regionGeneration = 0;
+
+// 渲染源：mips 第 0 级按 scale 缩放，结果中心相对整图中心的屏幕偏移为 (shiftX, shiftY)
+struct RenderSource {
+    MipChain* mips = nullptr;
+    uint64_t generation = 0;
+    float scale = 0.0f;
+    float shiftX = 0.0f;
+    float shiftY = 0.0f;
+};
+
+// 把按镜像后图片求出的可见矩形换回原图坐标，重新对齐到块边界（只会变大）
+static TileRect MirrorTileRect(const TileRect& rect, int levelW, int levelH, bool mirrorH, bool mirrorV) {
+    TileRect out = rect;
+    if (mirrorH) {
+        int x0 = (levelW - rect.x - rect.width) / kTileSize * kTileSize;
+        int x1 = std::min(levelW, (levelW - rect.x + kTileSize - 1) / kTileSize * kTileSize);
+        out.x = x0;
+        out.width = x1 - x0;
+    }
+    if (mirrorV) {
+        int y0 = (levelH - rect.y - rect.height) / kTileSize * kTileSize;
+        int y1 = std::min(levelH, (levelH - rect.y + kTileSize - 1) / kTileSize * kTileSize);
+        out.y = y0;
+        out.height = y1 - y0;
+    }
+    return out;
+}
+
+// 为超大图片准备渲染源；图片完全不在目标显示器内时返回 false
+static bool PrepareTiledSource(DecodedImage& image, const RenderState& state, RenderSource* out) {
+    TiledImage& tiled = *image.tiled;
+    float pixelScale = state.PixelScale();
+    int level = SelectTileLevel(tiled.width, tiled.height, pixelScale);
+    if (level >= tiled.overviewLevel) {
+        // 缩得足够小时常驻缩略级本身就够用
+        out->mips = &image.mips;
+        out->generation = image.generation;
+        out->scale = pixelScale * tiled.width / image.width;
+        return true;
+    }
+
+    TileView view;
+    view.imageW = tiled.width;
+    view.imageH = tiled.height;
+    view.scale = pixelScale;
+    view.rotation = state.rotation;
+    view.centerX = state.monitorWidth * 0.5f + state.offsetX;
+    view.centerY = state.monitorHeight * 0.5f + state.offsetY;
+    view.viewW = state.monitorWidth;
+    view.viewH = state.monitorHeight;
+    TileRect rect;
+    if (!VisibleTileRect(view, level, &rect)) return false;
+
+    int levelW, levelH;
+    TileLevelSize(tiled.width, tiled.height, level, &levelW, &levelH);
+    // 以上按镜像后的图片计算（镜像不改变图片的外形），镜像回原图坐标后才是要解码的区域
+    if (state.mirrorH || state.mirrorV) rect = MirrorTileRect(rect, levelW, levelH, state.mirrorH, state.mirrorV);
+    float rad = state.rotation * 3.14159265f / 180.0f;
+    float cosA = cosf(rad), sinA = sinf(rad);
+
+    // 先解码离屏幕中心最近的块：屏幕中心相对图片中心为 (-offsetX, -offsetY)，逆旋转、逆镜像后换算到该级坐标
+    float fx = (-state.offsetX * cosA - state.offsetY * sinA) / pixelScale;
+    float fy = ( state.offsetX * sinA - state.offsetY * cosA) / pixelScale;
+    if (state.mirrorH) fx = -fx;
+    if (state.mirrorV) fy = -fy;
+    fx += tiled.width * 0.5f;
+    fy += tiled.height * 0.5f;
+    RequestTiles(image.tiled, TilesInRect(level, rect, fx * levelW / tiled.width, fy * levelH / tiled.height));
+
+    RegionKey key;
+    key.image = image.generation;
+    key.level = level;
+    key.rect = rect;
+    key.stamp = tiled.stamp.load();
+    if (!s_regionValid || !(key == s_regionKey)) {
+        s_regionPixels.resize((size_t)rect.width * rect.height);
+        ComposeTiledRegion(tiled, level, rect, image.pixels.data(), image.width, image.height, s_regionPixels.data());
+        s_regionMips.Reset(s_regionPixels.data(), rect.width, rect.height);
+        s_regionGeneration = NewImageGeneration();
+        s_regionKey = key;
+        s_regionValid = true;
+    }
+
+    out->mips = &s_regionMips;
+    out->generation = s_regionGeneration;
+    out->scale = pixelScale * tiled.width / levelW;
+
+    // 区域中心相对整图中心的偏移，缩放、镜像后按图片的旋转方向转到屏幕坐标
+    float dx = ((rect.x + rect.width * 0.5f) * tiled.width / levelW - tiled.width * 0.5f) * pixelScale;
+    float dy = ((rect.y + rect.height * 0.5f) * tiled.height / levelH - tiled.height * 0.5f) * pixelScale;
+    if (state.mirrorH) dx = -dx;
+    if (state.mirrorV) dy = -dy;
+    out->shiftX = dx * cosA - dy * sinA;
+    out->shiftY = dx * sinA + dy * cosA;
+    return true;
+}
+
+// ============ 启动时恢复的画面 ============
+// 启动时已直接提交到窗口的上次画面；第一帧内容哈希相同就把它接管为 s_surface，省去一次完整渲染
+static std::shared_ptr<const LastFrame> s_restoredFrame;
+
+void SetRestoredFrame(std::shared_ptr<const LastFrame> frame) {
+    s_restoredFrame = std::move(frame);
+}
+
+// 只在第一帧尝试一次：无论是否接管，之后都不再需要这张画面
+static bool AdoptRestoredFrame(const SurfaceKey& key, uint64_t frameHash) {
+    std::shared_ptr<const LastFrame> frame = std::move(s_restoredFrame);
+    if (frameHash == 0 || frame->contentHash != frameHash) return false;
+    if (!ResizeDib(s_surface, frame->width, frame->height)) return false;
+    memcpy(s_surface.bits, frame->pixels.data(), frame->pixels.size() * 4);
+    s_surfaceKey = key;
+    s_surfaceValid = true;
+    s_surfaceShiftX = frame->shiftX;
+    s_surfaceShiftY = frame->shiftY;
+    s_surfaceFrameHash = frameHash;
+    s_surfaceImagePath = frame->imagePath;
+    s_surfaceImageMtime = frame->imageMtime;
+    s_surfaceImageSize = frame->imageSize;
+    s_surfaceSerial++;
+    MarkStartupPhase(L"frame-reused");
+    return true;
+}
+
+bool CaptureLastFrame(LastFrame* frame) {
+    if (!s_surfaceValid || s_surfaceFrameHash == 0 || !s_presentedValid || s_presentedSerial != s_surfaceSerial) {
+        return false;
+    }
+    frame->contentHash = s_surfaceFrameHash;
+    frame->imagePath = s_surfaceImagePath;
+    frame->imageMtime = s_surfaceImageMtime;
+    frame->imageSize = s_surfaceImageSize;
+    frame->monitor = s_presentedMonitor;
+    frame->origin = s_presentedOrigin;
+    frame->shiftX = s_surfaceShiftX;
+    frame->shiftY = s_surfaceShiftY;
+    frame->width = s_surface.width;
+    frame->height = s_surface.height;
+    frame->pixels.assign(s_surface.bits, s_surface.bits + (size_t)s_surface.width * s_surface.height);
+    return true;
+}
+
+// ============ 帧耗时统计面板 ============
+// 画在全屏后备缓冲的左上角（相对目标显示器），内容为最近若干次各阶段耗时；每次提交画面时刷新
+
+static const TraceStage kHudStages[] = {
+    TRACE_SCAN, TRACE_DECODE, TRACE_EFFECTS, TRACE_RESAMPLE, TRACE_ROTATE, TRACE_COMPOSE, TRACE_PRESENT, TRACE_FRAME,
+};
+static const wchar_t* kHudStageNames[] = {
+    L"目录扫描", L"解码", L"效果", L"缩放", L"旋转", L"合成", L"提交", L"整帧",
+};
+
+// 在 dib 上绘制统计面板，返回写入过像素的矩形（已裁剪到 dib 内）
+static RECT DrawStatsHud(DibSurface& dib) {
+    const int margin = 12, lineHeight = 18, width = 340;
+    const int lines = (int)(sizeof(kHudStages) / sizeof(kHudStages[0])) + 2;
+    RECT r = { margin, margin, margin + width, margin + lines * lineHeight + 12 };
+    r.right = std::min<LONG>(r.right, dib.width);
+    r.bottom = std::min<LONG>(r.bottom, dib.height);
+    if (r.left >= r.right || r.top >= r.bottom) return { 0, 0, 0, 0 };
+
+    FrameTrace& trace = SessionTrace();
+    Bitmap target(dib.width, dib.height, dib.width * 4, PixelFormat32bppPARGB, (BYTE*)dib.bits);
+    Graphics graphics(&target);
+    graphics.SetClip(Rect(r.left, r.top, r.right - r.left, r.bottom - r.top));
+    graphics.Clear(Color(200, 16, 16, 16)); // 分层窗口按像素 alpha 混合，GDI+ 写入的是预乘值
+    graphics.SetTextRenderingHint(TextRenderingHintAntiAliasGridFit); // 透明背景上不能用 ClearType
+
+    FontFamily family(L"Consolas");
+    Font font(&family, 12, FontStyleRegular, UnitPixel);
+    SolidBrush textBrush(Color(255, 235, 235, 235));
+    SolidBrush headBrush(Color(255, 150, 200, 255));
+    wchar_t text[128];
+    float x = (float)r.left + 8, y = (float)r.top + 6;
+
+    swprintf(text, 128, L"%-8ls %8ls %8ls %8ls %6ls", L"ms", L"p50", L"p95", L"max", L"n");
+    graphics.DrawString(text, -1, &font, PointF(x, y), &headBrush);
+    y += lineHeight;
+    for (size_t i = 0; i < sizeof(kHudStages) / sizeof(kHudStages[0]); i++) {
+        StageSummary s = trace.Summarize(kHudStages[i]);
+        if (s.samples == 0) {
+            swprintf(text, 128, L"%-8ls %8ls %8ls %8ls %6d", kHudStageNames[i], L"-", L"-", L"-", 0);
         } else {
-            colorMatrix = {
-                1.0f, 0.0f, 0.0f, 0.0f, 0.0f,
-                0.0f, 1.0f, 0.0f, 0.0f, 0.0f,
-                0.0f, 0.0f, 1.0f, 0.0f, 0.0f,
-                0.0f, 0.0f, 0.0f, alpha, 0.0f,
-                0.0f, 0.0f, 0.0f, 0.0f, 1.0f
-            };
+            swprintf(text, 128, L"%-8ls %8.2f %8.2f %8.2f %6d", kHudStageNames[i], s.p50, s.p95, s.max, s.samples);
         }
+        graphics.DrawString(text, -1, &font, PointF(x, y), &textBrush);
+        y += lineHeight;
+    }
+    swprintf(text, 128, L"缓存 命中 %llu 未命中 %llu  跳过 %llu 帧",
+             (unsigned long long)trace.Counter(TRACE_CACHE_HIT), (unsigned long long)trace.Counter(TRACE_CACHE_MISS),
+             (unsigned long long)trace.Counter(TRACE_FRAME_SKIPPED));
+    graphics.DrawString(text, -1, &font, PointF(x, y), &headBrush);
+    graphics.Flush(FlushIntentionSync);
+    return r;
+}
 
-        ImageAttributes imageAttributes;
-        imageAttributes.SetColorMatrix(&colorMatrix, ColorMatrixFlagsDefault, ColorAdjustTypeBitmap);
+// 贴合模式下提交空画面用的 1x1 全透明 DIB
+static DibSurface s_emptySurface;
 
-        graphics.DrawImage(
-            &image,
-            drawRect,
-            0, 0, imgWidth, imgHeight,
-            UnitPixel,
-            &imageAttributes
-        );
+// 图片完全不在显示器内时提交空画面，否则屏幕上会一直留着最后一次可见的部分
+static FrameStats PresentEmptyFrame(HWND hwnd, const RenderState& state, FrameStats stats) {
+    bool hud = state.statsHud;
+    bool fit = state.fitWindow && !hud;
+    RECT monitor = { state.monitorX, state.monitorY,
+                     state.monitorX + state.monitorWidth, state.monitorY + state.monitorHeight };
+    // 继续拖动时不必每帧重复提交
+    if (s_presentedEmpty && s_presentedFit == fit && !hud && EqualRect(&s_presentedMonitor, &monitor)) return stats;
+
+    BLENDFUNCTION blend = { AC_SRC_OVER, 0, 255, AC_SRC_ALPHA };
+    POINT ptSrc = { 0, 0 };
+    POINT ptDst = { state.monitorX, state.monitorY };
+    if (fit) {
+        // CreateDIBSection 分配的像素为全零，即完全透明
+        if (!ResizeDib(s_emptySurface, 1, 1)) return stats;
+        SIZE size = { 1, 1 };
+        ScopedTraceStage trace(TRACE_PRESENT);
+        if (!UpdateLayeredWindow(hwnd, nullptr, &ptDst, &size, s_emptySurface.dc, &ptSrc, 0, &blend, ULW_ALPHA)) {
+            return stats;
+        }
     } else {
-        // 去白底模式：逐像素处理，白色区域设为全透明
-        Bitmap tempBmp(imgWidth, imgHeight, PixelFormat32bppARGB);
+        if (!EnsureBackBuffer(state.monitorWidth, state.monitorHeight)) return stats;
         {
-            BitmapData srcData, dstData;
-            Rect lockRect(0, 0, imgWidth, imgHeight);
-            image.LockBits(&lockRect, ImageLockModeRead, PixelFormat32bppARGB, &srcData);
-            tempBmp.LockBits(&lockRect, ImageLockModeWrite, PixelFormat32bppARGB, &dstData);
-
-            BYTE* srcPixels = (BYTE*)srcData.Scan0;
-            BYTE* dstPixels = (BYTE*)dstData.Scan0;
-
-            for (UINT y = 0; y < imgHeight; y++) {
-                for (UINT x = 0; x < imgWidth; x++) {
-                    int idx = y * srcData.Stride + x * 4;
-                    BYTE b = srcPixels[idx + 0];
-                    BYTE g = srcPixels[idx + 1];
-                    BYTE r = srcPixels[idx + 2];
-                    BYTE a = srcPixels[idx + 3];
-
-                    if (r > 240 && g > 240 && b > 240) {
-                        a = 0;
-                    } else {
-                        a = static_cast<BYTE>(a * alpha);
-                    }
-
-                    if (gray) {
-                        BYTE grayVal = static_cast<BYTE>(0.299f * r + 0.587f * g + 0.114f * b);
-                        r = g = b = grayVal;
-                    }
-
-                    dstPixels[idx + 0] = b;
-                    dstPixels[idx + 1] = g;
-                    dstPixels[idx + 2] = r;
-                    dstPixels[idx + 3] = a;
-                }
-            }
-
-            image.UnlockBits(&srcData);
-            tempBmp.UnlockBits(&dstData);
+            ScopedTraceStage trace(TRACE_COMPOSE);
+            FillDibRect(s_backBuffer, s_backDirty, 0);
+            s_backDirty = { 0, 0, 0, 0 };
+        }
+        if (hud) s_backDirty = DrawStatsHud(s_backBuffer);
+        SIZE size = { s_backBuffer.width, s_backBuffer.height };
+        ScopedTraceStage trace(TRACE_PRESENT);
+        if (!UpdateLayeredWindow(hwnd, nullptr, &ptDst, &size, s_backBuffer.dc, &ptSrc, 0, &blend, ULW_ALPHA)) {
+            return stats;
         }
+    }
+
+    // 图片回到显示器内时必须重新提交
+    s_presentedValid = false;
+    s_presentedEmpty = true;
+    s_presentedFit = fit;
+    s_presentedHud = hud;
+    s_presentedMonitor = monitor;
+    stats.presented = true;
+    return stats;
+}
+
+// 交互预览结束后需要补做完整质量重绘的时间点（0 表示无需补绘）
+static std::atomic<ULONGLONG> s_refineDue(0);
 
-        graphics.DrawImage(
-            &tempBmp,
-            drawRect,
-            0, 0, imgWidth, imgHeight,
-            UnitPixel
-        );
+ULONGLONG GetRefineDueTick() {
+    return s_refineDue.load();
+}
+
+// 按快照绘制透明窗口：参数未变时直接复用缓存结果；画面完全没变时连提交也跳过
+FrameStats DrawTransparentWindow(HWND hwnd, const RenderState& state) {
+    FrameStats stats;
+    s_refineDue = 0; // 只有本帧又画了预览时才重新安排补绘
+
+    // 只查缓存，不在绘制线程解码；新图片未就绪时继续显示上一张，解码完成后会再次请求绘制
+    std::shared_ptr<DecodedImage> image = RequestDecodedImage(state.imagePath);
+    if (!state.imagePath.empty()) SessionTrace().Count(image ? TRACE_CACHE_HIT : TRACE_CACHE_MISS);
+    PrefetchAround(state.imageDirectory, state.imagePath);
+
+    if (image) {
+        RenderSource source;
+        source.mips = &image->mips;
+        source.generation = image->generation;
+        source.scale = state.PixelScale();
+        if (image->tiled && !PrepareTiledSource(*image, state, &source)) return PresentEmptyFrame(hwnd, state, stats);
+
+        SurfaceKey key;
+        key.image = source.generation;
+        key.scale = source.scale;
+        key.rotation = state.rotation;
+        key.mirrorH = state.mirrorH;
+        key.mirrorV = state.mirrorV;
+        key.gray = state.grayscale;
+        key.removeWhite = state.removeWhite;
+        key.opacity = state.opacity;
+
+        // 超大图片的画面随视口变化，不参与跨次启动复用
+        uint64_t frameHash = image->tiled ? 0 : FrameContentHash(image->path, image->mtime, image->size,
+                                                                  source.scale, key.rotation, key.mirrorH,
+                                                                  key.mirrorV, key.gray, key.removeWhite,
+                                                                  key.opacity);
+
+        // 已有完整质量的结果时直接复用；否则交互中先出预览，并在交互停止后补一次完整质量重绘
+        bool reuse = s_surfaceValid && key == s_surfaceKey;
+        if (!reuse && s_restoredFrame) reuse = AdoptRestoredFrame(key, frameHash);
+        if (!reuse && IsInteracting()) {
+            key.draft = true;
+            reuse = s_surfaceValid && key == s_surfaceKey;
+            s_refineDue = s_lastInteractionTick.load() + (ULONGLONG)refineDelayMs.load();
+        }
+        if (!reuse) {
+            if (!RenderSurface(*source.mips, key)) return stats;
+            s_surfaceShiftX = source.shiftX;
+            s_surfaceShiftY = source.shiftY;
+            s_surfaceFrameHash = key.draft ? 0 : frameHash;
+            s_surfaceImagePath = image->path;
+            s_surfaceImageMtime = image->mtime;
+            s_surfaceImageSize = image->size;
+            s_surfaceSerial++;
+            stats.rendered = true;
+        }
+    } else if (!s_surfaceValid) {
+        return stats;
     }
 
-    // 用 UpdateLayeredWindow 将内存 DC 刷新到分层窗口
-    POINT ptPos = { 0, 0 };
-    SIZE size = { screenWidth, screenHeight };
+    POINT origin = SurfaceOrigin(state);
+    bool hud = state.statsHud;
+    bool fit = state.fitWindow && !hud; // 统计面板要画在显示器角落，显示期间走全屏路径
+    bool sameContent = s_presentedValid && s_presentedFit == fit && s_presentedHud == hud &&
+                       s_presentedSerial == s_surfaceSerial;
+    // 面板内容随每帧变化，显示期间不跳过提交
+    if (sameContent && !hud && s_presentedOrigin.x == origin.x && s_presentedOrigin.y == origin.y) return stats;
+
     BLENDFUNCTION blend = { AC_SRC_OVER, 0, 255, AC_SRC_ALPHA };
-    UpdateLayeredWindow(hwnd, hdcScreen, nullptr, &size, hdcMem, &ptPos, 0, &blend, ULW_ALPHA);
+    POINT ptSrc = { 0, 0 };
+
+    if (fit) {
+        // 贴合模式：窗口即图片包围盒。内容没变（拖动）时只移动窗口，否则以缓存 DIB 作为源提交
+        ScopedTraceStage trace(TRACE_PRESENT);
+        BOOL ok = FALSE;
+        if (sameContent) {
+            ok = UpdateLayeredWindow(hwnd, nullptr, &origin, nullptr, nullptr, nullptr, 0, nullptr, 0);
+        }
+        if (!ok) {
+            SIZE size = { s_surface.width, s_surface.height };
+            ok = UpdateLayeredWindow(hwnd, nullptr, &origin, &size, s_surface.dc, &ptSrc, 0, &blend, ULW_ALPHA);
+        }
+        if (!ok) return stats;
+    } else {
+        if (!EnsureBackBuffer(state.monitorWidth, state.monitorHeight)) return stats;
+
+        // 全屏模式：窗口铺满目标显示器。清掉上一帧的图片区域，再把缓存结果拷到新位置
+        {
+            ScopedTraceStage trace(TRACE_COMPOSE);
+            FillDibRect(s_backBuffer, s_backDirty, 0);
+            s_backDirty = BlitToDib(s_backBuffer, s_surface, origin.x - state.monitorX, origin.y - state.monitorY);
+        }
+        if (hud) {
+            // 面板区域并入脏矩形，关闭面板后的下一帧会一并清掉
+            RECT panel = DrawStatsHud(s_backBuffer);
+            UnionRect(&s_backDirty, &s_backDirty, &panel);
+        }
+
+        POINT ptDst = { state.monitorX, state.monitorY };
+        SIZE size = { s_backBuffer.width, s_backBuffer.height };
+        ScopedTraceStage trace(TRACE_PRESENT);
+        if (!UpdateLayeredWindow(hwnd, nullptr, &ptDst, &size, s_backBuffer.dc, &ptSrc, 0, &blend, ULW_ALPHA)) {
+            return stats;
+        }
+    }
 
-    SelectObject(hdcMem, hOldBitmap);
-    DeleteObject(hBitmap);
-    DeleteDC(hdcMem);
-    ReleaseDC(nullptr, hdcScreen);
+    s_presentedValid = true;
+    s_presentedEmpty = false;
+    s_presentedFit = fit;
+    s_presentedHud = hud;
+    s_presentedSerial = s_surfaceSerial;
+    s_presentedOrigin = origin;
+    s_presentedMonitor = { state.monitorX, state.monitorY,
+                           state.monitorX + state.monitorWidth, state.monitorY + state.monitorHeight };
+    stats.presented = true;
+    return stats;
 }
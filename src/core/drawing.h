@@ -1,9 +1,25 @@
 #pragma once
 
 #include <windows.h>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include "renderstate.h"
+#include "lastframe.h"
 
-void DrawTransparentWindow(HWND hwnd);                  // 绘制透明叠加图片到主窗口
-std::wstring FindLatestImage(const std::wstring& dir);   // 返回目录中修改时间最新的图片
+// 一次绘制调用的结果：是否重新生成了像素、是否向窗口提交了画面
+struct FrameStats {
+    bool rendered = false;
+    bool presented = false;
+};
+
+FrameStats DrawTransparentWindow(HWND hwnd, const RenderState& state); // 按快照绘制透明叠加图片到主窗口（仅在渲染线程调用）
+void OnDisplayChange();                                  // 显示设置变化时重建后备缓冲（仅在渲染线程调用）
+ULONGLONG GetRefineDueTick();                            // 交互预览后需补做完整质量重绘的时间点，0 表示无
+void MarkInteraction();                                  // 记录一次交互（拖动/连续调节），交互期间使用快速预览渲染
+std::wstring FindLatestImage(const std::wstring& dir, int64_t* outTime = nullptr); // 返回目录中修改时间最新的图片
 void SwitchImage(int direction);                          // 切换图片 (-1=上一张, +1=下一张)
 void ReloadLatestImage();                                // 强制加载目录中最新图片
+void SetRestoredFrame(std::shared_ptr<const LastFrame> frame); // 交出启动时已提交的上次画面（须在 StartRenderThread 之前调用）
+bool CaptureLastFrame(LastFrame* frame);                 // 取出最后提交的完整质量画面（须在 StopRenderThread 之后调用）
+void UpdateAutoLoadedImage();                            // 自动加载模式下切换到目录中新出现的图片（仅在渲染线程调用）
@@ -0,0 +1,208 @@
+#include "effects.h"
+#include "simd.h"
+#include <cmath>
+
+// ============ 定点参数 ============
+// 黑白化权重 (0.299, 0.587, 0.114) * 256，和为 256
+static const uint32_t GRAY_R = 77, GRAY_G = 150, GRAY_B = 29;
+// 去白底阈值：分量 > 240 视为白色
+static const uint32_t WHITE_THRESHOLD = 240;
+
+// 透明度转为 0~256 的定点系数
+static uint32_t OpacityToFixed(float opacity) {
+    if (!(opacity > 0.0f)) return 0;
+    if (opacity >= 1.0f) return 256;
+    return (uint32_t)lroundf(opacity * 256.0f);
+}
+
+// x / 255 四舍五入（x <= 255*255）
+static inline uint32_t Div255(uint32_t x) {
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+// ============ 标量参考实现 ============
+static void EffectsRowScalar(const uint32_t* src, uint32_t* dst, int width,
+                             bool removeWhite, bool gray, uint32_t op) {
+    for (int x = 0; x < width; x++) {
+        uint32_t px = src[x];
+        uint32_t b = px & 0xFF;
+        uint32_t g = (px >> 8) & 0xFF;
+        uint32_t r = (px >> 16) & 0xFF;
+        uint32_t a = px >> 24;
+
+        bool keyed = removeWhite && r > WHITE_THRESHOLD && g > WHITE_THRESHOLD && b > WHITE_THRESHOLD;
+
+        if (gray) {
+            uint32_t y = (GRAY_R * r + GRAY_G * g + GRAY_B * b + 128) >> 8;
+            r = g = b = y;
+        }
+
+        a = keyed ? 0 : (a * op + 128) >> 8;
+        dst[x] = Div255(b * a) | (Div255(g * a) << 8) | (Div255(r * a) << 16) | (a << 24);
+    }
+}
+
+#if GD_X86
+// ============ SSE2：每次 4 像素 ============
+GD_TARGET_SSE2
+static void EffectsRowSse2(const uint32_t* src, uint32_t* dst, int width,
+                           bool removeWhite, bool gray, uint32_t op) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i rgbMask = _mm_set1_epi32(0x00FFFFFF);
+    const __m128i alphaMask = _mm_set1_epi32((int)0xFF000000);
+    const __m128i white = _mm_set1_epi8((char)(WHITE_THRESHOLD + 1));
+    const __m128i keyEnable = removeWhite ? _mm_set1_epi32(-1) : zero;
+    const __m128i grayW = _mm_setr_epi16(GRAY_B, GRAY_G, GRAY_R, 0, GRAY_B, GRAY_G, GRAY_R, 0);
+    const __m128i opV = _mm_set1_epi32((int)op);
+    const __m128i round32 = _mm_set1_epi32(128);
+    const __m128i round16 = _mm_set1_epi16(128);
+
+    int x = 0;
+    for (; x + 4 <= width; x += 4) {
+        __m128i px = _mm_loadu_si128((const __m128i*)(src + x));
+
+        // 去白底：B/G/R 三个字节都 >= 241 的像素
+        __m128i ge = _mm_cmpeq_epi8(_mm_max_epu8(px, white), px);
+        __m128i keyed = _mm_and_si128(_mm_cmpeq_epi32(_mm_and_si128(ge, rgbMask), rgbMask), keyEnable);
+
+        // 黑白化：madd 得到 (29b+150g, 77r)，再两两相加
+        if (gray) {
+            __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(px, zero), grayW);
+            __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(px, zero), grayW);
+            lo = _mm_add_epi32(lo, _mm_srli_epi64(lo, 32));
+            hi = _mm_add_epi32(hi, _mm_srli_epi64(hi, 32));
+            lo = _mm_shuffle_epi32(lo, _MM_SHUFFLE(3, 1, 2, 0));
+            hi = _mm_shuffle_epi32(hi, _MM_SHUFFLE(3, 1, 2, 0));
+            __m128i y = _mm_srli_epi32(_mm_add_epi32(_mm_unpacklo_epi64(lo, hi), round32), 8);
+            y = _mm_or_si128(y, _mm_or_si128(_mm_slli_epi32(y, 8), _mm_slli_epi32(y, 16)));
+            px = _mm_or_si128(_mm_and_si128(px, alphaMask), y);
+        }
+
+        // 透明度：a' = (a * op + 128) >> 8，去白底的像素 a' = 0
+        __m128i a = _mm_srli_epi32(px, 24);
+        a = _mm_srli_epi32(_mm_add_epi32(_mm_mullo_epi16(a, opV), round32), 8);
+        a = _mm_andnot_si128(keyed, a);
+
+        // 预乘：每个分量乘 a' 后除以 255
+        __m128i a16 = _mm_packs_epi32(a, a);
+        a16 = _mm_unpacklo_epi16(a16, a16);
+        __m128i aLo = _mm_unpacklo_epi32(a16, a16);
+        __m128i aHi = _mm_unpackhi_epi32(a16, a16);
+
+        __m128i cLo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(px, zero), aLo), round16);
+        __m128i cHi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(px, zero), aHi), round16);
+        cLo = _mm_srli_epi16(_mm_add_epi16(cLo, _mm_srli_epi16(cLo, 8)), 8);
+        cHi = _mm_srli_epi16(_mm_add_epi16(cHi, _mm_srli_epi16(cHi, 8)), 8);
+
+        __m128i out = _mm_and_si128(_mm_packus_epi16(cLo, cHi), rgbMask);
+        out = _mm_or_si128(out, _mm_slli_epi32(a, 24));
+        _mm_storeu_si128((__m128i*)(dst + x), out);
+    }
+    EffectsRowScalar(src + x, dst + x, width - x, removeWhite, gray, op);
+}
+
+// ============ AVX2：每次 8 像素，算法与 SSE2 相同（unpack/pack 均在 128 位通道内） ============
+GD_TARGET_AVX2
+static void EffectsRowAvx2(const uint32_t* src, uint32_t* dst, int width,
+                           bool removeWhite, bool gray, uint32_t op) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i rgbMask = _mm256_set1_epi32(0x00FFFFFF);
+    const __m256i alphaMask = _mm256_set1_epi32((int)0xFF000000);
+    const __m256i white = _mm256_set1_epi8((char)(WHITE_THRESHOLD + 1));
+    const __m256i keyEnable = removeWhite ? _mm256_set1_epi32(-1) : zero;
+    const __m256i grayW = _mm256_setr_epi16(GRAY_B, GRAY_G, GRAY_R, 0, GRAY_B, GRAY_G, GRAY_R, 0,
+                                            GRAY_B, GRAY_G, GRAY_R, 0, GRAY_B, GRAY_G, GRAY_R, 0);
+    const __m256i opV = _mm256_set1_epi32((int)op);
+    const __m256i round32 = _mm256_set1_epi32(128);
+    const __m256i round16 = _mm256_set1_epi16(128);
+
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+        __m256i px = _mm256_loadu_si256((const __m256i*)(src + x));
+
+        __m256i ge = _mm256_cmpeq_epi8(_mm256_max_epu8(px, white), px);
+        __m256i keyed = _mm256_and_si256(_mm256_cmpeq_epi32(_mm256_and_si256(ge, rgbMask), rgbMask), keyEnable);
+
+        if (gray) {
+            __m256i lo = _mm256_madd_epi16(_mm256_unpacklo_epi8(px, zero), grayW);
+            __m256i hi = _mm256_madd_epi16(_mm256_unpackhi_epi8(px, zero), grayW);
+            lo = _mm256_add_epi32(lo, _mm256_srli_epi64(lo, 32));
+            hi = _mm256_add_epi32(hi, _mm256_srli_epi64(hi, 32));
+            lo = _mm256_shuffle_epi32(lo, _MM_SHUFFLE(3, 1, 2, 0));
+            hi = _mm256_shuffle_epi32(hi, _MM_SHUFFLE(3, 1, 2, 0));
+            __m256i y = _mm256_srli_epi32(_mm256_add_epi32(_mm256_unpacklo_epi64(lo, hi), round32), 8);
+            y = _mm256_or_si256(y, _mm256_or_si256(_mm256_slli_epi32(y, 8), _mm256_slli_epi32(y, 16)));
+            px = _mm256_or_si256(_mm256_and_si256(px, alphaMask), y);
+        }
+
+        __m256i a = _mm256_srli_epi32(px, 24);
+        a = _mm256_srli_epi32(_mm256_add_epi32(_mm256_mullo_epi16(a, opV), round32), 8);
+        a = _mm256_andnot_si256(keyed, a);
+
+        __m256i a16 = _mm256_packs_epi32(a, a);
+        a16 = _mm256_unpacklo_epi16(a16, a16);
+        __m256i aLo = _mm256_unpacklo_epi32(a16, a16);
+        __m256i aHi = _mm256_unpackhi_epi32(a16, a16);
+
+        __m256i cLo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(px, zero), aLo), round16);
+        __m256i cHi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(px, zero), aHi), round16);
+        cLo = _mm256_srli_epi16(_mm256_add_epi16(cLo, _mm256_srli_epi16(cLo, 8)), 8);
+        cHi = _mm256_srli_epi16(_mm256_add_epi16(cHi, _mm256_srli_epi16(cHi, 8)), 8);
+
+        __m256i out = _mm256_and_si256(_mm256_packus_epi16(cLo, cHi), rgbMask);
+        out = _mm256_or_si256(out, _mm256_slli_epi32(a, 24));
+        _mm256_storeu_si256((__m256i*)(dst + x), out);
+    }
+    EffectsRowSse2(src + x, dst + x, width - x, removeWhite, gray, op);
+}
+#endif
+
+bool IsEffectKernelSupported(EffectKernel kernel) {
+    switch (kernel) {
+        case EffectKernel::Auto:
+        case EffectKernel::Scalar: return true;
+        case EffectKernel::SSE2:   return CpuHasSse2();
+        case EffectKernel::AVX2:   return CpuHasAvx2();
+    }
+    return false;
+}
+
+const char* EffectKernelName(EffectKernel kernel) {
+    switch (kernel) {
+        case EffectKernel::Auto:   return "auto";
+        case EffectKernel::Scalar: return "scalar";
+        case EffectKernel::SSE2:   return "sse2";
+        case EffectKernel::AVX2:   return "avx2";
+    }
+    return "unknown";
+}
+
+typedef void (*EffectsRowFn)(const uint32_t*, uint32_t*, int, bool, bool, uint32_t);
+
+// 选择行处理函数；请求的实现不受支持时退回标量
+static EffectsRowFn SelectRowFn(EffectKernel kernel) {
+#if GD_X86
+    static const bool hasAvx2 = CpuHasAvx2();
+    static const bool hasSse2 = CpuHasSse2();
+    if (kernel == EffectKernel::Auto) {
+        kernel = hasAvx2 ? EffectKernel::AVX2 : (hasSse2 ? EffectKernel::SSE2 : EffectKernel::Scalar);
+    }
+    if (kernel == EffectKernel::AVX2 && hasAvx2) return EffectsRowAvx2;
+    if (kernel == EffectKernel::SSE2 && hasSse2) return EffectsRowSse2;
+#else
+    (void)kernel;
+#endif
+    return EffectsRowScalar;
+}
+
+void ApplyEffects(const uint32_t* src, int srcStride, uint32_t* dst, int dstStride,
+                  int width, int height, const EffectParams& params, EffectKernel kernel) {
+    if (width <= 0 || height <= 0) return;
+    EffectsRowFn rowFn = SelectRowFn(kernel);
+    uint32_t op = OpacityToFixed(params.opacity);
+    for (int y = 0; y < height; y++) {
+        rowFn(src + (size_t)y * srcStride, dst + (size_t)y * dstStride, width,
+              params.removeWhite, params.grayscale, op);
+    }
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+
+// ============ 像素效果内核（与 Win32 无关，可在任意平台编译） ============
+// 像素格式为内存顺序 B,G,R,A 的 32 位像素（即 GDI+ 的 32bppARGB / 32bppPARGB）
+
+// 效果参数
+struct EffectParams {
+    bool removeWhite = false; // 去白底：R/G/B 均大于 240 的像素置为全透明
+    bool grayscale = false;   // 黑白化
+    float opacity = 1.0f;     // 整体透明度 (0.0~1.0)
+};
+
+// 内核实现，Auto 按运行时 CPU 能力自动选择
+enum class EffectKernel { Auto, Scalar, SSE2, AVX2 };
+
+// 单趟完成 去白底 + 黑白化 + 透明度 + 预乘：src 为直通 alpha，dst 输出预乘 alpha
+// stride 以像素为单位；src 与 dst 可以指向同一块内存（原地处理）
+// 所有实现均为定点运算，输出逐位一致，标量版本即参考实现
+void ApplyEffects(const uint32_t* src, int srcStride, uint32_t* dst, int dstStride,
+                  int width, int height, const EffectParams& params,
+                  EffectKernel kernel = EffectKernel::Auto);
+
+bool IsEffectKernelSupported(EffectKernel kernel); // 当前 CPU 是否可运行该实现
+const char* EffectKernelName(EffectKernel kernel); // 实现名称（用于基准测试输出）
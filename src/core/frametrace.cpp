@@ -0,0 +1,116 @@
+#include "frametrace.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+FrameTrace::FrameTrace(size_t capacity) : m_origin(std::chrono::steady_clock::now()) {
+    m_events.resize(std::max<size_t>(1, capacity));
+}
+
+void FrameTrace::Append(uint8_t kind, double startMs, double durationMs) {
+    uint32_t frame = m_frame.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_events[m_next] = { startMs, (float)durationMs, frame, kind };
+    m_next = (m_next + 1) % m_events.size();
+    if (m_size < m_events.size()) m_size++;
+    m_total++;
+}
+
+void FrameTrace::Record(TraceStage stage, double startMs, double durationMs) {
+    if (stage < 0 || stage >= TRACE_STAGE_COUNT) return;
+    Append((uint8_t)stage, startMs, durationMs);
+}
+
+void FrameTrace::Count(TraceCounter counter) {
+    if (counter < 0 || counter >= TRACE_COUNTER_COUNT) return;
+    m_counters[counter].fetch_add(1, std::memory_order_relaxed);
+    Append((uint8_t)((int)TRACE_STAGE_COUNT + counter), NowMs(), 0.0);
+}
+
+StageSummary FrameTrace::Summarize(TraceStage stage, int window) const {
+    StageSummary summary;
+    if (stage < 0 || stage >= TRACE_STAGE_COUNT || window <= 0) return summary;
+
+    // 从最新的记录往回找，锁内只做拷贝
+    std::vector<float> samples;
+    samples.reserve(window);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        size_t pos = m_next;
+        for (size_t i = 0; i < m_size && (int)samples.size() < window; i++) {
+            pos = (pos + m_events.size() - 1) % m_events.size();
+            if (m_events[pos].kind == stage) samples.push_back(m_events[pos].durationMs);
+        }
+    }
+    if (samples.empty()) return summary;
+
+    // 最近邻秩分位数：p 分位取第 ceil(p * n) 小的样本
+    auto rank = [&samples](double p) {
+        size_t k = (size_t)std::max(1.0, std::ceil(p * samples.size())) - 1;
+        std::nth_element(samples.begin(), samples.begin() + k, samples.end());
+        return (double)samples[k];
+    };
+    summary.samples = (int)samples.size();
+    summary.max = *std::max_element(samples.begin(), samples.end());
+    summary.p95 = rank(0.95);
+    summary.p50 = rank(0.50);
+    return summary;
+}
+
+std::string FrameTrace::ToCsv(TraceExportInfo* info) const {
+    std::vector<Event> events;
+    TraceExportInfo range;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        events.reserve(m_size);
+        size_t first = (m_next + m_events.size() - m_size) % m_events.size();
+        for (size_t i = 0; i < m_size; i++) events.push_back(m_events[(first + i) % m_events.size()]);
+        range.events = m_size;
+        range.dropped = m_total - m_size;
+    }
+    // 解码、扫描线程的记录在结束时才写入，按开始时间重新排序
+    std::stable_sort(events.begin(), events.end(),
+                     [](const Event& a, const Event& b) { return a.startMs < b.startMs; });
+    if (!events.empty()) {
+        auto [lo, hi] = std::minmax_element(events.begin(), events.end(),
+                                            [](const Event& a, const Event& b) { return a.frame < b.frame; });
+        range.firstFrame = lo->frame;
+        range.lastFrame = hi->frame;
+    }
+    if (info) *info = range;
+
+    char line[160];
+    if (range.dropped > 0) {
+        snprintf(line, sizeof(line), "# newest %zu events (ring capacity %zu), frames %u-%u; %llu older events overwritten\n",
+                 range.events, m_events.size(), range.firstFrame, range.lastFrame, (unsigned long long)range.dropped);
+    } else {
+        snprintf(line, sizeof(line), "# all %zu events of the session, frames %u-%u\n", range.events,
+                 range.firstFrame, range.lastFrame);
+    }
+    std::string csv = line;
+    csv += "frame,start_ms,stage,duration_ms\n";
+    for (const Event& e : events) {
+        const char* name = e.kind < TRACE_STAGE_COUNT ? StageName((TraceStage)e.kind)
+                                                      : CounterName((TraceCounter)(e.kind - (int)TRACE_STAGE_COUNT));
+        snprintf(line, sizeof(line), "%u,%.3f,%s,%.3f\n", e.frame, e.startMs, name, e.durationMs);
+        csv += line;
+    }
+    return csv;
+}
+
+const char* FrameTrace::StageName(TraceStage stage) {
+    static const char* names[TRACE_STAGE_COUNT] = {
+        "scan", "decode", "effects", "resample", "rotate", "compose", "present", "frame",
+    };
+    return stage >= 0 && stage < TRACE_STAGE_COUNT ? names[stage] : "unknown";
+}
+
+const char* FrameTrace::CounterName(TraceCounter counter) {
+    static const char* names[TRACE_COUNTER_COUNT] = { "cache_hit", "cache_miss", "frame_skipped" };
+    return counter >= 0 && counter < TRACE_COUNTER_COUNT ? names[counter] : "unknown";
+}
+
+FrameTrace& SessionTrace() {
+    static FrameTrace trace;
+    return trace;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// ============ 帧耗时记录（与 Win32 无关，可在任意平台编译） ============
+// 渲染各阶段用高精度计时器计时，结果写入定长环形缓冲（写满后覆盖最早的记录），
+// 叠加层角落的统计面板从中取最近若干次的 p50/p95/最大值，托盘菜单可把缓冲中的记录导出为 CSV。
+// 缓冲容量固定，运行时间长时导出的只是最近的一段，CSV 首行注明覆盖范围与被覆盖的条数。
+// 每次记录只是一次加锁追加，常开也不影响帧率
+
+enum TraceStage {
+    TRACE_SCAN = 0,     // 目录扫描（完整扫描或应用一批变更通知）
+    TRACE_DECODE,       // 解码线程解码一张图片（含 mip 预构建，不含磁盘缓存命中）
+    TRACE_EFFECTS,      // 去白底/黑白化/透明度/预乘
+    TRACE_RESAMPLE,     // 缩放重采样
+    TRACE_ROTATE,       // 任意角度旋转
+    TRACE_COMPOSE,      // 合成到全屏后备缓冲
+    TRACE_PRESENT,      // UpdateLayeredWindow
+    TRACE_FRAME,        // 渲染线程处理一帧的总耗时
+    TRACE_STAGE_COUNT
+};
+
+enum TraceCounter {
+    TRACE_CACHE_HIT = 0,   // 绘制时解码缓存命中
+    TRACE_CACHE_MISS,      // 绘制时图片尚未解码
+    TRACE_FRAME_SKIPPED,   // 渲染状态未变而整帧跳过
+    TRACE_COUNTER_COUNT
+};
+
+// ToCsv 导出的范围
+struct TraceExportInfo {
+    size_t events = 0;       // 导出的记录数
+    uint64_t dropped = 0;    // 缓冲写满后被覆盖、未能导出的更早记录数
+    uint32_t firstFrame = 0; // 导出记录中最早/最晚的帧序号
+    uint32_t lastFrame = 0;
+};
+
+struct StageSummary {
+    int samples = 0;   // 参与统计的次数
+    double p50 = 0.0;  // 毫秒
+    double p95 = 0.0;
+    double max = 0.0;
+};
+
+class FrameTrace {
+public:
+    // 默认容量约 13 万条（3 MB），全速渲染时约合 1.6 万帧
+    explicit FrameTrace(size_t capacity = 131072);
+
+    // 自创建起的毫秒数（steady_clock，Windows 上即 QueryPerformanceCounter）
+    double NowMs() const {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_origin).count();
+    }
+
+    // 开始新的一帧：之后的记录（包括其他线程的）都归入这一帧，返回帧序号
+    uint32_t BeginFrame() { return ++m_frame; }
+    // 记录一个阶段的耗时（任意线程调用）
+    void Record(TraceStage stage, double startMs, double durationMs);
+    // 计数加一，同时在记录中留下一条耗时为 0 的事件，导出的 CSV 可以看到发生时刻
+    void Count(TraceCounter counter);
+
+    uint64_t Counter(TraceCounter counter) const { return m_counters[counter].load(std::memory_order_relaxed); }
+    uint32_t FrameCount() const { return m_frame.load(std::memory_order_relaxed); }
+    // 该阶段最近 window 次记录的分位数
+    StageSummary Summarize(TraceStage stage, int window = 240) const;
+    // 按时间顺序导出缓冲中现存的记录（最近 Capacity() 条）：首行为 # 开头的范围说明，
+    // 其后为 frame,start_ms,stage,duration_ms。info 非空时返回导出范围
+    std::string ToCsv(TraceExportInfo* info = nullptr) const;
+    size_t Capacity() const { return m_events.size(); }
+
+    static const char* StageName(TraceStage stage);
+    static const char* CounterName(TraceCounter counter);
+
+private:
+    struct Event {
+        double startMs;
+        float durationMs;
+        uint32_t frame;
+        uint8_t kind;      // 0..TRACE_STAGE_COUNT-1 为阶段，其后为计数器
+    };
+    void Append(uint8_t kind, double startMs, double durationMs);
+
+    std::chrono::steady_clock::time_point m_origin;
+    mutable std::mutex m_mutex;      // 保护 m_events / m_next / m_size / m_total
+    std::vector<Event> m_events;
+    size_t m_next = 0;               // 下一条写入的位置
+    size_t m_size = 0;               // 有效记录数，写满后等于容量
+    uint64_t m_total = 0;            // 创建以来写入的总条数（含已被覆盖的）
+    std::atomic<uint32_t> m_frame{0};
+    std::atomic<uint64_t> m_counters[TRACE_COUNTER_COUNT] = {};
+};
+
+// 进程内唯一的记录
+FrameTrace& SessionTrace();
+
+// 作用域计时：构造时开始，析构时记录到 SessionTrace()
+class ScopedTraceStage {
+public:
+    explicit ScopedTraceStage(TraceStage stage) : m_stage(stage), m_start(SessionTrace().NowMs()) {}
+    ~ScopedTraceStage() { SessionTrace().Record(m_stage, m_start, SessionTrace().NowMs() - m_start); }
+    ScopedTraceStage(const ScopedTraceStage&) = delete;
+    ScopedTraceStage& operator=(const ScopedTraceStage&) = delete;
+
+private:
+    TraceStage m_stage;
+    double m_start;
+};
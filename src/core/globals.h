@@ -26,7 +26,10 @@ enum HotkeyAction {
     HK_NEXT_IMAGE,      // 下一张图片
     HK_ROTATE_CW,       // 顺时针旋转90°
     HK_ROTATE_CCW,      // 逆时针旋转90°
+    HK_MIRROR_H,        // 左右镜像
+    HK_MIRROR_V,        // 上下镜像
     HK_SCREENSHOT,      // 区域截图
+    HK_TOGGLE_STATS,    // 显示/隐藏帧耗时统计
     HK_COUNT
 };
 
@@ -51,12 +54,26 @@ extern std::atomic<float> scaleFactor;     // 图片缩放比例 (0.1~3.0)
 extern std::atomic<float> opacityFactor;   // 图片透明度 (0.0~1.0)
 extern std::atomic<bool> grayscaleEnabled; // 黑白化开关
 extern std::atomic<bool> removeWhiteBg;    // 去白底开关
-extern std::atomic<bool> reloadImage;      // 触发重绘标志
 extern std::atomic<bool> autoLoadLatest;   // 自动加载目录最新图片
-extern std::atomic<int> rotationAngle;     // 旋转角度 (0/90/180/270)
+extern std::atomic<int> rotationAngle;     // 旋转角度（顺时针，0~350，步长 10°）
+extern std::atomic<bool> mirrorHorizontal; // 左右镜像（在旋转之前应用）
+extern std::atomic<bool> mirrorVertical;   // 上下镜像（在旋转之前应用）
+extern std::atomic<bool> fitWindowToImage; // 窗口贴合图片包围盒（拖动只移动窗口）
+extern std::atomic<int> targetMonitor;     // 叠加层所在显示器（0=主显示器，-1=跟随鼠标，n=第 n 个显示器）
+extern std::atomic<int> refineDelayMs;     // 停止交互多久后以完整质量重绘（毫秒，0=始终完整质量）
+extern std::atomic<int> prefetchCount;     // 预取当前图片前后各几张（0=关闭）
+extern std::atomic<int> cacheMemoryMB;     // 解码缓存内存上限（MB）
+extern std::atomic<int> tileMemoryMB;      // 超大图片分块缓存内存上限（MB）
+extern std::atomic<int> diskCacheMB;       // 磁盘解码缓存上限（MB，0=关闭）
+extern std::atomic<int> screenshotFormat;  // 截图保存格式（0=PNG，1=QOI）
+extern std::atomic<int> pngCompression;    // PNG 压缩档位（0=最快，1=均衡，2=最小）
+extern std::atomic<bool> showFrameStats;   // 叠加层左上角显示帧耗时统计（不保存到配置）
 
-extern std::wstring currentImagePath;      // 当前显示的图片路径
-extern std::wstring imageDirectory;        // 图片目录
+// 图片路径与目录保存在渲染状态快照中，跨线程只能通过以下函数读写（实现见 renderstate.cpp）
+std::wstring GetCurrentImagePath();        // 当前显示的图片路径
+void SetCurrentImagePath(const std::wstring& path);
+std::wstring GetImageDirectory();          // 图片目录
+void SetImageDirectory(const std::wstring& dir);
 
 extern std::atomic<int> windowOffsetX;     // 拖动偏移 X
 extern std::atomic<int> windowOffsetY;     // 拖动偏移 Y
@@ -70,11 +87,13 @@ extern NOTIFYICONDATAW g_nid;              // 托盘图标数据
 // ============ 托盘菜单命令 ============
 #define WM_TRAYICON          (WM_USER + 1)
 #define WM_START_SCREENSHOT  (WM_USER + 2)
+#define WM_HOTKEY_ACTION     (WM_USER + 3)  // 钩子线程投递给主窗口：wParam 为要执行的 HotkeyAction
 #define HOTKEY_ID_SCREENSHOT 0x0001  // RegisterHotKey 的全局热键 ID
 #define IDM_SHOW_HIDE    1001
 #define IDM_SETTINGS     1002
 #define IDM_RELOAD       1003
 #define IDM_EXIT         1004
+#define IDM_EXPORT_TRACE 1005
 
 // ============ 设置面板控件 ID ============
 #define IDC_SLIDER_OPACITY    2001
@@ -96,5 +115,9 @@ extern NOTIFYICONDATAW g_nid;              // 托盘图标数据
 
 // ============ 配置持久化 ============
 const wchar_t* GetConfigPath(); // 返回 INI 文件完整路径
+// 程序自身的数据目录 %LOCALAPPDATA%\GuessDraw（磁盘缓存、上次画面、启动记录），首次调用时创建；取不到时为空
+const std::wstring& GetLocalDataDirectory();
 void LoadConfig();               // 从 INI 加载配置，首次运行自动生成
-void SaveConfig();               // 保存当前配置到 INI
+void SaveConfig();               // 保存当前配置到 INI（立即写盘）
+void RequestSaveConfig();        // 延迟保存：短时间内的多次修改合并为一次写盘（仅在主窗口线程调用）
+void FlushConfig();              // 退出前写出尚未保存的修改
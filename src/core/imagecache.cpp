@@ -0,0 +1,389 @@
+#include "imagecache.h"
+#include "globals.h"
+#include "dirwatch.h"
+#include "diskcache.h"
+#include "render.h"
+#include "renderstate.h"
+#include "qoi.h"
+#include "frametrace.h"
+#include <algorithm>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <thread>
+
+using namespace Gdiplus;
+
+static std::mutex s_cacheMutex;                          // 保护以下全部状态
+static std::condition_variable s_cacheCv;
+static std::list<std::shared_ptr<DecodedImage>> s_cache;  // 头部为最近使用
+static std::atomic<uint64_t> s_decodeGeneration(0);
+
+static std::wstring s_currentPath;                       // 正在显示的图片，永不淘汰
+static std::vector<std::wstring> s_prefetchQueue;        // 待预取路径，按优先级排列
+static std::vector<std::wstring> s_wantedPaths;          // 当前中心附近需要保留的图片
+static std::wstring s_prefetchCenter;
+static std::wstring s_inflightPath;                      // 解码线程正在解码的文件
+static std::thread s_decodeThread;
+static bool s_decodeStop = false;
+
+// 读取文件的修改时间和大小（一次系统调用，远比解码便宜）
+static bool GetFileIdentity(const std::wstring& path, ULONGLONG* mtime, ULONGLONG* size) {
+    WIN32_FILE_ATTRIBUTE_DATA fad;
+    if (!GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &fad)) return false;
+    *mtime = ((ULONGLONG)fad.ftLastWriteTime.dwHighDateTime << 32) | fad.ftLastWriteTime.dwLowDateTime;
+    *size  = ((ULONGLONG)fad.nFileSizeHigh << 32) | fad.nFileSizeLow;
+    return true;
+}
+
+uint64_t NewImageGeneration() {
+    return ++s_decodeGeneration;
+}
+
+// 超大图片只解码常驻缩略级，原图留给分块线程按需解码
+static std::shared_ptr<DecodedImage> DecodeTiledImage(const std::wstring& path, ULONGLONG mtime, ULONGLONG size,
+                                                      int width, int height) {
+    auto image = std::make_shared<DecodedImage>();
+    image->tiled = OpenTiledImage(path, width, height, &image->pixels, &image->width, &image->height);
+    if (!image->tiled) return nullptr;
+
+    image->path = path;
+    image->mtime = mtime;
+    image->size = size;
+    image->generation = NewImageGeneration();
+    image->bytes = image->pixels.size() * 4 * 4 / 3;
+    image->mips.Reset(image->pixels.data(), image->width, image->height);
+    return image;
+}
+
+static bool IsQoiPath(const std::wstring& path) {
+    size_t dot = path.find_last_of(L'.');
+    return dot != std::wstring::npos && lstrcmpiW(path.c_str() + dot, L".qoi") == 0;
+}
+
+// QOI（截图的快速格式）：GDI+ 与 WIC 都不认识，整个读入后直接解码到自有缓冲区
+static std::shared_ptr<DecodedImage> DecodeQoiFile(const std::wstring& path, ULONGLONG mtime, ULONGLONG size) {
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return nullptr;
+    std::vector<uint8_t> data;
+    LARGE_INTEGER fileSize;
+    DWORD read = 0;
+    bool ok = GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0 && fileSize.QuadPart < 0x7FFFFFFF;
+    if (ok) {
+        data.resize((size_t)fileSize.QuadPart);
+        ok = ReadFile(file, data.data(), (DWORD)data.size(), &read, nullptr) && read == data.size();
+    }
+    CloseHandle(file);
+
+    auto image = std::make_shared<DecodedImage>();
+    QoiHeader header;
+    if (!ok || !DecodeQoi(data.data(), data.size(), &image->pixels, &header)) return nullptr;
+
+    image->path = path;
+    image->mtime = mtime;
+    image->size = size;
+    image->generation = NewImageGeneration();
+    image->width = header.width;
+    image->height = header.height;
+    image->bytes = image->pixels.size() * 4 * 4 / 3;
+    image->mips.Reset(image->pixels.data(), image->width, image->height);
+    return image;
+}
+
+// 解码整个文件到自有内存，可在任意线程调用（须已初始化 COM）
+static std::shared_ptr<DecodedImage> DecodeImageFile(const std::wstring& path, ULONGLONG mtime, ULONGLONG size) {
+    if (IsQoiPath(path)) return DecodeQoiFile(path, mtime, size);
+    int probeW = 0, probeH = 0;
+    if (ProbeImageSize(path, &probeW, &probeH) && ShouldDecodeTiled(probeW, probeH)) {
+        return DecodeTiledImage(path, mtime, size, probeW, probeH);
+    }
+
+    Bitmap file(path.c_str());
+    if (file.GetLastStatus() != Ok) return nullptr;
+    UINT w = file.GetWidth();
+    UINT h = file.GetHeight();
+    if (w == 0 || h == 0) return nullptr;
+
+    // 通过 UserInputBuf 让 GDI+ 直接解码/转换到自有缓冲区
+    auto image = std::make_shared<DecodedImage>();
+    image->pixels.resize((size_t)w * h);
+    BitmapData data = {};
+    data.Width = w;
+    data.Height = h;
+    data.Stride = (INT)(w * 4);
+    data.PixelFormat = PixelFormat32bppARGB;
+    data.Scan0 = image->pixels.data();
+    Rect rect(0, 0, (INT)w, (INT)h);
+    if (file.LockBits(&rect, ImageLockModeRead | ImageLockModeUserInputBuf, PixelFormat32bppARGB, &data) != Ok) {
+        return nullptr;
+    }
+    file.UnlockBits(&data);
+
+    image->path = path;
+    image->mtime = mtime;
+    image->size = size;
+    image->generation = NewImageGeneration();
+    image->width = (int)w;
+    image->height = (int)h;
+    image->bytes = image->pixels.size() * 4 * 4 / 3; // 完整 mip 链最多再占 1/3
+    image->mips.Reset(image->pixels.data(), image->width, image->height);
+    return image;
+}
+
+// 调用方持有 s_cacheMutex；命中时移到 LRU 头部
+static std::shared_ptr<DecodedImage> FindCachedLocked(const std::wstring& path, ULONGLONG mtime, ULONGLONG size) {
+    for (auto it = s_cache.begin(); it != s_cache.end(); ++it) {
+        const DecodedImage& e = **it;
+        if (e.path != path) continue;
+        if (!e.pending && (e.mtime != mtime || e.size != size)) {
+            s_cache.erase(it); // 文件已变化，旧结果作废
+            return nullptr;
+        }
+        s_cache.splice(s_cache.begin(), s_cache, it);
+        return s_cache.front();
+    }
+    return nullptr;
+}
+
+static bool IsWantedLocked(const std::wstring& path) {
+    return path == s_currentPath ||
+           std::find(s_wantedPaths.begin(), s_wantedPaths.end(), path) != s_wantedPaths.end();
+}
+
+// 调用方持有 s_cacheMutex。为 image 腾出空间后插入到头部
+// force = false（预取）时只淘汰不再需要的图片，腾不出空间就放弃插入
+static bool InsertLocked(const std::shared_ptr<DecodedImage>& image, bool force) {
+    size_t cap = (size_t)std::max(0, cacheMemoryMB.load()) * 1024 * 1024;
+    size_t used = 0;
+    for (const auto& e : s_cache) used += e->bytes;
+
+    // 从最久未用的开始淘汰：第一趟只淘汰预取窗口外的图片，仍不够时（仅 force）再淘汰窗口内的
+    for (int pass = 0; pass < (force ? 2 : 1) && used + image->bytes > cap; pass++) {
+        for (auto it = s_cache.end(); it != s_cache.begin() && used + image->bytes > cap;) {
+            --it;
+            const std::wstring& p = (*it)->path;
+            if (p == s_currentPath || (pass == 0 && IsWantedLocked(p))) continue;
+            used -= (*it)->bytes;
+            it = s_cache.erase(it);
+        }
+    }
+    if (!force && used + image->bytes > cap) return false;
+    s_cache.push_front(image);
+    return true;
+}
+
+// ============ 解码线程 ============
+// 同一个后台线程负责当前图片（优先）和相邻图片的预取，UI 线程只查缓存、不解码
+struct DecodeRequest {
+    std::wstring path;
+    ULONGLONG mtime = 0;
+    ULONGLONG size = 0;
+};
+static DecodeRequest s_urgent;                           // 当前图片的解码请求，新请求直接覆盖旧的
+static DecodeRequest s_failed;                           // 最近一次解码失败的文件，内容不变时不再重试
+
+static void DecodeThread();
+
+// 调用方持有 s_cacheMutex
+static void EnsureDecodeThreadLocked() {
+    if (!s_decodeThread.joinable() && !s_decodeStop) s_decodeThread = std::thread(DecodeThread);
+}
+
+std::shared_ptr<DecodedImage> RequestDecodedImage(const std::wstring& path) {
+    ULONGLONG mtime = 0, size = 0;
+    if (path.empty()) return nullptr;
+    bool exists = GetFileIdentity(path, &mtime, &size);
+
+    std::lock_guard<std::mutex> lock(s_cacheMutex);
+    if (!exists) {
+        // 文件尚未写出的截图照样可以显示
+        for (auto it = s_cache.begin(); it != s_cache.end(); ++it) {
+            if (!(*it)->pending || (*it)->path != path) continue;
+            s_currentPath = path;
+            s_urgent = DecodeRequest();
+            s_cache.splice(s_cache.begin(), s_cache, it);
+            return s_cache.front();
+        }
+        return nullptr;
+    }
+    s_currentPath = path;
+    if (auto hit = FindCachedLocked(path, mtime, size)) {
+        s_urgent = DecodeRequest(); // 已命中，撤销尚未开始的旧请求
+        return hit;
+    }
+    if (s_failed.path == path && s_failed.mtime == mtime && s_failed.size == size) return nullptr;
+
+    // 正在解码的就是这张图时无需重复排队，完成后同样会通知主窗口
+    if (s_inflightPath != path) {
+        s_urgent.path = path;
+        s_urgent.mtime = mtime;
+        s_urgent.size = size;
+        EnsureDecodeThreadLocked();
+        s_cacheCv.notify_all();
+    }
+    return nullptr;
+}
+
+static void DecodeThread() {
+    CoInitializeEx(nullptr, COINIT_MULTITHREADED); // 探测尺寸与超大图片的缩略级走 WIC
+    std::unique_lock<std::mutex> lock(s_cacheMutex);
+    while (true) {
+        s_cacheCv.wait(lock, [] { return s_decodeStop || !s_urgent.path.empty() || !s_prefetchQueue.empty(); });
+        if (s_decodeStop) break;
+
+        // 当前图片优先；连续切换时只有最后一次请求会被取到，中间的自然被丢弃
+        DecodeRequest req;
+        if (!s_urgent.path.empty()) {
+            req = s_urgent;
+            s_urgent = DecodeRequest();
+        } else {
+            req.path = s_prefetchQueue.front();
+            s_prefetchQueue.erase(s_prefetchQueue.begin());
+            lock.unlock();
+            bool exists = GetFileIdentity(req.path, &req.mtime, &req.size);
+            lock.lock();
+            if (!exists || FindCachedLocked(req.path, req.mtime, req.size)) continue;
+        }
+
+        s_inflightPath = req.path;
+        float scale = GetRenderState()->PixelScale();
+        lock.unlock();
+
+        // 先查磁盘缓存：命中时直接映射文件，省去整个解码
+        double decodeStart = SessionTrace().NowMs();
+        std::shared_ptr<DecodedImage> image = LoadCachedImage(req.path, req.mtime, req.size);
+        bool fromDisk = image != nullptr;
+        if (!image) image = DecodeImageFile(req.path, req.mtime, req.size);
+        std::vector<const uint32_t*> levels; // 写磁盘缓存用，放入内存缓存后 mips 只能由绘制线程访问
+        if (image && !image->tiled) {
+            // 顺便按当前缩放比例建好 mip 级别，显示时只剩一次小图重采样
+            int w = std::max(1, (int)(image->width * scale));
+            int h = std::max(1, (int)(image->height * scale));
+            image->mips.SelectLevel(w, h);
+            if (!fromDisk) {
+                for (int i = 0; i < image->mips.LevelCount(); i++) levels.push_back(image->mips.Pixels(i));
+            }
+        }
+        if (!fromDisk) SessionTrace().Record(TRACE_DECODE, decodeStart, SessionTrace().NowMs() - decodeStart);
+
+        lock.lock();
+        s_inflightPath.clear();
+        if (!image) {
+            if (req.path == s_currentPath) s_failed = req;
+        } else if (req.path == s_currentPath) {
+            // 用户正等着这张图：必要时淘汰预取结果，并请求重绘换上新图
+            InsertLocked(image, true);
+            RequestRedraw();
+        } else if (IsWantedLocked(req.path) && !InsertLocked(image, false)) {
+            s_prefetchQueue.clear(); // 内存上限已满，更远的图片也放不下
+        }
+        // 解码期间用户已跳走的预取结果直接丢弃
+
+        // 显示之后再写磁盘缓存，不拖慢当前图片（各级像素缓冲区在图片释放前不会移动）
+        if (!levels.empty()) {
+            lock.unlock();
+            StoreCachedImage(*image, levels);
+            lock.lock();
+        }
+    }
+    lock.unlock();
+    CoUninitialize();
+}
+
+// 调用方持有 s_cacheMutex
+static void EraseCachedLocked(const std::wstring& path) {
+    s_cache.remove_if([&path](const std::shared_ptr<DecodedImage>& e) { return e->path == path; });
+}
+
+std::shared_ptr<const DecodedImage> InsertCapturedImage(const std::wstring& path, std::vector<uint32_t> pixels,
+                                                        int width, int height) {
+    auto image = std::make_shared<DecodedImage>();
+    image->path = path;
+    image->pending = true;
+    image->generation = NewImageGeneration();
+    image->width = width;
+    image->height = height;
+    image->pixels = std::move(pixels);
+    image->bytes = image->pixels.size() * 4 * 4 / 3;
+    image->mips.Reset(image->pixels.data(), width, height);
+
+    std::lock_guard<std::mutex> lock(s_cacheMutex);
+    EraseCachedLocked(path); // 同名文件（同一秒内的上一张截图）的旧结果
+    if (s_failed.path == path) s_failed = DecodeRequest();
+    InsertLocked(image, true);
+    return image;
+}
+
+void FinishCapturedImage(const std::wstring& path, bool written) {
+    ULONGLONG mtime = 0, size = 0;
+    written = written && GetFileIdentity(path, &mtime, &size);
+
+    std::lock_guard<std::mutex> lock(s_cacheMutex);
+    auto it = std::find_if(s_cache.begin(), s_cache.end(), [&path](const std::shared_ptr<DecodedImage>& e) {
+        return e->pending && e->path == path;
+    });
+    if (it == s_cache.end()) return; // 已被淘汰
+    std::shared_ptr<DecodedImage> pending = *it;
+    s_cache.erase(it);
+    if (!written) return;
+
+    // 绘制线程可能正在使用原项（其 mip 链只能由绘制线程访问），因此另建一项：
+    // 第 0 级直接引用原项的像素，更小的级别按需重建；图片标识不变，效果缓存照常命中
+    auto image = std::make_shared<DecodedImage>();
+    image->path = path;
+    image->mtime = mtime;
+    image->size = size;
+    image->generation = pending->generation;
+    image->width = pending->width;
+    image->height = pending->height;
+    image->bytes = pending->bytes;
+    image->mips.Reset(pending->pixels.data(), pending->width, pending->height);
+    image->pixelOwner = std::move(pending);
+    InsertLocked(image, true);
+}
+
+void PrefetchAround(const std::wstring& dir, const std::wstring& current) {
+    int count = prefetchCount.load();
+    {
+        std::lock_guard<std::mutex> lock(s_cacheMutex);
+        if (current == s_prefetchCenter) return;
+        s_prefetchCenter = current;
+    }
+    if (count <= 0) return;
+
+    // 由近及远，同一距离先下一张后上一张（顺序浏览时最先用到）
+    std::vector<std::wstring> targets;
+    std::wstring next = current, prev = current;
+    for (int i = 0; i < count; i++) {
+        if (QueryNeighborImage(dir, next, 1, &next) && next != current &&
+            std::find(targets.begin(), targets.end(), next) == targets.end()) {
+            targets.push_back(next);
+        }
+        if (QueryNeighborImage(dir, prev, -1, &prev) && prev != current &&
+            std::find(targets.begin(), targets.end(), prev) == targets.end()) {
+            targets.push_back(prev);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(s_cacheMutex);
+    if (current != s_prefetchCenter) return; // 期间中心又变了
+    s_wantedPaths = targets;
+    s_prefetchQueue = std::move(targets);    // 替换旧队列，未开始的旧任务即被取消
+    EnsureDecodeThreadLocked();
+    s_cacheCv.notify_all();
+}
+
+void StopImageCache() {
+    {
+        std::lock_guard<std::mutex> lock(s_cacheMutex);
+        s_decodeStop = true;
+        s_prefetchQueue.clear();
+        s_urgent = DecodeRequest();
+    }
+    s_cacheCv.notify_all();
+    if (s_decodeThread.joinable()) s_decodeThread.join();
+
+    std::lock_guard<std::mutex> lock(s_cacheMutex);
+    s_cache.clear();
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <windows.h>
+#include "mipmap.h"
+#include "tiledimage.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// ============ 解码缓存 ============
+// 以 路径 + 修改时间 + 文件大小 为键保存解码后的像素，多张图片按 LRU 共存，总内存受配置上限约束
+// 解码全部在后台线程进行：当前图片优先，其次按目录顺序预取前后各 N 张，切换时直接命中缓存
+
+struct MappedCacheBlob; // 磁盘缓存的文件映射（见 diskcache.cpp）
+
+struct DecodedImage {
+    std::wstring path;
+    ULONGLONG mtime = 0;
+    ULONGLONG size = 0;
+    int width = 0;                  // pixels 的尺寸（超大图片为缩略级尺寸）
+    int height = 0;
+    std::vector<uint32_t> pixels;   // 32bppARGB 像素，拷贝到自有内存，不占用文件句柄（来自磁盘缓存时为空）
+    uint64_t generation = 0;        // 每次解码唯一，作为效果缓存键中的图片标识
+    size_t bytes = 0;               // 计入内存上限的字节数（含 mip 链的预估）
+    MipChain mips;                  // 以 pixels 为第 0 级的 mip 链；放入缓存后只由绘制线程访问
+    std::shared_ptr<TiledImage> tiled; // 超大图片：pixels 只是常驻缩略级，原图按视口分块解码
+    std::shared_ptr<MappedCacheBlob> mapped; // 来自磁盘缓存：mips 各级直接引用文件映射
+    bool pending = false;           // 内存中的截图，文件仍在写入：按路径命中，不核对修改时间和大小
+    std::shared_ptr<const DecodedImage> pixelOwner; // 文件写完后重新登记时，第 0 级像素仍由原项持有
+};
+
+// 缓存命中时返回已解码的图片；否则交给解码线程并立即返回 nullptr（调用方继续显示上一张），
+// 解码完成后请求重绘。连续请求不同图片时，未开始的旧请求被新请求覆盖
+std::shared_ptr<DecodedImage> RequestDecodedImage(const std::wstring& path);
+
+// 已在内存中的图片（截图）：文件在后台写入期间就放入缓存，下一帧即可显示，无需等待编码和解码。
+// pixels 为不透明的 32bppARGB；返回的图片在 FinishCapturedImage 之前可供写文件线程只读访问
+std::shared_ptr<const DecodedImage> InsertCapturedImage(const std::wstring& path, std::vector<uint32_t> pixels,
+                                                        int width, int height);
+// 文件写入结束：成功时按文件的修改时间和大小重新登记（共用同一份像素与图片标识），失败时移除
+void FinishCapturedImage(const std::wstring& path, bool written);
+
+// 以 current 为中心预取目录中前后各 prefetchCount 张图片；中心变化时丢弃尚未开始的旧任务
+void PrefetchAround(const std::wstring& dir, const std::wstring& current);
+
+// 分配一个新的图片标识，分块拼接结果等派生图像作为效果缓存键时使用
+uint64_t NewImageGeneration();
+
+// 退出前停止解码线程（须在 GdiplusShutdown 之前调用）
+void StopImageCache();
@@ -0,0 +1,242 @@
+#include "inifile.h"
+#include <cwctype>
+
+static bool IsBlank(wchar_t c) {
+    return c == L' ' || c == L'\t';
+}
+
+static std::wstring Trim(const std::wstring& s) {
+    size_t begin = 0, end = s.size();
+    while (begin < end && IsBlank(s[begin])) begin++;
+    while (end > begin && IsBlank(s[end - 1])) end--;
+    return s.substr(begin, end - begin);
+}
+
+static bool SameName(const std::wstring& a, const std::wstring& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (std::towlower(a[i]) != std::towlower(b[i])) return false;
+    }
+    return true;
+}
+
+void IniDocument::Parse(const std::wstring& text) {
+    m_sections.clear();
+    m_sections.emplace_back();
+
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t eol = text.find(L'\n', pos);
+        if (eol == std::wstring::npos) eol = text.size();
+        std::wstring raw = text.substr(pos, eol - pos);
+        pos = eol + 1;
+        if (!raw.empty() && raw.back() == L'\r') raw.pop_back();
+
+        std::wstring line = Trim(raw);
+        if (line.size() >= 2 && line.front() == L'[') {
+            size_t close = line.find(L']');
+            if (close != std::wstring::npos) {
+                Section section;
+                section.name = Trim(line.substr(1, close - 1));
+                section.header = true;
+                m_sections.push_back(std::move(section));
+                continue;
+            }
+        }
+
+        Line entry;
+        size_t eq = line.find(L'=');
+        if (!line.empty() && line[0] != L';' && line[0] != L'#' && eq != std::wstring::npos && eq > 0) {
+            entry.entry = true;
+            entry.key = Trim(line.substr(0, eq));
+            entry.value = Trim(line.substr(eq + 1));
+        } else {
+            entry.raw = raw;
+        }
+        m_sections.back().lines.push_back(std::move(entry));
+    }
+}
+
+std::wstring IniDocument::Serialize() const {
+    std::wstring out;
+    for (const Section& section : m_sections) {
+        if (section.header) out += L"[" + section.name + L"]\r\n";
+        for (const Line& line : section.lines) {
+            if (line.entry) {
+                out += line.key;
+                out += L'=';
+                out += line.value;
+            } else {
+                out += line.raw;
+            }
+            out += L"\r\n";
+        }
+    }
+    return out;
+}
+
+IniDocument::Section* IniDocument::FindSection(const std::wstring& name) {
+    for (Section& section : m_sections) {
+        if (section.header && SameName(section.name, name)) return &section;
+    }
+    return nullptr;
+}
+
+const IniDocument::Section* IniDocument::FindSection(const std::wstring& name) const {
+    return const_cast<IniDocument*>(this)->FindSection(name);
+}
+
+const std::wstring* IniDocument::Find(const std::wstring& section, const std::wstring& key) const {
+    // 同名的节可能出现多次（手工编辑），按顺序查找第一个含该键的
+    for (const Section& s : m_sections) {
+        if (!s.header || !SameName(s.name, section)) continue;
+        for (const Line& line : s.lines) {
+            if (line.entry && SameName(line.key, key)) return &line.value;
+        }
+    }
+    return nullptr;
+}
+
+std::wstring IniDocument::GetString(const std::wstring& section, const std::wstring& key,
+                                    const std::wstring& fallback) const {
+    const std::wstring* value = Find(section, key);
+    if (!value) return fallback;
+    if (value->size() >= 2 && (value->front() == L'"' || value->front() == L'\'') && value->back() == value->front()) {
+        return value->substr(1, value->size() - 2);
+    }
+    return *value;
+}
+
+int IniDocument::GetInt(const std::wstring& section, const std::wstring& key, int fallback) const {
+    const std::wstring* value = Find(section, key);
+    if (!value) return fallback;
+    size_t i = 0;
+    bool negative = false;
+    if (i < value->size() && (*value)[i] == L'-') {
+        negative = true;
+        i++;
+    }
+    long long result = 0;
+    for (; i < value->size() && (*value)[i] >= L'0' && (*value)[i] <= L'9'; i++) {
+        result = result * 10 + ((*value)[i] - L'0');
+        if (result > 0x7FFFFFFF) break;
+    }
+    return (int)(negative ? -result : result);
+}
+
+void IniDocument::Set(const std::wstring& section, const std::wstring& key, const std::wstring& value) {
+    for (Section& s : m_sections) {
+        if (!s.header || !SameName(s.name, section)) continue;
+        for (Line& line : s.lines) {
+            if (line.entry && SameName(line.key, key)) {
+                line.value = value;
+                return;
+            }
+        }
+    }
+
+    Section* target = FindSection(section);
+    if (!target) {
+        // 与上一节之间空一行，和 WritePrivateProfileString 生成的文件观感一致
+        if (!m_sections.empty() && !m_sections.back().lines.empty() && m_sections.back().lines.back().entry) {
+            m_sections.back().lines.emplace_back();
+        }
+        Section added;
+        added.name = section;
+        added.header = true;
+        m_sections.push_back(std::move(added));
+        target = &m_sections.back();
+    }
+
+    // 插在该节最后一个键之后，节末尾的空行和注释仍留在下一节之前
+    size_t insert = target->lines.size();
+    while (insert > 0 && !target->lines[insert - 1].entry) insert--;
+    if (insert == 0) insert = target->lines.size();
+    Line line;
+    line.entry = true;
+    line.key = key;
+    line.value = value;
+    target->lines.insert(target->lines.begin() + insert, std::move(line));
+}
+
+void IniDocument::SetInt(const std::wstring& section, const std::wstring& key, int value) {
+    Set(section, key, std::to_wstring(value));
+}
+
+// ============ 编码 ============
+
+static void AppendCodePoint(std::wstring* out, uint32_t cp) {
+    if (sizeof(wchar_t) == 2 && cp > 0xFFFF) {
+        cp -= 0x10000;
+        out->push_back((wchar_t)(0xD800 + (cp >> 10)));
+        out->push_back((wchar_t)(0xDC00 + (cp & 0x3FF)));
+    } else {
+        out->push_back((wchar_t)cp);
+    }
+}
+
+bool DecodeIniText(const uint8_t* data, size_t bytes, std::wstring* text) {
+    text->clear();
+    if (bytes >= 2 && data[0] == 0xFF && data[1] == 0xFE) {
+        for (size_t i = 2; i + 1 < bytes; i += 2) {
+            uint32_t unit = data[i] | ((uint32_t)data[i + 1] << 8);
+            if (sizeof(wchar_t) == 4 && unit >= 0xD800 && unit < 0xDC00 && i + 3 < bytes) {
+                uint32_t low = data[i + 2] | ((uint32_t)data[i + 3] << 8);
+                if (low >= 0xDC00 && low < 0xE000) {
+                    unit = 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+                    i += 2;
+                }
+            }
+            text->push_back((wchar_t)unit);
+        }
+        return true;
+    }
+    if (bytes >= 3 && data[0] == 0xEF && data[1] == 0xBB && data[2] == 0xBF) {
+        for (size_t i = 3; i < bytes;) {
+            uint8_t c = data[i];
+            int extra = c < 0x80 ? 0 : (c & 0xE0) == 0xC0 ? 1 : (c & 0xF0) == 0xE0 ? 2 : (c & 0xF8) == 0xF0 ? 3 : -1;
+            if (extra < 0 || i + extra >= bytes) { // 非法首字节或结尾被截断
+                text->push_back(0xFFFD);
+                i++;
+                continue;
+            }
+            uint32_t cp = extra == 0 ? c : c & (0x3F >> extra);
+            bool valid = true;
+            for (int k = 1; k <= extra; k++) {
+                if ((data[i + k] & 0xC0) != 0x80) valid = false;
+                cp = (cp << 6) | (data[i + k] & 0x3F);
+            }
+            if (!valid) {
+                text->push_back(0xFFFD);
+                i++;
+                continue;
+            }
+            AppendCodePoint(text, cp);
+            i += 1 + extra;
+        }
+        return true;
+    }
+    return false;
+}
+
+std::vector<uint8_t> EncodeIniText(const std::wstring& text) {
+    std::vector<uint8_t> out;
+    out.reserve(2 + text.size() * 2);
+    out.push_back(0xFF);
+    out.push_back(0xFE);
+    auto put = [&out](uint32_t unit) {
+        out.push_back((uint8_t)unit);
+        out.push_back((uint8_t)(unit >> 8));
+    };
+    for (wchar_t c : text) {
+        uint32_t cp = (uint32_t)c;
+        if (cp > 0xFFFF) {
+            cp -= 0x10000;
+            put(0xD800 + (cp >> 10));
+            put(0xDC00 + (cp & 0x3FF));
+        } else {
+            put(cp);
+        }
+    }
+    return out;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ============ INI 文档（与 Win32 无关，可在任意平台编译） ============
+// 整个文件解析一次后在内存中读写，保存时一次性序列化，取代逐键的 GetPrivateProfile*/WritePrivateProfile*
+// （每次调用都要重新打开、解析乃至重写整个文件）。语义与 Win32 INI 函数一致：节名和键名不区分大小写，
+// 重复的键以第一个为准，值两端成对的引号会被去掉；注释、空行和不认识的键原样保留
+
+class IniDocument {
+public:
+    // 解析文本（换行可为 \n 或 \r\n），替换当前内容
+    void Parse(const std::wstring& text);
+    std::wstring Serialize() const;   // 行尾统一为 \r\n
+    void Clear() { m_sections.clear(); }
+
+    // 不存在时返回 nullptr
+    const std::wstring* Find(const std::wstring& section, const std::wstring& key) const;
+    std::wstring GetString(const std::wstring& section, const std::wstring& key, const std::wstring& fallback) const;
+    // 与 GetPrivateProfileInt 相同：键不存在时返回 fallback，值不以数字开头时返回 0
+    int GetInt(const std::wstring& section, const std::wstring& key, int fallback) const;
+
+    // 修改已有的键，或追加到该节末尾（节不存在时追加到文件末尾）
+    void Set(const std::wstring& section, const std::wstring& key, const std::wstring& value);
+    void SetInt(const std::wstring& section, const std::wstring& key, int value);
+
+private:
+    struct Line {
+        bool entry = false;   // false 为注释、空行等原样保留的行
+        std::wstring key;     // entry 时有效
+        std::wstring value;
+        std::wstring raw;     // 非 entry 时的原文
+    };
+    struct Section {
+        std::wstring name;    // 第一个节名之前的内容放在名称为空的节里
+        bool header = false;  // 是否有 [name] 行
+        std::vector<Line> lines;
+    };
+
+    Section* FindSection(const std::wstring& name);
+    const Section* FindSection(const std::wstring& name) const;
+
+    std::vector<Section> m_sections;
+};
+
+// 按 BOM 识别 UTF-16LE / UTF-8 并解码；没有 BOM 时返回 false，由调用方按本地代码页解码
+// （旧版本通过 WritePrivateProfileString 生成的文件）
+bool DecodeIniText(const uint8_t* data, size_t bytes, std::wstring* text);
+// 编码为带 BOM 的 UTF-16LE（Win32 INI 函数也能读取，回退到旧版本不受影响）
+std::vector<uint8_t> EncodeIniText(const std::wstring& text);
@@ -0,0 +1,169 @@
+#include "lastframe.h"
+#include "globals.h"
+#include "cachefile.h"
+#include <cstring>
+
+static const uint32_t kFrameMagic = 0x464C4447; // "GDLF"
+static const uint32_t kFrameVersion = 1;
+
+// 文件头之后依次为 UTF-16 图片路径和 width * height 个像素
+struct FrameFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t contentHash;
+    uint64_t imageMtime;
+    uint64_t imageSize;
+    int32_t monitor[4];
+    int32_t originX;
+    int32_t originY;
+    float shiftX;
+    float shiftY;
+    int32_t width;
+    int32_t height;
+    uint32_t pathLength;
+    uint32_t reserved;
+};
+
+static std::wstring FramePath() {
+    const std::wstring& dir = GetLocalDataDirectory();
+    return dir.empty() ? std::wstring() : dir + L"\\LastFrame.bin";
+}
+
+uint64_t FrameContentHash(const std::wstring& path, uint64_t mtime, uint64_t size, float pixelScale, int rotation,
+                          bool mirrorH, bool mirrorV, bool gray, bool removeWhite, float opacity) {
+    uint64_t hash = CacheKeyHash(path, mtime, size);
+    auto mix = [&hash](const void* data, size_t bytes) {
+        const uint8_t* p = (const uint8_t*)data;
+        for (size_t i = 0; i < bytes; i++) {
+            hash ^= p[i];
+            hash *= 0x100000001B3ull;
+        }
+    };
+    uint8_t flags = (gray ? 1 : 0) | (removeWhite ? 2 : 0) | (mirrorH ? 4 : 0) | (mirrorV ? 8 : 0);
+    mix(&pixelScale, sizeof(pixelScale));
+    mix(&rotation, sizeof(rotation));
+    mix(&flags, sizeof(flags));
+    mix(&opacity, sizeof(opacity));
+    return hash;
+}
+
+void SaveLastFrame(const LastFrame* frame) {
+    std::wstring path = FramePath();
+    if (path.empty()) return;
+    if (!frame || frame->pixels.size() != (size_t)frame->width * frame->height) {
+        DeleteFileW(path.c_str());
+        return;
+    }
+
+    FrameFileHeader header = {};
+    header.magic = kFrameMagic;
+    header.version = kFrameVersion;
+    header.contentHash = frame->contentHash;
+    header.imageMtime = frame->imageMtime;
+    header.imageSize = frame->imageSize;
+    header.monitor[0] = frame->monitor.left;
+    header.monitor[1] = frame->monitor.top;
+    header.monitor[2] = frame->monitor.right;
+    header.monitor[3] = frame->monitor.bottom;
+    header.originX = frame->origin.x;
+    header.originY = frame->origin.y;
+    header.shiftX = frame->shiftX;
+    header.shiftY = frame->shiftY;
+    header.width = frame->width;
+    header.height = frame->height;
+    header.pathLength = (uint32_t)frame->imagePath.size();
+
+    // 先写临时文件再替换，退出时被强行结束也不会留下半张画面
+    std::wstring temp = path + L".tmp";
+    HANDLE file = CreateFileW(temp.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return;
+    DWORD written = 0;
+    DWORD pathBytes = header.pathLength * sizeof(wchar_t);
+    DWORD pixelBytes = (DWORD)(frame->pixels.size() * 4);
+    bool ok = WriteFile(file, &header, sizeof(header), &written, nullptr) && written == sizeof(header) &&
+              WriteFile(file, frame->imagePath.data(), pathBytes, &written, nullptr) && written == pathBytes &&
+              WriteFile(file, frame->pixels.data(), pixelBytes, &written, nullptr) && written == pixelBytes;
+    CloseHandle(file);
+    if (!ok || !MoveFileExW(temp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING)) DeleteFileW(temp.c_str());
+}
+
+std::shared_ptr<LastFrame> LoadLastFrame(const std::wstring& imagePath) {
+    std::wstring path = FramePath();
+    if (path.empty() || imagePath.empty()) return nullptr;
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return nullptr;
+
+    std::shared_ptr<LastFrame> frame;
+    FrameFileHeader header;
+    DWORD read = 0;
+    LARGE_INTEGER fileSize;
+    if (ReadFile(file, &header, sizeof(header), &read, nullptr) && read == sizeof(header) &&
+        header.magic == kFrameMagic && header.version == kFrameVersion &&
+        header.width > 0 && header.height > 0 && (uint64_t)header.width * header.height <= 64ull * 1024 * 1024 &&
+        header.pathLength == imagePath.size() && GetFileSizeEx(file, &fileSize) &&
+        (uint64_t)fileSize.QuadPart == sizeof(header) + (uint64_t)header.pathLength * sizeof(wchar_t) +
+                                       (uint64_t)header.width * header.height * 4) {
+        frame = std::make_shared<LastFrame>();
+        frame->imagePath.resize(header.pathLength);
+        frame->pixels.resize((size_t)header.width * header.height);
+        DWORD pathBytes = header.pathLength * sizeof(wchar_t);
+        DWORD pixelBytes = (DWORD)(frame->pixels.size() * 4);
+        DWORD pathRead = 0, pixelRead = 0;
+        bool ok = ReadFile(file, frame->imagePath.data(), pathBytes, &pathRead, nullptr) && pathRead == pathBytes &&
+                  lstrcmpiW(frame->imagePath.c_str(), imagePath.c_str()) == 0 &&
+                  ReadFile(file, frame->pixels.data(), pixelBytes, &pixelRead, nullptr) && pixelRead == pixelBytes;
+        if (!ok) frame.reset();
+    }
+    CloseHandle(file);
+    if (!frame) return nullptr;
+
+    // 源图片在两次运行之间被修改或删除时，旧画面不再可信
+    WIN32_FILE_ATTRIBUTE_DATA fad;
+    if (!GetFileAttributesExW(imagePath.c_str(), GetFileExInfoStandard, &fad)) return nullptr;
+    uint64_t mtime = ((uint64_t)fad.ftLastWriteTime.dwHighDateTime << 32) | fad.ftLastWriteTime.dwLowDateTime;
+    uint64_t size = ((uint64_t)fad.nFileSizeHigh << 32) | fad.nFileSizeLow;
+    if (mtime != header.imageMtime || size != header.imageSize) return nullptr;
+
+    frame->contentHash = header.contentHash;
+    frame->imageMtime = header.imageMtime;
+    frame->imageSize = header.imageSize;
+    frame->monitor = { header.monitor[0], header.monitor[1], header.monitor[2], header.monitor[3] };
+    frame->origin = { header.originX, header.originY };
+    frame->shiftX = header.shiftX;
+    frame->shiftY = header.shiftY;
+    frame->width = header.width;
+    frame->height = header.height;
+    return frame;
+}
+
+bool PresentLastFrame(HWND hwnd, const LastFrame& frame, const RECT& monitor) {
+    if (!EqualRect(&frame.monitor, &monitor)) return false; // 显示器布局或缩放已变，位置不再可信
+
+    BITMAPINFO bi = {};
+    bi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    bi.bmiHeader.biWidth = frame.width;
+    bi.bmiHeader.biHeight = -frame.height; // 自上而下
+    bi.bmiHeader.biPlanes = 1;
+    bi.bmiHeader.biBitCount = 32;
+    bi.bmiHeader.biCompression = BI_RGB;
+    void* bits = nullptr;
+    HBITMAP bitmap = CreateDIBSection(nullptr, &bi, DIB_RGB_COLORS, &bits, nullptr, 0);
+    if (!bitmap || !bits) {
+        if (bitmap) DeleteObject(bitmap);
+        return false;
+    }
+    memcpy(bits, frame.pixels.data(), frame.pixels.size() * 4);
+
+    HDC dc = CreateCompatibleDC(nullptr);
+    HGDIOBJ old = SelectObject(dc, bitmap);
+    BLENDFUNCTION blend = { AC_SRC_OVER, 0, 255, AC_SRC_ALPHA };
+    POINT origin = frame.origin;
+    POINT ptSrc = { 0, 0 };
+    SIZE size = { frame.width, frame.height };
+    BOOL ok = UpdateLayeredWindow(hwnd, nullptr, &origin, &size, dc, &ptSrc, 0, &blend, ULW_ALPHA);
+    SelectObject(dc, old);
+    DeleteDC(dc);
+    DeleteObject(bitmap);
+    return ok != FALSE;
+}
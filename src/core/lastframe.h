@@ -0,0 +1,37 @@
+#pragma once
+
+#include <windows.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// ============ 上次画面 ============
+// 退出时把最后提交的叠加画面（缩放、旋转、效果处理后的预乘像素）连同内容哈希保存到
+// %LOCALAPPDATA%\GuessDraw\LastFrame.bin；下次启动窗口一创建就直接提交这张画面，
+// 不必等配置之外的目录扫描、解码和渲染。渲染线程的第一帧内容哈希相同时直接接管这张画面，否则照常重绘替换
+
+struct LastFrame {
+    uint64_t contentHash = 0;     // 图片标识与影响像素的渲染参数，见 FrameContentHash
+    std::wstring imagePath;       // 源图片，启动时先确认文件未变
+    uint64_t imageMtime = 0;
+    uint64_t imageSize = 0;
+    RECT monitor = { 0, 0, 0, 0 }; // 保存时的目标显示器区域
+    POINT origin = { 0, 0 };      // 画面左上角（屏幕物理像素）
+    float shiftX = 0.0f;          // 画面中心相对整图中心的屏幕偏移
+    float shiftY = 0.0f;
+    int width = 0;
+    int height = 0;
+    std::vector<uint32_t> pixels; // 预乘 BGRA，自上而下
+};
+
+// 图片标识（路径 + 修改时间 + 大小）与显示器上的实际缩放、旋转、镜像、效果参数的哈希
+uint64_t FrameContentHash(const std::wstring& path, uint64_t mtime, uint64_t size, float pixelScale, int rotation,
+                          bool mirrorH, bool mirrorV, bool gray, bool removeWhite, float opacity);
+
+// 保存画面；frame 为 nullptr 时删除旧文件（退出时没有可复用的画面）
+void SaveLastFrame(const LastFrame* frame);
+// 读取上次画面：文件不存在、损坏、源图片已变化或不是 imagePath 时返回 nullptr
+std::shared_ptr<LastFrame> LoadLastFrame(const std::wstring& imagePath);
+// 把画面直接提交到分层窗口；目标显示器与保存时不同则不提交（调用线程须为每显示器 DPI 感知）
+bool PresentLastFrame(HWND hwnd, const LastFrame& frame, const RECT& monitor);
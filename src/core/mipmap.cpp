@@ -0,0 +1,144 @@
+#include "mipmap.h"
+#include "simd.h"
+#include <algorithm>
+
+// 一组 2x2 像素的下采样（标量）
+static inline uint32_t Average4(uint32_t p0, uint32_t p1, uint32_t p2, uint32_t p3) {
+    uint32_t a0 = p0 >> 24, a1 = p1 >> 24, a2 = p2 >> 24, a3 = p3 >> 24;
+    uint32_t sumA = a0 + a1 + a2 + a3;
+    uint32_t out = 0;
+
+    if (sumA == 255 * 4) {
+        // 全不透明：各通道直接四舍五入平均
+        for (int c = 0; c < 24; c += 8) {
+            uint32_t s = ((p0 >> c) & 0xFF) + ((p1 >> c) & 0xFF) + ((p2 >> c) & 0xFF) + ((p3 >> c) & 0xFF);
+            out |= ((s + 2) >> 2) << c;
+        }
+        return out | 0xFF000000u;
+    }
+    if (sumA == 0) return 0;
+
+    // 半透明：颜色按 alpha 加权
+    for (int c = 0; c < 24; c += 8) {
+        uint32_t s = ((p0 >> c) & 0xFF) * a0 + ((p1 >> c) & 0xFF) * a1 +
+                     ((p2 >> c) & 0xFF) * a2 + ((p3 >> c) & 0xFF) * a3;
+        out |= ((s + sumA / 2) / sumA) << c;
+    }
+    return out | (((sumA + 2) >> 2) << 24);
+}
+
+static void DownsampleRowScalar(const uint32_t* row0, const uint32_t* row1, uint32_t* dst,
+                                int srcW, int x0, int x1) {
+    for (int x = x0; x < x1; x++) {
+        int sx0 = std::min(2 * x, srcW - 1);
+        int sx1 = std::min(2 * x + 1, srcW - 1);
+        dst[x] = Average4(row0[sx0], row0[sx1], row1[sx0], row1[sx1]);
+    }
+}
+
+#if GD_X86
+// SSE2：每次输出 2 像素；遇到含半透明像素的一组时退回标量加权
+GD_TARGET_SSE2
+static void DownsampleRowSse2(const uint32_t* row0, const uint32_t* row1, uint32_t* dst, int srcW, int dstW) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alphaMask = _mm_set1_epi32((int)0xFF000000);
+    const __m128i two = _mm_set1_epi16(2);
+    int x = 0;
+    for (; x + 2 <= dstW && 2 * x + 4 <= srcW; x += 2) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(row0 + 2 * x));
+        __m128i b = _mm_loadu_si128((const __m128i*)(row1 + 2 * x));
+        __m128i opaque = _mm_cmpeq_epi32(_mm_and_si128(_mm_and_si128(a, b), alphaMask), alphaMask);
+        if (_mm_movemask_epi8(opaque) != 0xFFFF) {
+            DownsampleRowScalar(row0, row1, dst, srcW, x, x + 2);
+            continue;
+        }
+        __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+        __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+        lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+        hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+        __m128i sum = _mm_unpacklo_epi64(lo, hi);
+        sum = _mm_srli_epi16(_mm_add_epi16(sum, two), 2);
+        _mm_storel_epi64((__m128i*)(dst + x), _mm_packus_epi16(sum, zero));
+    }
+    DownsampleRowScalar(row0, row1, dst, srcW, x, dstW);
+}
+#endif
+
+void DownsampleBox2x(const uint32_t* src, int srcW, int srcH, int srcStride,
+                     uint32_t* dst, int dstW, int dstH, int dstStride) {
+#if GD_X86
+    static const bool hasSse2 = CpuHasSse2();
+#endif
+    for (int y = 0; y < dstH; y++) {
+        const uint32_t* row0 = src + (size_t)std::min(2 * y, srcH - 1) * srcStride;
+        const uint32_t* row1 = src + (size_t)std::min(2 * y + 1, srcH - 1) * srcStride;
+        uint32_t* d = dst + (size_t)y * dstStride;
+#if GD_X86
+        if (hasSse2) {
+            DownsampleRowSse2(row0, row1, d, srcW, dstW);
+            continue;
+        }
+#endif
+        DownsampleRowScalar(row0, row1, d, srcW, 0, dstW);
+    }
+}
+
+// ============ MipChain ============
+void MipChain::Reset(const uint32_t* base, int width, int height) {
+    m_base = base;
+    m_width = width;
+    m_height = height;
+    m_levels.clear();
+}
+
+void MipChain::AdoptLevel(const uint32_t* pixels, int width, int height) {
+    Level next;
+    next.width = width;
+    next.height = height;
+    next.external = pixels;
+    m_levels.push_back(std::move(next));
+}
+
+int MipChain::SelectLevel(int dstW, int dstH) {
+    int level = 0;
+    int w = m_width, h = m_height;
+    while (w > 1 || h > 1) {
+        int nw = std::max(1, w / 2);
+        int nh = std::max(1, h / 2);
+        if (nw < dstW || nh < dstH) break;
+
+        // 按需构建下一级
+        if ((int)m_levels.size() <= level) {
+            Level next;
+            next.width = nw;
+            next.height = nh;
+            next.pixels.resize((size_t)nw * nh);
+            DownsampleBox2x(Pixels(level), w, h, w, next.pixels.data(), nw, nh, nw);
+            m_levels.push_back(std::move(next));
+        }
+        level++;
+        w = nw;
+        h = nh;
+    }
+    return level;
+}
+
+int MipChain::Width(int level) const {
+    return level == 0 ? m_width : m_levels[level - 1].width;
+}
+
+int MipChain::Height(int level) const {
+    return level == 0 ? m_height : m_levels[level - 1].height;
+}
+
+const uint32_t* MipChain::Pixels(int level) const {
+    if (level == 0) return m_base;
+    const Level& l = m_levels[level - 1];
+    return l.external ? l.external : l.pixels.data();
+}
+
+size_t MipChain::MemoryBytes() const {
+    size_t bytes = 0;
+    for (const Level& l : m_levels) bytes += l.pixels.size() * sizeof(uint32_t);
+    return bytes;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ============ Mip 金字塔（与 Win32 无关，可在任意平台编译） ============
+// 像素为直通 alpha 的 32 位 BGRA；每级宽高为上一级的一半（向下取整，至少为 1）
+
+// 2x2 盒式下采样：不透明像素直接平均，半透明像素按 alpha 加权，避免透明区域的颜色渗入边缘
+// stride 以像素为单位；dstW/dstH 应为 max(1, srcW/2) / max(1, srcH/2)
+void DownsampleBox2x(const uint32_t* src, int srcW, int srcH, int srcStride,
+                     uint32_t* dst, int dstW, int dstH, int dstStride);
+
+// 延迟构建的 mip 链：第 0 级引用原图像素（不拷贝），更小的级别在首次请求时才生成
+class MipChain {
+public:
+    // 设置第 0 级并清空已有级别；base 的生命周期由调用方保证
+    void Reset(const uint32_t* base, int width, int height);
+
+    // 追加下一级，像素由外部持有（如磁盘缓存的文件映射），尺寸须为上一级的一半
+    void AdoptLevel(const uint32_t* pixels, int width, int height);
+
+    // 选择宽高都不小于目标尺寸的最小级别（即“最近的更大级别”），必要时构建到该级
+    int SelectLevel(int dstW, int dstH);
+
+    int LevelCount() const { return 1 + (int)m_levels.size(); } // 已构建的级别数（含第 0 级）
+
+    int Width(int level) const;
+    int Height(int level) const;
+    const uint32_t* Pixels(int level) const;
+
+    // 已构建级别自有内存的字节数（不含第 0 级和外部持有的级别）
+    size_t MemoryBytes() const;
+
+private:
+    struct Level {
+        int width = 0;
+        int height = 0;
+        std::vector<uint32_t> pixels;
+        const uint32_t* external = nullptr; // 非空时像素由外部持有，pixels 为空
+    };
+
+    const uint32_t* m_base = nullptr;
+    int m_width = 0;
+    int m_height = 0;
+    std::vector<Level> m_levels; // m_levels[i] 为第 i+1 级
+};
@@ -0,0 +1,58 @@
+#include "monitor.h"
+#include "globals.h"
+#include <shellscalingapi.h>
+
+#pragma comment(lib, "shcore.lib")
+
+ScopedPerMonitorDpi::ScopedPerMonitorDpi()
+    : m_previous(SetThreadDpiAwarenessContext(DPI_AWARENESS_CONTEXT_PER_MONITOR_AWARE_V2)) {}
+
+ScopedPerMonitorDpi::~ScopedPerMonitorDpi() {
+    if (m_previous) SetThreadDpiAwarenessContext(m_previous);
+}
+
+static bool FillTarget(HMONITOR monitor, MonitorTarget* out) {
+    MONITORINFO info = {};
+    info.cbSize = sizeof(info);
+    if (!monitor || !GetMonitorInfoW(monitor, &info)) return false;
+
+    UINT dpiX = 96, dpiY = 96;
+    if (FAILED(GetDpiForMonitor(monitor, MDT_EFFECTIVE_DPI, &dpiX, &dpiY))) dpiX = 96;
+    out->handle = monitor;
+    out->rect = info.rcMonitor;
+    out->dpi = dpiX;
+    return true;
+}
+
+// 按枚举顺序取第 index 个显示器（从 1 开始）
+static HMONITOR MonitorByIndex(int index) {
+    struct Search { int remaining; HMONITOR found; } search = { index, nullptr };
+    EnumDisplayMonitors(nullptr, nullptr, [](HMONITOR monitor, HDC, LPRECT, LPARAM param) -> BOOL {
+        Search* s = (Search*)param;
+        if (--s->remaining > 0) return TRUE;
+        s->found = monitor;
+        return FALSE;
+    }, (LPARAM)&search);
+    return search.found;
+}
+
+bool GetCursorMonitor(MonitorTarget* out) {
+    ScopedPerMonitorDpi dpiScope;
+    POINT pt = { 0, 0 };
+    GetCursorPos(&pt);
+    return FillTarget(MonitorFromPoint(pt, MONITOR_DEFAULTTONEAREST), out);
+}
+
+bool ResolveTargetMonitor(MonitorTarget* out) {
+    int setting = targetMonitor.load();
+    if (setting < 0) return GetCursorMonitor(out);
+
+    ScopedPerMonitorDpi dpiScope;
+    // 指定的显示器已拔掉时退回主显示器
+    HMONITOR monitor = setting > 0 ? MonitorByIndex(setting) : nullptr;
+    if (!monitor) {
+        POINT origin = { 0, 0 };
+        monitor = MonitorFromPoint(origin, MONITOR_DEFAULTTOPRIMARY);
+    }
+    return FillTarget(monitor, out);
+}
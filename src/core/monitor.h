@@ -0,0 +1,32 @@
+#pragma once
+
+#include <windows.h>
+
+// ============ 目标显示器 ============
+// 叠加层和截图只覆盖一个显示器，后备缓冲按该显示器的物理像素尺寸分配，而不是整个虚拟桌面。
+// 以下坐标均为每显示器 DPI 感知下的物理像素
+
+struct MonitorTarget {
+    HMONITOR handle = nullptr;
+    RECT rect = { 0, 0, 0, 0 }; // 显示器在虚拟桌面中的区域
+    UINT dpi = 96;
+};
+
+// 在作用域内把当前线程切换为每显示器 DPI 感知（V2），离开时恢复
+// 主窗口、截图窗口在此作用域内创建，渲染/快捷键线程整个生命周期都处于该模式；
+// 设置窗口仍按系统缩放拉伸，布局不受影响
+class ScopedPerMonitorDpi {
+public:
+    ScopedPerMonitorDpi();
+    ~ScopedPerMonitorDpi();
+    ScopedPerMonitorDpi(const ScopedPerMonitorDpi&) = delete;
+    ScopedPerMonitorDpi& operator=(const ScopedPerMonitorDpi&) = delete;
+
+private:
+    DPI_AWARENESS_CONTEXT m_previous;
+};
+
+// 按 [Window] Monitor 设置解析目标显示器（0=主显示器，-1=跟随鼠标，n=第 n 个显示器）
+bool ResolveTargetMonitor(MonitorTarget* out);
+// 鼠标所在的显示器
+bool GetCursorMonitor(MonitorTarget* out);
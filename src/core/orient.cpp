@@ -0,0 +1,85 @@
+#include "orient.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+// 转置类变换的块边长：64x64 个像素，源和目标各 16KB，合计放得进 L1
+static const int kBlock = 64;
+
+void OrientedSize(int width, int height, const Orientation& o, int* outW, int* outH) {
+    *outW = o.SwapsAxes() ? height : width;
+    *outH = o.SwapsAxes() ? width : height;
+}
+
+// 目标像素 (x, y) 对应的源像素坐标：依次撤销各次顺时针旋转，再撤销镜像
+static void SourceCoord(int width, int height, const Orientation& o, int x, int y, int* sx, int* sy) {
+    int turns = ((o.quarterTurns % 4) + 4) % 4;
+    for (int j = turns; j >= 1; j--) {
+        // 第 j 次旋转前图片的高度；顺时针旋转把 (px, py) 映射到 (ph - 1 - py, px)
+        int ph = (j - 1) % 2 == 0 ? height : width;
+        int px = y;
+        int py = ph - 1 - x;
+        x = px;
+        y = py;
+    }
+    if (o.mirrorH) x = width - 1 - x;
+    if (o.mirrorV) y = height - 1 - y;
+    *sx = x;
+    *sy = y;
+}
+
+void OrientImage(const uint32_t* src, int width, int height, int srcStride,
+                 uint32_t* dst, int dstStride, const Orientation& o) {
+    if (width <= 0 || height <= 0) return;
+    int dw, dh;
+    OrientedSize(width, height, o, &dw, &dh);
+
+    // 变换是仿射的：目标 (x, y) 的源下标 = origin + x * stepX + y * stepY
+    int x0, y0, x1, y1, x2, y2;
+    SourceCoord(width, height, o, 0, 0, &x0, &y0);
+    SourceCoord(width, height, o, 1, 0, &x1, &y1);
+    SourceCoord(width, height, o, 0, 1, &x2, &y2);
+    ptrdiff_t origin = (ptrdiff_t)y0 * srcStride + x0;
+    ptrdiff_t stepX = (ptrdiff_t)(y1 - y0) * srcStride + (x1 - x0);
+    ptrdiff_t stepY = (ptrdiff_t)(y2 - y0) * srcStride + (x2 - x0);
+
+    if (!o.SwapsAxes()) {
+        // 0°/180° 与镜像：源的一行仍对应目标的一行，正向时整行拷贝，反向时逐像素倒序
+        for (int y = 0; y < dh; y++) {
+            const uint32_t* s = src + origin + y * stepY;
+            uint32_t* d = dst + (size_t)y * dstStride;
+            if (stepX == 1) {
+                memcpy(d, s, (size_t)dw * 4);
+            } else {
+                for (int x = 0; x < dw; x++) d[x] = *(s - x);
+            }
+        }
+        return;
+    }
+
+    // 90°/270°：目标的一行对应源的一列，按块遍历，块内源的各列同时常驻缓存
+    for (int by = 0; by < dh; by += kBlock) {
+        int yEnd = std::min(dh, by + kBlock);
+        for (int bx = 0; bx < dw; bx += kBlock) {
+            int xEnd = std::min(dw, bx + kBlock);
+            for (int y = by; y < yEnd; y++) {
+                const uint32_t* s = src + origin + y * stepY + bx * stepX;
+                uint32_t* d = dst + (size_t)y * dstStride + bx;
+                for (int x = bx; x < xEnd; x++, s += stepX) *d++ = *s;
+            }
+        }
+    }
+}
+
+void OrientImageReference(const uint32_t* src, int width, int height, int srcStride,
+                          uint32_t* dst, int dstStride, const Orientation& o) {
+    int dw, dh;
+    OrientedSize(width, height, o, &dw, &dh);
+    for (int y = 0; y < dh; y++) {
+        for (int x = 0; x < dw; x++) {
+            int sx, sy;
+            SourceCoord(width, height, o, x, y, &sx, &sy);
+            dst[(size_t)y * dstStride + x] = src[(size_t)sy * srcStride + sx];
+        }
+    }
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+// ============ 无损方向变换（与 Win32 无关，可在任意平台编译） ============
+// 90° 整数倍的旋转与水平/垂直镜像只是像素重排，不需要重采样。
+// 带转置的变换（90°/270°）按块处理：源和目标各只有一小块常驻缓存，避免逐列访问时每个像素都缺失缓存
+
+struct Orientation {
+    int quarterTurns = 0;   // 顺时针旋转的 90° 次数（0..3）
+    bool mirrorH = false;   // 旋转前先左右翻转
+    bool mirrorV = false;   // 旋转前先上下翻转
+
+    bool IsIdentity() const { return quarterTurns % 4 == 0 && !mirrorH && !mirrorV; }
+    bool SwapsAxes() const { return quarterTurns % 2 != 0; }
+};
+
+// 变换后的宽高（90°/270° 时互换）
+void OrientedSize(int width, int height, const Orientation& o, int* outW, int* outH);
+
+// src（width x height，stride 以像素计）按 o 变换写入 dst（尺寸见 OrientedSize）；src 与 dst 不能重叠
+void OrientImage(const uint32_t* src, int width, int height, int srcStride,
+                 uint32_t* dst, int dstStride, const Orientation& o);
+
+// 逐像素的参考实现，供基准测试比对
+void OrientImageReference(const uint32_t* src, int width, int height, int srcStride,
+                          uint32_t* dst, int dstStride, const Orientation& o);
@@ -0,0 +1,175 @@
+#include "qoi.h"
+#include <cstring>
+
+static const uint8_t kOpIndex = 0x00; // 00xxxxxx
+static const uint8_t kOpDiff  = 0x40; // 01xxxxxx
+static const uint8_t kOpLuma  = 0x80; // 10xxxxxx
+static const uint8_t kOpRun   = 0xC0; // 11xxxxxx
+static const uint8_t kOpRgb   = 0xFE;
+static const uint8_t kOpRgba  = 0xFF;
+static const uint8_t kMask2   = 0xC0;
+static const uint8_t kPadding[kQoiPaddingBytes] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+
+// 0xAARRGGBB 的 QOI 颜色哈希：(r * 3 + g * 5 + b * 7 + a * 11) % 64
+static inline uint32_t HashPixel(uint32_t p) {
+    return (((p >> 16) & 0xFF) * 3 + ((p >> 8) & 0xFF) * 5 + (p & 0xFF) * 7 + (p >> 24) * 11) & 63;
+}
+
+static inline void PutBigEndian32(uint8_t* dst, uint32_t v) {
+    dst[0] = (uint8_t)(v >> 24);
+    dst[1] = (uint8_t)(v >> 16);
+    dst[2] = (uint8_t)(v >> 8);
+    dst[3] = (uint8_t)v;
+}
+
+static inline uint32_t GetBigEndian32(const uint8_t* src) {
+    return ((uint32_t)src[0] << 24) | ((uint32_t)src[1] << 16) | ((uint32_t)src[2] << 8) | src[3];
+}
+
+std::vector<uint8_t> EncodeQoi(const uint32_t* pixels, int width, int height, int channels) {
+    std::vector<uint8_t> out;
+    if (!pixels || width <= 0 || height <= 0 || (uint64_t)width * height > kQoiMaxPixels) return out;
+
+    // 最坏情况每像素 5 字节（QOI_OP_RGBA），一次分配到位，写入时不做边界检查
+    size_t count = (size_t)width * height;
+    out.resize(kQoiHeaderBytes + count * 5 + kQoiPaddingBytes);
+    uint8_t* p = out.data();
+    memcpy(p, "qoif", 4);
+    PutBigEndian32(p + 4, (uint32_t)width);
+    PutBigEndian32(p + 8, (uint32_t)height);
+    p[12] = (uint8_t)(channels == 3 ? 3 : 4);
+    p[13] = 0;
+    p += kQoiHeaderBytes;
+
+    uint32_t index[64] = {};
+    uint32_t prev = 0xFF000000;
+    int run = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t px = pixels[i];
+        if (px == prev) {
+            if (++run == 62) {
+                *p++ = (uint8_t)(kOpRun | (run - 1));
+                run = 0;
+            }
+            continue;
+        }
+        if (run > 0) {
+            *p++ = (uint8_t)(kOpRun | (run - 1));
+            run = 0;
+        }
+
+        uint32_t h = HashPixel(px);
+        if (index[h] == px) {
+            *p++ = (uint8_t)(kOpIndex | h);
+        } else {
+            index[h] = px;
+            if ((px >> 24) == (prev >> 24)) {
+                // alpha 不变：按差值大小依次尝试 1 字节、2 字节编码
+                int8_t dr = (int8_t)(((px >> 16) & 0xFF) - ((prev >> 16) & 0xFF));
+                int8_t dg = (int8_t)(((px >> 8) & 0xFF) - ((prev >> 8) & 0xFF));
+                int8_t db = (int8_t)((px & 0xFF) - (prev & 0xFF));
+                int8_t drdg = (int8_t)(dr - dg);
+                int8_t dbdg = (int8_t)(db - dg);
+                if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                    *p++ = (uint8_t)(kOpDiff | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2));
+                } else if (dg >= -32 && dg <= 31 && drdg >= -8 && drdg <= 7 && dbdg >= -8 && dbdg <= 7) {
+                    *p++ = (uint8_t)(kOpLuma | (dg + 32));
+                    *p++ = (uint8_t)(((drdg + 8) << 4) | (dbdg + 8));
+                } else {
+                    *p++ = kOpRgb;
+                    *p++ = (uint8_t)(px >> 16);
+                    *p++ = (uint8_t)(px >> 8);
+                    *p++ = (uint8_t)px;
+                }
+            } else {
+                *p++ = kOpRgba;
+                *p++ = (uint8_t)(px >> 16);
+                *p++ = (uint8_t)(px >> 8);
+                *p++ = (uint8_t)px;
+                *p++ = (uint8_t)(px >> 24);
+            }
+        }
+        prev = px;
+    }
+    if (run > 0) *p++ = (uint8_t)(kOpRun | (run - 1));
+    memcpy(p, kPadding, kQoiPaddingBytes);
+    p += kQoiPaddingBytes;
+    out.resize((size_t)(p - out.data()));
+    return out;
+}
+
+bool ReadQoiHeader(const uint8_t* data, size_t bytes, QoiHeader* header) {
+    if (!data || bytes < kQoiHeaderBytes + kQoiPaddingBytes || memcmp(data, "qoif", 4) != 0) return false;
+    uint32_t w = GetBigEndian32(data + 4);
+    uint32_t h = GetBigEndian32(data + 8);
+    if (w == 0 || h == 0 || w > 0x7FFFFFFF || h > 0x7FFFFFFF || (uint64_t)w * h > kQoiMaxPixels) return false;
+    if ((data[12] != 3 && data[12] != 4) || data[13] > 1) return false;
+    header->width = (int)w;
+    header->height = (int)h;
+    header->channels = data[12];
+    header->colorspace = data[13];
+    return true;
+}
+
+bool DecodeQoi(const uint8_t* data, size_t bytes, std::vector<uint32_t>* pixels, QoiHeader* header) {
+    QoiHeader parsed;
+    if (!ReadQoiHeader(data, bytes, &parsed)) return false;
+
+    size_t count = (size_t)parsed.width * parsed.height;
+    pixels->resize(count);
+    uint32_t* out = pixels->data();
+    const uint8_t* p = data + kQoiHeaderBytes;
+    const uint8_t* end = data + bytes - kQoiPaddingBytes; // 操作码不会落在结束标记内
+    uint32_t index[64] = {};
+    uint32_t px = 0xFF000000;
+
+    size_t i = 0;
+    while (i < count) {
+        if (p >= end) return false;
+        uint8_t op = *p++;
+        if (op == kOpRgb) {
+            if (end - p < 3) return false;
+            px = (px & 0xFF000000) | ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+            p += 3;
+        } else if (op == kOpRgba) {
+            if (end - p < 4) return false;
+            px = ((uint32_t)p[3] << 24) | ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+            p += 4;
+        } else if ((op & kMask2) == kOpIndex) {
+            px = index[op];
+            out[i++] = px;
+            continue; // 取自索引的颜色无需回写
+        } else if ((op & kMask2) == kOpDiff) {
+            uint32_t r = (((px >> 16) & 0xFF) + ((op >> 4) & 3) - 2) & 0xFF;
+            uint32_t g = (((px >> 8) & 0xFF) + ((op >> 2) & 3) - 2) & 0xFF;
+            uint32_t b = ((px & 0xFF) + (op & 3) - 2) & 0xFF;
+            px = (px & 0xFF000000) | (r << 16) | (g << 8) | b;
+        } else if ((op & kMask2) == kOpLuma) {
+            if (p >= end) return false;
+            int dg = (op & 0x3F) - 32;
+            int dr = dg + (*p >> 4) - 8;
+            int db = dg + (*p & 0x0F) - 8;
+            p++;
+            uint32_t r = (((px >> 16) & 0xFF) + dr) & 0xFF;
+            uint32_t g = (((px >> 8) & 0xFF) + dg) & 0xFF;
+            uint32_t b = ((px & 0xFF) + db) & 0xFF;
+            px = (px & 0xFF000000) | (r << 16) | (g << 8) | b;
+        } else {
+            size_t run = (size_t)(op & 0x3F) + 1;
+            if (run > count - i) return false;
+            for (size_t k = 0; k < run; k++) out[i++] = px;
+            // 规范要求每个像素都写入索引：文件开头就是初始像素 0xFF000000 的游程时，它此前并不在索引里
+            index[HashPixel(px)] = px;
+            continue;
+        }
+        index[HashPixel(px)] = px;
+        out[i++] = px;
+    }
+
+    // 3 通道文件按规范所有像素 alpha 都是 255；对不守规范的文件也保证输出不透明
+    if (parsed.channels == 3) {
+        for (size_t k = 0; k < count; k++) out[k] |= 0xFF000000;
+    }
+    if (header) *header = parsed;
+    return true;
+}
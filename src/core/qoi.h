@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ============ QOI 无损编解码（与 Win32 无关，可在任意平台编译） ============
+// 实现 QOI 1.0 格式（https://qoiformat.org）：单遍、无熵编码，编码和解码都远快于 PNG，
+// 体积通常与快速档位的 PNG 相当。像素与其余模块一致，为直通 alpha 的 32 位 BGRA（0xAARRGGBB）
+
+constexpr size_t kQoiHeaderBytes = 14;
+constexpr size_t kQoiPaddingBytes = 8;   // 文件末尾的结束标记
+constexpr uint64_t kQoiMaxPixels = 400000000; // 规范建议的像素数上限
+
+struct QoiHeader {
+    int width = 0;
+    int height = 0;
+    int channels = 4;   // 3 = RGB（alpha 恒为 255），4 = RGBA；只是元数据，不影响编码流
+    int colorspace = 0; // 0 = sRGB + 线性 alpha，1 = 全线性
+};
+
+// 编码整张图片；channels 写入文件头（不透明图片填 3，其他读取器可据此省掉 alpha 通道）
+std::vector<uint8_t> EncodeQoi(const uint32_t* pixels, int width, int height, int channels);
+// 只解析文件头，用于在解码前判断尺寸
+bool ReadQoiHeader(const uint8_t* data, size_t bytes, QoiHeader* header);
+// 解码到 pixels（自动调整大小）；数据截断或格式不符时返回 false。channels 为 3 时输出 alpha 置 255
+bool DecodeQoi(const uint8_t* data, size_t bytes, std::vector<uint32_t>* pixels, QoiHeader* header);
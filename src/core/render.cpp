@@ -0,0 +1,203 @@
+#include "render.h"
+#include "drawing.h"
+#include "monitor.h"
+#include "renderstate.h"
+#include "startuptrace.h"
+#include "frametrace.h"
+#include "globals.h"
+#include <dwmapi.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#pragma comment(lib, "dwmapi.lib")
+
+static std::mutex s_renderMutex;            // 保护以下请求标志
+static std::condition_variable s_renderCv;
+static bool s_dirty = false;
+static bool s_forceRedraw = false;          // 本帧不论版本号是否变化都要绘制
+static bool s_displayChanged = false;
+static bool s_renderStop = false;
+static std::thread s_renderThread;
+
+static std::atomic<uint64_t> s_requested(0);
+static std::atomic<uint64_t> s_frames(0);
+static std::atomic<uint64_t> s_skipped(0);
+static std::atomic<uint64_t> s_rendered(0);
+static std::atomic<uint64_t> s_presented(0);
+
+// 当前显示器刷新周期（毫秒），取不到时按 60Hz
+static DWORD RefreshIntervalMs() {
+    DEVMODEW mode = {};
+    mode.dmSize = sizeof(mode);
+    if (EnumDisplaySettingsW(nullptr, ENUM_CURRENT_SETTINGS, &mode) && mode.dmDisplayFrequency > 1) {
+        return std::max<DWORD>(1, 1000 / mode.dmDisplayFrequency);
+    }
+    return 16;
+}
+
+// 等到下一次桌面合成，期间到达的请求合并到下一帧
+static void WaitForNextFrame() {
+    if (FAILED(DwmFlush())) Sleep(RefreshIntervalMs());
+}
+
+static void RenderThread(HWND hwnd) {
+    ScopedPerMonitorDpi dpiScope; // 窗口坐标与后备缓冲均按物理像素计算
+    uint64_t drawnVersion = 0; // 上一次绘制所用快照的版本号
+    bool firstPresented = false;
+    std::unique_lock<std::mutex> lock(s_renderMutex);
+    while (true) {
+        // 交互预览之后到点补做一次完整质量重绘
+        ULONGLONG due = GetRefineDueTick();
+        auto ready = [] { return s_renderStop || s_dirty; };
+        if (due) {
+            ULONGLONG now = GetTickCount64();
+            if (now < due) s_renderCv.wait_for(lock, std::chrono::milliseconds(due - now), ready);
+            if (!s_dirty && GetTickCount64() >= due) s_dirty = s_forceRedraw = true;
+        } else {
+            s_renderCv.wait(lock, ready);
+        }
+        if (s_renderStop) break;
+        if (!s_dirty) continue;
+
+        s_dirty = false;
+        bool force = s_forceRedraw || s_displayChanged;
+        bool displayChanged = s_displayChanged;
+        s_forceRedraw = s_displayChanged = false;
+        lock.unlock();
+
+        if (displayChanged) OnDisplayChange();
+        UpdateAutoLoadedImage(); // 可能切换图片并发布新版本，需在取快照之前
+        std::shared_ptr<const RenderState> state = GetRenderState();
+        s_frames++;
+        if (!force && state->version == drawnVersion) {
+            s_skipped++;
+            SessionTrace().Count(TRACE_FRAME_SKIPPED);
+            lock.lock();
+            continue;
+        }
+        drawnVersion = state->version;
+
+        FrameTrace& trace = SessionTrace();
+        trace.BeginFrame();
+        double frameStart = trace.NowMs();
+        FrameStats stats = DrawTransparentWindow(hwnd, *state);
+        trace.Record(TRACE_FRAME, frameStart, trace.NowMs() - frameStart);
+        if (stats.rendered) s_rendered++;
+        if (stats.presented) s_presented++;
+        if (stats.presented && !firstPresented) {
+            firstPresented = true;
+            MarkStartupPhase(L"first-frame");
+            FinishStartupTrace();
+        }
+        if (stats.presented) WaitForNextFrame();
+
+        lock.lock();
+    }
+}
+
+void StartRenderThread(HWND hwnd) {
+    std::lock_guard<std::mutex> lock(s_renderMutex);
+    if (s_renderThread.joinable()) return;
+    s_renderStop = false;
+    s_dirty = s_forceRedraw = true; // 启动后立即绘制第一帧
+    s_renderThread = std::thread(RenderThread, hwnd);
+}
+
+void StopRenderThread() {
+    {
+        std::lock_guard<std::mutex> lock(s_renderMutex);
+        s_renderStop = true;
+    }
+    s_renderCv.notify_all();
+    if (s_renderThread.joinable()) s_renderThread.join();
+}
+
+void RequestRender() {
+    s_requested++;
+    PublishRenderState();
+    {
+        std::lock_guard<std::mutex> lock(s_renderMutex);
+        if (s_dirty) return; // 已有待处理的请求，直接合并
+        s_dirty = true;
+    }
+    s_renderCv.notify_one();
+}
+
+void RequestRedraw() {
+    s_requested++;
+    {
+        std::lock_guard<std::mutex> lock(s_renderMutex);
+        s_forceRedraw = true;
+        if (s_dirty) return;
+        s_dirty = true;
+    }
+    s_renderCv.notify_one();
+}
+
+void RequestDisplayChange() {
+    PublishRenderState(); // 显示器区域和 DPI 可能已变
+    {
+        std::lock_guard<std::mutex> lock(s_renderMutex);
+        s_displayChanged = true;
+        s_dirty = true;
+    }
+    s_renderCv.notify_one();
+}
+
+bool ExportFrameTrace(std::wstring* outPath, std::wstring* outRange) {
+    // 默认写到图片目录，方便和出问题的图片一起发过来；没有图片目录时写到程序数据目录
+    std::wstring dir = GetImageDirectory();
+    DWORD attributes = dir.empty() ? INVALID_FILE_ATTRIBUTES : GetFileAttributesW(dir.c_str());
+    if (attributes == INVALID_FILE_ATTRIBUTES || !(attributes & FILE_ATTRIBUTE_DIRECTORY)) {
+        dir = GetLocalDataDirectory();
+    }
+    if (dir.empty()) return false;
+
+    SYSTEMTIME st;
+    GetLocalTime(&st);
+    wchar_t name[64];
+    swprintf(name, 64, L"GuessDraw-trace-%04d%02d%02d-%02d%02d%02d.csv", st.wYear, st.wMonth, st.wDay,
+             st.wHour, st.wMinute, st.wSecond);
+    std::wstring path = dir;
+    if (path.back() != L'\\' && path.back() != L'/') path += L'\\';
+    path += name;
+
+    TraceExportInfo range;
+    std::string csv = SessionTrace().ToCsv(&range);
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    DWORD written = 0;
+    bool ok = WriteFile(file, csv.data(), (DWORD)csv.size(), &written, nullptr) && written == csv.size();
+    CloseHandle(file);
+    if (!ok) {
+        DeleteFileW(path.c_str());
+        return false;
+    }
+    if (outPath) *outPath = path;
+    if (outRange) {
+        wchar_t text[128];
+        if (range.dropped > 0) {
+            swprintf(text, 128, L"最近 %zu 条记录（第 %u～%u 帧），更早的 %llu 条已被覆盖", range.events,
+                     range.firstFrame, range.lastFrame, (unsigned long long)range.dropped);
+        } else {
+            swprintf(text, 128, L"本次运行的全部 %zu 条记录（第 %u～%u 帧）", range.events, range.firstFrame,
+                     range.lastFrame);
+        }
+        *outRange = text;
+    }
+    return true;
+}
+
+RenderCounters GetRenderCounters() {
+    RenderCounters c;
+    c.requested = s_requested.load();
+    c.frames = s_frames.load();
+    c.skipped = s_skipped.load();
+    c.rendered = s_rendered.load();
+    c.presented = s_presented.load();
+    return c;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <windows.h>
+#include <cstdint>
+#include <string>
+
+// ============ 渲染线程 ============
+// 任意线程调用 RequestRender 只是标记“需要重绘”，渲染线程把同一帧内的多次请求合并为一次绘制，
+// 每次绘制后通过 DwmFlush 等待下一次合成（桌面合成不可用时按显示器刷新率休眠），
+// 因此每个显示刷新周期最多绘制一次，没有变化的帧不会重新生成像素，也不会重复提交。
+// 每帧先比较渲染状态快照的版本号：与上一帧相同且没有外部输入变化时整帧跳过
+
+struct RenderCounters {
+    uint64_t requested = 0;  // RequestRender 调用次数
+    uint64_t frames = 0;     // 合并后实际处理的帧数
+    uint64_t skipped = 0;    // 渲染状态版本未变而整帧跳过的帧数
+    uint64_t rendered = 0;   // 重新生成了像素的帧数
+    uint64_t presented = 0;  // 向窗口提交了画面的帧数
+};
+
+void StartRenderThread(HWND hwnd);
+void StopRenderThread();                // 须在 StopImageCache / GdiplusShutdown 之前调用
+void RequestRender();                   // 渲染参数可能已变：发布新快照并请求重绘（可在任意线程调用）
+void RequestRedraw();                   // 快照之外的输入变化（图片解码完成等），即使版本未变也重绘
+void RequestDisplayChange();            // 显示设置变化：下一帧先重建后备缓冲再绘制
+RenderCounters GetRenderCounters();
+// 把缓冲中的帧耗时记录（最近的一段，见 FrameTrace::ToCsv）导出为 CSV（写到图片目录，文件名带时间），返回是否成功；
+// outRange 为给用户看的覆盖范围说明
+bool ExportFrameTrace(std::wstring* outPath, std::wstring* outRange = nullptr);
@@ -0,0 +1,78 @@
+#include "renderstate.h"
+#include "globals.h"
+#include "monitor.h"
+#include <atomic>
+#include <mutex>
+
+static std::mutex s_publishMutex; // 串行化发布，保证版本号与内容一一对应
+static std::atomic<std::shared_ptr<const RenderState>> s_state(std::make_shared<const RenderState>());
+
+bool RenderState::SameContent(const RenderState& other) const {
+    return imagePath == other.imagePath && imageDirectory == other.imageDirectory &&
+           scale == other.scale && opacity == other.opacity && rotation == other.rotation &&
+           mirrorH == other.mirrorH && mirrorV == other.mirrorV &&
+           grayscale == other.grayscale && removeWhite == other.removeWhite &&
+           autoLoad == other.autoLoad && fitWindow == other.fitWindow && statsHud == other.statsHud &&
+           offsetX == other.offsetX && offsetY == other.offsetY &&
+           monitorX == other.monitorX && monitorY == other.monitorY &&
+           monitorWidth == other.monitorWidth && monitorHeight == other.monitorHeight && dpi == other.dpi;
+}
+
+std::shared_ptr<const RenderState> GetRenderState() {
+    return s_state.load();
+}
+
+// 以当前快照为基础采集原子参数，再由 edit 修改字符串字段，内容变化时发布新版本
+template <typename Edit>
+static uint64_t Publish(Edit edit) {
+    std::lock_guard<std::mutex> lock(s_publishMutex);
+    std::shared_ptr<const RenderState> current = s_state.load();
+
+    auto next = std::make_shared<RenderState>(*current);
+    next->scale = scaleFactor.load();
+    next->opacity = opacityFactor.load();
+    next->rotation = (rotationAngle.load() % 360 + 360) % 360; // 配置文件中可能是负数
+    next->mirrorH = mirrorHorizontal.load();
+    next->mirrorV = mirrorVertical.load();
+    next->grayscale = grayscaleEnabled.load();
+    next->removeWhite = removeWhiteBg.load();
+    next->autoLoad = autoLoadLatest.load();
+    next->fitWindow = fitWindowToImage.load();
+    next->statsHud = showFrameStats.load();
+    next->offsetX = windowOffsetX.load();
+    next->offsetY = windowOffsetY.load();
+    MonitorTarget monitor;
+    if (ResolveTargetMonitor(&monitor)) {
+        next->monitorX = monitor.rect.left;
+        next->monitorY = monitor.rect.top;
+        next->monitorWidth = monitor.rect.right - monitor.rect.left;
+        next->monitorHeight = monitor.rect.bottom - monitor.rect.top;
+        next->dpi = (int)monitor.dpi;
+    }
+    edit(*next);
+
+    if (next->SameContent(*current)) return current->version;
+    next->version = current->version + 1;
+    s_state.store(std::move(next));
+    return current->version + 1;
+}
+
+uint64_t PublishRenderState() {
+    return Publish([](RenderState&) {});
+}
+
+std::wstring GetCurrentImagePath() {
+    return s_state.load()->imagePath;
+}
+
+void SetCurrentImagePath(const std::wstring& path) {
+    Publish([&](RenderState& s) { s.imagePath = path; });
+}
+
+std::wstring GetImageDirectory() {
+    return s_state.load()->imageDirectory;
+}
+
+void SetImageDirectory(const std::wstring& dir) {
+    Publish([&](RenderState& s) { s.imageDirectory = dir; });
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// ============ 渲染状态快照 ============
+// 渲染线程只读取不可变的快照，不直接读全局变量：同一帧内的参数来自同一时刻，
+// 图片路径/目录等非原子字符串也只通过快照和访问函数跨线程传递。
+// 每次内容变化发布新快照，版本号单调递增；版本未变说明没有任何与渲染相关的改动
+
+struct RenderState {
+    uint64_t version = 0;
+    std::wstring imagePath;       // 当前显示的图片
+    std::wstring imageDirectory;  // 图片目录
+    float scale = 0.0f;
+    float opacity = 0.0f;
+    int rotation = 0;
+    bool mirrorH = false;         // 旋转前先左右/上下镜像
+    bool mirrorV = false;
+    bool grayscale = false;
+    bool removeWhite = false;
+    bool autoLoad = false;
+    bool fitWindow = false;
+    bool statsHud = false;        // 叠加层左上角显示帧耗时统计
+    int offsetX = 0;
+    int offsetY = 0;
+    int monitorX = 0;             // 目标显示器区域（物理像素）
+    int monitorY = 0;
+    int monitorWidth = 0;
+    int monitorHeight = 0;
+    int dpi = 96;                 // 目标显示器 DPI
+
+    // 显示器上的实际缩放：用户比例 × DPI 缩放，不同 DPI 的显示器上图片视觉大小一致
+    float PixelScale() const { return scale * dpi / 96.0f; }
+
+    // 除版本号外的全部字段相同
+    bool SameContent(const RenderState& other) const;
+};
+
+// 当前快照（任意线程调用，不会阻塞发布者）
+std::shared_ptr<const RenderState> GetRenderState();
+// 采集全局渲染参数并发布；内容没变时不产生新版本。返回发布后的版本号
+uint64_t PublishRenderState();
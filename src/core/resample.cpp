@@ -0,0 +1,383 @@
+#include "resample.h"
+#include "simd.h"
+#include "workerpool.h"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ============ 权重表 ============
+// 权重为 14 位定点，每个目标位置固定 taps 个抽头，窗口整体落在源范围内（越界部分并入边缘像素）
+static const int WEIGHT_BITS = 14;
+static const int WEIGHT_ONE = 1 << WEIGHT_BITS;
+
+struct WeightTable {
+    int srcSize = 0;
+    int dstSize = 0;
+    ResampleFilter filter = ResampleFilter::Bilinear;
+    int taps = 0;
+    std::vector<int> start;        // 每个目标位置的首个源索引
+    std::vector<int16_t> weights;  // dstSize * taps
+    std::vector<float> fweights;   // 同上，浮点版本（参考实现使用）
+};
+
+static const double PI = 3.14159265358979323846;
+
+static double FilterSupport(ResampleFilter filter) {
+    switch (filter) {
+        case ResampleFilter::Bilinear: return 1.0;
+        case ResampleFilter::Bicubic:  return 2.0;
+        case ResampleFilter::Lanczos3: return 3.0;
+    }
+    return 1.0;
+}
+
+static double Sinc(double x) {
+    if (x == 0.0) return 1.0;
+    x *= PI;
+    return sin(x) / x;
+}
+
+static double FilterWeight(ResampleFilter filter, double x) {
+    x = fabs(x);
+    switch (filter) {
+        case ResampleFilter::Bilinear:
+            return x < 1.0 ? 1.0 - x : 0.0;
+        case ResampleFilter::Bicubic: {
+            // Keys 三次卷积，a = -0.5（Catmull-Rom）
+            const double a = -0.5;
+            if (x < 1.0) return ((a + 2.0) * x - (a + 3.0)) * x * x + 1.0;
+            if (x < 2.0) return (((x - 5.0) * x + 8.0) * x - 4.0) * a;
+            return 0.0;
+        }
+        case ResampleFilter::Lanczos3:
+            return x < 3.0 ? Sinc(x) * Sinc(x / 3.0) : 0.0;
+    }
+    return 0.0;
+}
+
+static std::shared_ptr<const WeightTable> BuildWeightTable(int srcSize, int dstSize, ResampleFilter filter) {
+    auto table = std::make_shared<WeightTable>();
+    table->srcSize = srcSize;
+    table->dstSize = dstSize;
+    table->filter = filter;
+
+    // 缩小时按比例放宽滤波器，起到抗锯齿作用
+    double scale = (double)dstSize / srcSize;
+    double filterScale = scale < 1.0 ? 1.0 / scale : 1.0;
+    double support = FilterSupport(filter) * filterScale;
+    int taps = std::min((int)ceil(support) * 2 + 1, srcSize);
+    table->taps = taps;
+    table->start.resize(dstSize);
+    table->weights.resize((size_t)dstSize * taps);
+    table->fweights.resize((size_t)dstSize * taps);
+
+    std::vector<double> w(taps);
+    for (int d = 0; d < dstSize; d++) {
+        double center = (d + 0.5) / scale - 0.5;
+        int left = (int)floor(center - support);
+        int right = (int)ceil(center + support);
+        int start = std::clamp(left, 0, srcSize - taps);
+        std::fill(w.begin(), w.end(), 0.0);
+
+        double sum = 0.0;
+        for (int j = left; j <= right; j++) {
+            double v = FilterWeight(filter, (j - center) / filterScale);
+            if (v == 0.0) continue;
+            int idx = std::clamp(j, 0, srcSize - 1) - start;
+            if (idx < 0 || idx >= taps) continue; // 超出固定窗口的极小尾部直接丢弃
+            w[idx] += v;
+            sum += v;
+        }
+        if (sum == 0.0) {
+            w[std::clamp((int)lround(center), 0, srcSize - 1) - start] = 1.0;
+            sum = 1.0;
+        }
+
+        // 归一化并转为定点，舍入误差补到最大权重上，保证总和精确为 WEIGHT_ONE
+        int16_t* iw = &table->weights[(size_t)d * taps];
+        float* fw = &table->fweights[(size_t)d * taps];
+        int total = 0, maxIdx = 0;
+        for (int t = 0; t < taps; t++) {
+            double nv = w[t] / sum;
+            fw[t] = (float)nv;
+            iw[t] = (int16_t)lround(nv * WEIGHT_ONE);
+            total += iw[t];
+            if (std::abs(iw[t]) > std::abs(iw[maxIdx])) maxIdx = t;
+        }
+        iw[maxIdx] = (int16_t)(iw[maxIdx] + (WEIGHT_ONE - total));
+        table->start[d] = start;
+    }
+    return table;
+}
+
+// 最近使用的权重表缓存；按住缩放键时尺寸往复变化，少量条目即可命中
+static std::shared_ptr<const WeightTable> GetWeightTable(int srcSize, int dstSize, ResampleFilter filter) {
+    static std::mutex mutex;
+    static std::vector<std::shared_ptr<const WeightTable>> cache;
+    const size_t maxEntries = 16;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t i = 0; i < cache.size(); i++) {
+            const auto& t = cache[i];
+            if (t->srcSize == srcSize && t->dstSize == dstSize && t->filter == filter) {
+                auto hit = t;
+                cache.erase(cache.begin() + i);
+                cache.push_back(hit);
+                return hit;
+            }
+        }
+    }
+
+    auto table = BuildWeightTable(srcSize, dstSize, filter);
+    std::lock_guard<std::mutex> lock(mutex);
+    cache.push_back(table);
+    if (cache.size() > maxEntries) cache.erase(cache.begin());
+    return table;
+}
+
+// ============ 定点卷积 ============
+static inline uint32_t ClampChannel(int v) {
+    v = (v + (1 << (WEIGHT_BITS - 1))) >> WEIGHT_BITS;
+    return (uint32_t)std::clamp(v, 0, 255);
+}
+
+// 预乘格式要求颜色不超过 alpha（负瓣可能使颜色略微越界）
+static inline uint32_t ClampToAlpha(uint32_t px) {
+    uint32_t a = px >> 24;
+    uint32_t b = std::min(px & 0xFF, a);
+    uint32_t g = std::min((px >> 8) & 0xFF, a);
+    uint32_t r = std::min((px >> 16) & 0xFF, a);
+    return b | (g << 8) | (r << 16) | (a << 24);
+}
+
+// 水平一行：dst[x] = Σ src[start + t] * w[t]
+static void HorizontalRowScalar(const uint32_t* src, uint32_t* dst, const WeightTable& tab) {
+    for (int d = 0; d < tab.dstSize; d++) {
+        const uint32_t* s = src + tab.start[d];
+        const int16_t* w = &tab.weights[(size_t)d * tab.taps];
+        int b = 0, g = 0, r = 0, a = 0;
+        for (int t = 0; t < tab.taps; t++) {
+            uint32_t px = s[t];
+            b += (int)(px & 0xFF) * w[t];
+            g += (int)((px >> 8) & 0xFF) * w[t];
+            r += (int)((px >> 16) & 0xFF) * w[t];
+            a += (int)(px >> 24) * w[t];
+        }
+        dst[d] = ClampChannel(b) | (ClampChannel(g) << 8) | (ClampChannel(r) << 16) | (ClampChannel(a) << 24);
+    }
+}
+
+// 垂直一行的 [x0, x1) 段：dst[x] = Σ rows[t][x] * w[t]
+static void VerticalRowScalar(const uint32_t* const* rows, const int16_t* w, int taps, uint32_t* dst, int x0, int x1) {
+    for (int x = x0; x < x1; x++) {
+        int b = 0, g = 0, r = 0, a = 0;
+        for (int t = 0; t < taps; t++) {
+            uint32_t px = rows[t][x];
+            b += (int)(px & 0xFF) * w[t];
+            g += (int)((px >> 8) & 0xFF) * w[t];
+            r += (int)((px >> 16) & 0xFF) * w[t];
+            a += (int)(px >> 24) * w[t];
+        }
+        dst[x] = ClampToAlpha(ClampChannel(b) | (ClampChannel(g) << 8) | (ClampChannel(r) << 16) | (ClampChannel(a) << 24));
+    }
+}
+
+#if GD_X86
+// 把 4 个 32 位累加结果（一个像素的 B,G,R,A）舍入、移位并打包成 8 位像素
+GD_TARGET_SSE2
+static inline __m128i PackAccumulators(__m128i p0, __m128i p1, __m128i p2, __m128i p3) {
+    const __m128i round = _mm_set1_epi32(1 << (WEIGHT_BITS - 1));
+    p0 = _mm_srai_epi32(_mm_add_epi32(p0, round), WEIGHT_BITS);
+    p1 = _mm_srai_epi32(_mm_add_epi32(p1, round), WEIGHT_BITS);
+    p2 = _mm_srai_epi32(_mm_add_epi32(p2, round), WEIGHT_BITS);
+    p3 = _mm_srai_epi32(_mm_add_epi32(p3, round), WEIGHT_BITS);
+    return _mm_packus_epi16(_mm_packs_epi32(p0, p1), _mm_packs_epi32(p2, p3));
+}
+
+// 两个抽头一组：把相邻两像素交错成 [b0 b1 g0 g1 r0 r1 a0 a1]，与 [w0 w1 ...] 做 madd
+GD_TARGET_SSE2
+static void HorizontalRowSse2(const uint32_t* src, uint32_t* dst, const WeightTable& tab) {
+    const __m128i zero = _mm_setzero_si128();
+    const int taps = tab.taps;
+    for (int d = 0; d < tab.dstSize; d++) {
+        const uint32_t* s = src + tab.start[d];
+        const int16_t* w = &tab.weights[(size_t)d * taps];
+        __m128i acc = zero;
+        int t = 0;
+        for (; t + 2 <= taps; t += 2) {
+            __m128i px = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(s + t)), zero);
+            px = _mm_unpacklo_epi16(px, _mm_srli_si128(px, 8));
+            __m128i wv = _mm_set1_epi32((int)(((uint32_t)(uint16_t)w[t + 1] << 16) | (uint16_t)w[t]));
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(px, wv));
+        }
+        if (t < taps) {
+            __m128i px = _mm_unpacklo_epi8(_mm_cvtsi32_si128((int)s[t]), zero);
+            px = _mm_unpacklo_epi16(px, zero);
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(px, _mm_set1_epi32((uint16_t)w[t])));
+        }
+        acc = _mm_srai_epi32(_mm_add_epi32(acc, _mm_set1_epi32(1 << (WEIGHT_BITS - 1))), WEIGHT_BITS);
+        acc = _mm_packus_epi16(_mm_packs_epi32(acc, acc), zero);
+        dst[d] = (uint32_t)_mm_cvtsi128_si32(acc);
+    }
+}
+
+// 每次 4 像素；两行一组交错成 16 位对，与 [w0 w1] 做 madd，4 个累加器分别对应 4 个像素
+GD_TARGET_SSE2
+static void VerticalRowSse2(const uint32_t* const* rows, const int16_t* w, int taps, uint32_t* dst, int width) {
+    const __m128i zero = _mm_setzero_si128();
+    int x = 0;
+    for (; x + 4 <= width; x += 4) {
+        __m128i acc0 = zero, acc1 = zero, acc2 = zero, acc3 = zero;
+        int t = 0;
+        for (; t + 2 <= taps; t += 2) {
+            __m128i a = _mm_loadu_si128((const __m128i*)(rows[t] + x));
+            __m128i b = _mm_loadu_si128((const __m128i*)(rows[t + 1] + x));
+            __m128i wv = _mm_set1_epi32((int)(((uint32_t)(uint16_t)w[t + 1] << 16) | (uint16_t)w[t]));
+            __m128i aLo = _mm_unpacklo_epi8(a, zero), aHi = _mm_unpackhi_epi8(a, zero);
+            __m128i bLo = _mm_unpacklo_epi8(b, zero), bHi = _mm_unpackhi_epi8(b, zero);
+            acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(_mm_unpacklo_epi16(aLo, bLo), wv));
+            acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(_mm_unpackhi_epi16(aLo, bLo), wv));
+            acc2 = _mm_add_epi32(acc2, _mm_madd_epi16(_mm_unpacklo_epi16(aHi, bHi), wv));
+            acc3 = _mm_add_epi32(acc3, _mm_madd_epi16(_mm_unpackhi_epi16(aHi, bHi), wv));
+        }
+        if (t < taps) {
+            __m128i a = _mm_loadu_si128((const __m128i*)(rows[t] + x));
+            __m128i wv = _mm_set1_epi32((uint16_t)w[t]);
+            __m128i aLo = _mm_unpacklo_epi8(a, zero), aHi = _mm_unpackhi_epi8(a, zero);
+            acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(_mm_unpacklo_epi16(aLo, zero), wv));
+            acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(_mm_unpackhi_epi16(aLo, zero), wv));
+            acc2 = _mm_add_epi32(acc2, _mm_madd_epi16(_mm_unpacklo_epi16(aHi, zero), wv));
+            acc3 = _mm_add_epi32(acc3, _mm_madd_epi16(_mm_unpackhi_epi16(aHi, zero), wv));
+        }
+        __m128i px = PackAccumulators(acc0, acc1, acc2, acc3);
+
+        // 颜色钳制到 alpha：把每像素的 alpha 字节广播到四个字节后取无符号最小值
+        __m128i alpha = _mm_srli_epi32(px, 24);
+        alpha = _mm_or_si128(alpha, _mm_slli_epi32(alpha, 8));
+        alpha = _mm_or_si128(alpha, _mm_slli_epi32(alpha, 16));
+        _mm_storeu_si128((__m128i*)(dst + x), _mm_min_epu8(px, alpha));
+    }
+    VerticalRowScalar(rows, w, taps, dst, x, width);
+}
+#endif
+
+bool IsResampleKernelSupported(ResampleKernel kernel) {
+    switch (kernel) {
+        case ResampleKernel::Auto:
+        case ResampleKernel::Scalar: return true;
+        case ResampleKernel::SSE2:   return CpuHasSse2();
+    }
+    return false;
+}
+
+const char* ResampleFilterName(ResampleFilter filter) {
+    switch (filter) {
+        case ResampleFilter::Bilinear: return "bilinear";
+        case ResampleFilter::Bicubic:  return "bicubic";
+        case ResampleFilter::Lanczos3: return "lanczos3";
+    }
+    return "unknown";
+}
+
+const char* ResampleKernelName(ResampleKernel kernel) {
+    switch (kernel) {
+        case ResampleKernel::Auto:   return "auto";
+        case ResampleKernel::Scalar: return "scalar";
+        case ResampleKernel::SSE2:   return "sse2";
+    }
+    return "unknown";
+}
+
+void ResampleImage(const uint32_t* src, int srcW, int srcH, int srcStride,
+                   uint32_t* dst, int dstW, int dstH, int dstStride,
+                   ResampleFilter filter, int threads, ResampleKernel kernel) {
+    if (srcW <= 0 || srcH <= 0 || dstW <= 0 || dstH <= 0) return;
+
+    bool useSse2 = false;
+#if GD_X86
+    static const bool hasSse2 = CpuHasSse2();
+    useSse2 = hasSse2 && (kernel == ResampleKernel::Auto || kernel == ResampleKernel::SSE2);
+#endif
+    (void)kernel;
+
+    // 输出超过约 0.5 MP 时才值得开线程
+    if (threads <= 0) {
+        int hw = (int)std::thread::hardware_concurrency();
+        threads = ((int64_t)dstW * dstH >= (1 << 19)) ? std::clamp(hw, 1, 8) : 1;
+    }
+
+    auto htab = GetWeightTable(srcW, dstW, filter);
+    auto vtab = GetWeightTable(srcH, dstH, filter);
+
+    // 第一趟：水平缩放全部源行到中间缓冲 (srcH x dstW)
+    std::vector<uint32_t> temp((size_t)srcH * dstW);
+    ParallelFor(srcH, threads, [&](int begin, int end) {
+        for (int y = begin; y < end; y++) {
+            const uint32_t* s = src + (size_t)y * srcStride;
+            uint32_t* d = temp.data() + (size_t)y * dstW;
+#if GD_X86
+            if (useSse2) { HorizontalRowSse2(s, d, *htab); continue; }
+#endif
+            HorizontalRowScalar(s, d, *htab);
+        }
+    });
+
+    // 第二趟：垂直缩放
+    const int taps = vtab->taps;
+    ParallelFor(dstH, threads, [&](int begin, int end) {
+        std::vector<const uint32_t*> rows(taps);
+        for (int y = begin; y < end; y++) {
+            for (int t = 0; t < taps; t++) rows[t] = temp.data() + (size_t)(vtab->start[y] + t) * dstW;
+            const int16_t* w = &vtab->weights[(size_t)y * taps];
+            uint32_t* d = dst + (size_t)y * dstStride;
+#if GD_X86
+            if (useSse2) { VerticalRowSse2(rows.data(), w, taps, d, dstW); continue; }
+#endif
+            VerticalRowScalar(rows.data(), w, taps, d, 0, dstW);
+        }
+    });
+}
+
+// ============ 浮点参考实现 ============
+void ResampleImageReference(const uint32_t* src, int srcW, int srcH, int srcStride,
+                            uint32_t* dst, int dstW, int dstH, int dstStride,
+                            ResampleFilter filter) {
+    if (srcW <= 0 || srcH <= 0 || dstW <= 0 || dstH <= 0) return;
+    auto htab = BuildWeightTable(srcW, dstW, filter);
+    auto vtab = BuildWeightTable(srcH, dstH, filter);
+
+    // 水平一趟保留浮点中间结果，不做量化；负瓣造成的越界与定点版一样钳制掉
+    std::vector<float> temp((size_t)srcH * dstW * 4);
+    for (int y = 0; y < srcH; y++) {
+        const uint32_t* s = src + (size_t)y * srcStride;
+        for (int d = 0; d < dstW; d++) {
+            float acc[4] = { 0, 0, 0, 0 };
+            for (int t = 0; t < htab->taps; t++) {
+                uint32_t px = s[htab->start[d] + t];
+                float w = htab->fweights[(size_t)d * htab->taps + t];
+                for (int c = 0; c < 4; c++) acc[c] += ((px >> (c * 8)) & 0xFF) * w;
+            }
+            for (int c = 0; c < 4; c++) temp[((size_t)y * dstW + d) * 4 + c] = std::clamp(acc[c], 0.0f, 255.0f);
+        }
+    }
+
+    for (int y = 0; y < dstH; y++) {
+        for (int x = 0; x < dstW; x++) {
+            float acc[4] = { 0, 0, 0, 0 };
+            for (int t = 0; t < vtab->taps; t++) {
+                float w = vtab->fweights[(size_t)y * vtab->taps + t];
+                const float* p = &temp[((size_t)(vtab->start[y] + t) * dstW + x) * 4];
+                for (int c = 0; c < 4; c++) acc[c] += p[c] * w;
+            }
+            uint32_t px = 0;
+            for (int c = 0; c < 4; c++) {
+                px |= (uint32_t)std::clamp((int)lroundf(acc[c]), 0, 255) << (c * 8);
+            }
+            dst[(size_t)y * dstStride + x] = ClampToAlpha(px);
+        }
+    }
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+
+// ============ 可分离重采样（与 Win32 无关，可在任意平台编译） ============
+// 像素为 32 位 BGRA，四个通道独立滤波；输入应为预乘 alpha，输出会把颜色钳制到不超过 alpha
+
+// 滤波器
+enum class ResampleFilter { Bilinear, Bicubic, Lanczos3 };
+
+// 内核实现，Auto 按运行时 CPU 能力自动选择
+enum class ResampleKernel { Auto, Scalar, SSE2 };
+
+// 将 src (srcW x srcH) 缩放到 dst (dstW x dstH)，stride 以像素为单位
+// 先水平后垂直两趟定点卷积，权重表按 (源尺寸, 目标尺寸, 滤波器) 预计算并缓存
+// threads: 0 = 自动（大图才启用多线程），1 = 单线程
+void ResampleImage(const uint32_t* src, int srcW, int srcH, int srcStride,
+                   uint32_t* dst, int dstW, int dstH, int dstStride,
+                   ResampleFilter filter, int threads = 0,
+                   ResampleKernel kernel = ResampleKernel::Auto);
+
+// 浮点参考实现（同样的权重，全程浮点、无中间量化），用于基准对比与误差校验。
+// 中间结果与定点实现一样钳制到 [0, 255]（定点版的中间缓冲是 8 位像素），差异只来自定点权重与舍入
+void ResampleImageReference(const uint32_t* src, int srcW, int srcH, int srcStride,
+                            uint32_t* dst, int dstW, int dstH, int dstStride,
+                            ResampleFilter filter);
+
+bool IsResampleKernelSupported(ResampleKernel kernel);
+const char* ResampleFilterName(ResampleFilter filter);
+const char* ResampleKernelName(ResampleKernel kernel);
@@ -0,0 +1,55 @@
+#pragma once
+
+// ============ SIMD 编译/运行时检测（与 Win32 无关） ============
+// 各内核在编译期用 GD_TARGET_* 单独开启指令集，运行时再按 CPU 能力选择实现，
+// 因此整个工程无需全局加 -mavx2，老 CPU 上也能正常运行标量/SSE2 路径。
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define GD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#else
+#define GD_X86 0
+#endif
+
+#if GD_X86 && (defined(__GNUC__) || defined(__clang__))
+#define GD_TARGET_SSE2 __attribute__((target("sse2")))
+#define GD_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define GD_TARGET_SSE2
+#define GD_TARGET_AVX2
+#endif
+
+// 当前 CPU 是否支持 SSE2
+inline bool CpuHasSse2() {
+#if !GD_X86
+    return false;
+#elif defined(__x86_64__) || defined(_M_X64)
+    return true; // x64 基线指令集
+#elif defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[3] & (1 << 26)) != 0;
+#else
+    return __builtin_cpu_supports("sse2");
+#endif
+}
+
+// 当前 CPU 及操作系统是否支持 AVX2（MSVC 下需额外确认 OS 保存了 YMM 寄存器）
+inline bool CpuHasAvx2() {
+#if !GD_X86
+    return false;
+#elif defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
@@ -0,0 +1,70 @@
+#include "startuptrace.h"
+#include "globals.h"
+#include <mutex>
+#include <string>
+
+static std::mutex s_traceMutex;            // 保护以下状态
+static const int kMaxPhases = 16;
+static const wchar_t* s_phaseNames[kMaxPhases];
+static double s_phaseMs[kMaxPhases];
+static int s_phaseCount = 0;
+static bool s_traceFinished = false;
+
+// 进程创建至今的毫秒数；进程创建时间包含加载器和静态初始化，比从 WinMain 计时更接近用户感受
+static double MsSinceProcessStart() {
+    FILETIME creation, exitTime, kernel, user, now;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exitTime, &kernel, &user)) return 0.0;
+    GetSystemTimePreciseAsFileTime(&now);
+    ULONGLONG c = ((ULONGLONG)creation.dwHighDateTime << 32) | creation.dwLowDateTime;
+    ULONGLONG n = ((ULONGLONG)now.dwHighDateTime << 32) | now.dwLowDateTime;
+    return n > c ? (n - c) / 10000.0 : 0.0; // FILETIME 单位为 100ns
+}
+
+void MarkStartupPhase(const wchar_t* phase) {
+    double ms = MsSinceProcessStart();
+    std::lock_guard<std::mutex> lock(s_traceMutex);
+    if (s_traceFinished || s_phaseCount >= kMaxPhases) return;
+    s_phaseNames[s_phaseCount] = phase;
+    s_phaseMs[s_phaseCount] = ms;
+    s_phaseCount++;
+}
+
+void FinishStartupTrace() {
+    std::wstring line;
+    {
+        std::lock_guard<std::mutex> lock(s_traceMutex);
+        if (s_traceFinished) return;
+        s_traceFinished = true;
+
+        SYSTEMTIME st;
+        GetLocalTime(&st);
+        wchar_t buf[64];
+        swprintf(buf, 64, L"%04d-%02d-%02d %02d:%02d:%02d", st.wYear, st.wMonth, st.wDay,
+                 st.wHour, st.wMinute, st.wSecond);
+        line = buf;
+        for (int i = 0; i < s_phaseCount; i++) {
+            swprintf(buf, 64, L" %ls=%.1f", s_phaseNames[i], s_phaseMs[i]);
+            line += buf;
+        }
+        line += L"\n";
+    }
+    OutputDebugStringW((L"GuessDraw startup (ms): " + line).c_str());
+
+    const std::wstring& dir = GetLocalDataDirectory();
+    if (dir.empty()) return;
+    std::wstring path = dir + L"\\startup.log";
+
+    // 超过 256KB 时从头开始，只保留近期记录
+    WIN32_FILE_ATTRIBUTE_DATA fad;
+    bool tooLarge = GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &fad) &&
+                    (fad.nFileSizeHigh != 0 || fad.nFileSizeLow > 256 * 1024);
+    HANDLE file = CreateFileW(path.c_str(), FILE_APPEND_DATA, FILE_SHARE_READ, nullptr,
+                              tooLarge ? CREATE_ALWAYS : OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return;
+    int bytes = WideCharToMultiByte(CP_UTF8, 0, line.c_str(), (int)line.size(), nullptr, 0, nullptr, nullptr);
+    std::string utf8(bytes, '\0');
+    WideCharToMultiByte(CP_UTF8, 0, line.c_str(), (int)line.size(), utf8.data(), bytes, nullptr, nullptr);
+    DWORD written = 0;
+    WriteFile(file, utf8.data(), (DWORD)utf8.size(), &written, nullptr);
+    CloseHandle(file);
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+// ============ 启动耗时记录 ============
+// 记录从进程创建到各启动阶段完成的耗时，首帧出现后追加一行到 %LOCALAPPDATA%\GuessDraw\startup.log
+// 并输出到调试器，便于跨版本比较“启动到叠加层出现”的时间
+
+// 标记一个阶段完成（任意线程调用；phase 须为字符串字面量）
+void MarkStartupPhase(const wchar_t* phase);
+// 写出本次启动的记录，只有第一次调用生效（首帧提交后或退出时调用）
+void FinishStartupTrace();
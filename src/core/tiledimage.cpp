@@ -0,0 +1,248 @@
+#include "tiledimage.h"
+#include "globals.h"
+#include "render.h"
+#include <wincodec.h>
+#include <wrl/client.h>
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#pragma comment(lib, "windowscodecs.lib")
+
+using Microsoft::WRL::ComPtr;
+
+static std::mutex s_tileMutex;                       // 保护各 TiledImage::cache 与以下请求状态
+static std::condition_variable s_tileCv;
+static std::shared_ptr<TiledImage> s_tileTarget;     // 当前显示的超大图片
+static std::vector<TileKey> s_tileQueue;             // 待解码的块，按优先级排列
+static std::thread s_tileThread;
+static bool s_tileStop = false;
+
+// WIC 解码器，统一转换为直通 alpha 的 32 位 BGRA（与 GDI+ PixelFormat32bppARGB 的内存布局一致）
+struct WicSource {
+    ComPtr<IWICImagingFactory> factory;
+    ComPtr<IWICBitmapDecoder> decoder;
+    ComPtr<IWICBitmapFrameDecode> frame;
+    ComPtr<IWICFormatConverter> converter;
+    UINT width = 0;
+    UINT height = 0;
+};
+
+static bool OpenWicSource(const std::wstring& path, WicSource* out) {
+    if (FAILED(CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER,
+                                IID_PPV_ARGS(&out->factory)))) return false;
+    if (FAILED(out->factory->CreateDecoderFromFilename(path.c_str(), nullptr, GENERIC_READ,
+                                                       WICDecodeMetadataCacheOnDemand, &out->decoder))) return false;
+    if (FAILED(out->decoder->GetFrame(0, &out->frame))) return false;
+    if (FAILED(out->frame->GetSize(&out->width, &out->height))) return false;
+    if (FAILED(out->factory->CreateFormatConverter(&out->converter))) return false;
+    return SUCCEEDED(out->converter->Initialize(out->frame.Get(), GUID_WICPixelFormat32bppBGRA,
+                                                WICBitmapDitherTypeNone, nullptr, 0.0,
+                                                WICBitmapPaletteTypeCustom));
+}
+
+// 第 level 级的像素源：第 0 级直接读转换器，其余级别经 Fant 缩放器流式缩小，不生成整张中间图
+static IWICBitmapSource* LevelSource(WicSource& source, std::vector<ComPtr<IWICBitmapSource>>& levels,
+                                     int width, int height, int level) {
+    if (level == 0) return source.converter.Get();
+    if ((int)levels.size() <= level) levels.resize(level + 1);
+    if (!levels[level]) {
+        int lw, lh;
+        TileLevelSize(width, height, level, &lw, &lh);
+        ComPtr<IWICBitmapScaler> scaler;
+        if (FAILED(source.factory->CreateBitmapScaler(&scaler)) ||
+            FAILED(scaler->Initialize(source.converter.Get(), (UINT)lw, (UINT)lh, WICBitmapInterpolationModeFant))) {
+            return nullptr;
+        }
+        levels[level] = scaler;
+    }
+    return levels[level].Get();
+}
+
+bool ProbeImageSize(const std::wstring& path, int* width, int* height) {
+    WicSource source;
+    if (!OpenWicSource(path, &source)) return false;
+    *width = (int)source.width;
+    *height = (int)source.height;
+    return true;
+}
+
+bool ShouldDecodeTiled(int width, int height) {
+    uint64_t bytes = (uint64_t)width * height * 4 * 4 / 3; // 与解码缓存的计量方式一致（含 mip 链）
+    uint64_t cap = (uint64_t)std::max(0, cacheMemoryMB.load()) * 1024 * 1024;
+    return bytes > cap / 2 || (uint64_t)width * height * 4 > 0x7FFFFFFFu; // 后者超出 GDI+ 的处理能力
+}
+
+std::shared_ptr<TiledImage> OpenTiledImage(const std::wstring& path, int width, int height,
+                                           std::vector<uint32_t>* overview, int* overviewW, int* overviewH) {
+    WicSource source;
+    if (!OpenWicSource(path, &source)) return nullptr;
+
+    auto image = std::make_shared<TiledImage>();
+    image->path = path;
+    image->width = width;
+    image->height = height;
+
+    // 最长边不超过 kOverviewMaxSide 的第一个级别作为常驻缩略级
+    int lw = width, lh = height;
+    while (std::max(lw, lh) > kOverviewMaxSide) {
+        image->overviewLevel++;
+        TileLevelSize(width, height, image->overviewLevel, &lw, &lh);
+    }
+
+    std::vector<ComPtr<IWICBitmapSource>> levels;
+    IWICBitmapSource* levelSource = LevelSource(source, levels, width, height, image->overviewLevel);
+    if (!levelSource) return nullptr;
+    overview->resize((size_t)lw * lh);
+    if (FAILED(levelSource->CopyPixels(nullptr, (UINT)lw * 4, (UINT)(overview->size() * 4), (BYTE*)overview->data()))) {
+        return nullptr;
+    }
+    *overviewW = lw;
+    *overviewH = lh;
+    return image;
+}
+
+// 解码同一级同一行的一批块：一次读取覆盖它们的横条再切分，顺序解码的格式不必反复从头解码
+static std::vector<std::pair<TileKey, std::shared_ptr<const TilePixels>>>
+DecodeTileRow(WicSource& source, std::vector<ComPtr<IWICBitmapSource>>& levels,
+              const TiledImage& image, const std::vector<TileKey>& batch) {
+    std::vector<std::pair<TileKey, std::shared_ptr<const TilePixels>>> result;
+    int level = batch.front().level;
+    int row = batch.front().y;
+    IWICBitmapSource* levelSource = LevelSource(source, levels, image.width, image.height, level);
+    if (!levelSource) return result;
+
+    int lw, lh;
+    TileLevelSize(image.width, image.height, level, &lw, &lh);
+    int tx0 = batch.front().x, tx1 = batch.front().x;
+    for (const TileKey& t : batch) {
+        tx0 = std::min(tx0, t.x);
+        tx1 = std::max(tx1, t.x);
+    }
+    WICRect strip;
+    strip.X = tx0 * kTileSize;
+    strip.Y = row * kTileSize;
+    strip.Width = std::min(lw, (tx1 + 1) * kTileSize) - strip.X;
+    strip.Height = std::min(lh, (row + 1) * kTileSize) - strip.Y;
+    if (strip.Width <= 0 || strip.Height <= 0) return result;
+
+    std::vector<uint32_t> pixels((size_t)strip.Width * strip.Height);
+    if (FAILED(levelSource->CopyPixels(&strip, (UINT)strip.Width * 4, (UINT)(pixels.size() * 4), (BYTE*)pixels.data()))) {
+        return result;
+    }
+
+    for (const TileKey& t : batch) {
+        auto tile = std::make_shared<TilePixels>();
+        int x0 = t.x * kTileSize - strip.X;
+        tile->width = std::min(kTileSize, strip.Width - x0);
+        tile->height = strip.Height;
+        if (tile->width <= 0) continue;
+        tile->pixels.resize((size_t)tile->width * tile->height);
+        for (int y = 0; y < tile->height; y++) {
+            std::copy_n(pixels.data() + (size_t)y * strip.Width + x0, tile->width,
+                        tile->pixels.data() + (size_t)y * tile->width);
+        }
+        result.emplace_back(t, std::move(tile));
+    }
+    return result;
+}
+
+// ============ 分块线程 ============
+static void TileThread() {
+    CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+    WicSource source;
+    std::wstring sourcePath;                              // source 对应的文件，跟随当前图片重新打开
+    std::vector<ComPtr<IWICBitmapSource>> levels;
+    ULONGLONG lastRedraw = 0;
+
+    std::unique_lock<std::mutex> lock(s_tileMutex);
+    while (true) {
+        s_tileCv.wait(lock, [] { return s_tileStop || !s_tileQueue.empty(); });
+        if (s_tileStop) break;
+
+        // 取优先级最高的块，并把队列中同级同行的块合并为一次读取
+        std::shared_ptr<TiledImage> image = s_tileTarget;
+        TileKey first = s_tileQueue.front();
+        std::vector<TileKey> batch;
+        for (auto it = s_tileQueue.begin(); it != s_tileQueue.end();) {
+            if (it->level == first.level && it->y == first.y) {
+                batch.push_back(*it);
+                it = s_tileQueue.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        lock.unlock();
+
+        if (sourcePath != image->path) {
+            levels.clear();
+            source = WicSource();
+            sourcePath = OpenWicSource(image->path, &source) ? image->path : L"";
+        }
+        std::vector<std::pair<TileKey, std::shared_ptr<const TilePixels>>> decoded;
+        if (!sourcePath.empty()) decoded = DecodeTileRow(source, levels, *image, batch);
+
+        lock.lock();
+        if (decoded.empty() || image != s_tileTarget) continue; // 解码期间已切换到别的图片
+        for (auto& d : decoded) image->cache.Insert(d.first, std::move(d.second));
+        image->stamp++;
+
+        // 连续到达的块合并为一次重绘，避免每块都重新拼接整个可见区域
+        ULONGLONG now = GetTickCount64();
+        if (s_tileQueue.empty() || now - lastRedraw >= 100) {
+            lastRedraw = now;
+            lock.unlock();
+            RequestRedraw();
+            lock.lock();
+        }
+    }
+    lock.unlock();
+
+    levels.clear();
+    source = WicSource();
+    CoUninitialize();
+}
+
+void RequestTiles(const std::shared_ptr<TiledImage>& image, const std::vector<TileKey>& tiles) {
+    std::lock_guard<std::mutex> lock(s_tileMutex);
+    if (s_tileTarget != image) {
+        if (s_tileTarget) s_tileTarget->cache.Clear(); // 只为当前图片保留块
+        s_tileTarget = image;
+    }
+
+    // 容量至少是可见块的两倍，避免可见块互相挤出缓存后反复解码
+    size_t visibleBytes = tiles.size() * kTileSize * kTileSize * 4;
+    size_t configured = (size_t)std::max(0, tileMemoryMB.load()) * 1024 * 1024;
+    image->cache.SetCapacity(std::max(configured, visibleBytes * 2));
+
+    s_tileQueue.clear();
+    for (const TileKey& t : tiles) {
+        if (!image->cache.Contains(t)) s_tileQueue.push_back(t);
+    }
+    if (s_tileQueue.empty()) return;
+    if (!s_tileThread.joinable() && !s_tileStop) s_tileThread = std::thread(TileThread);
+    s_tileCv.notify_all();
+}
+
+int ComposeTiledRegion(TiledImage& image, int level, const TileRect& rect,
+                       const uint32_t* overview, int overviewW, int overviewH, uint32_t* dst) {
+    int lw, lh;
+    TileLevelSize(image.width, image.height, level, &lw, &lh);
+    std::lock_guard<std::mutex> lock(s_tileMutex);
+    return ComposeTileRegion(image.cache, level, lw, lh, rect, overview, overviewW, overviewH, dst);
+}
+
+void StopTileLoader() {
+    {
+        std::lock_guard<std::mutex> lock(s_tileMutex);
+        s_tileStop = true;
+        s_tileQueue.clear();
+    }
+    s_tileCv.notify_all();
+    if (s_tileThread.joinable()) s_tileThread.join();
+
+    std::lock_guard<std::mutex> lock(s_tileMutex);
+    if (s_tileTarget) s_tileTarget->cache.Clear();
+    s_tileTarget.reset();
+}
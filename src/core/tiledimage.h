@@ -0,0 +1,40 @@
+#pragma once
+
+#include <windows.h>
+#include "tiles.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// ============ 超大图片分块解码 ============
+// 整张解码会占用缓存上限一半以上的图片（扫描稿、地图等）不再整张解码：解码线程只生成一张常驻的缩略级，
+// 显示时按视口向后台分块线程请求可见的块。块经 WIC 按行批量解码，缓存总量受 [Cache] TileMemoryMB 约束
+
+constexpr int kOverviewMaxSide = 2048; // 缩略级最长边上限
+
+struct TiledImage {
+    std::wstring path;
+    int width = 0;                     // 原图尺寸
+    int height = 0;
+    int overviewLevel = 0;             // 缩略级对应的级别
+    std::atomic<uint64_t> stamp{ 0 };  // 每到达一批块递增，用于判断拼接结果是否过期
+    TileCache cache;                   // 由 tiledimage.cpp 内部的锁保护
+};
+
+// 只读文件头取尺寸，不解码像素（调用线程须已初始化 COM）
+bool ProbeImageSize(const std::wstring& path, int* width, int* height);
+// 整张解码是否会超出内存预算，需要改用分块
+bool ShouldDecodeTiled(int width, int height);
+// 打开超大图片，把缩略级解码到 overview（直通 alpha 的 BGRA）；调用线程须已初始化 COM
+std::shared_ptr<TiledImage> OpenTiledImage(const std::wstring& path, int width, int height,
+                                           std::vector<uint32_t>* overview, int* overviewW, int* overviewH);
+// 请求 tiles（按优先级排列）并替换之前的请求，已缓存的块直接跳过；块到达后请求重绘
+// 切换到另一张超大图片时，上一张的块全部释放
+void RequestTiles(const std::shared_ptr<TiledImage>& image, const std::vector<TileKey>& tiles);
+// 拼接第 level 级中的 rect 区域，缺失的块用缩略级填充；返回缺失块数
+int ComposeTiledRegion(TiledImage& image, int level, const TileRect& rect,
+                       const uint32_t* overview, int overviewW, int overviewH, uint32_t* dst);
+// 退出前停止分块线程
+void StopTileLoader();
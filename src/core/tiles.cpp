@@ -0,0 +1,202 @@
+#include "tiles.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+void TileLevelSize(int width, int height, int level, int* levelW, int* levelH) {
+    int w = std::max(1, width), h = std::max(1, height);
+    for (int i = 0; i < level && (w > 1 || h > 1); i++) {
+        w = std::max(1, w / 2);
+        h = std::max(1, h / 2);
+    }
+    *levelW = w;
+    *levelH = h;
+}
+
+int SelectTileLevel(int width, int height, float scale) {
+    int dstW = std::max(1, (int)(width * scale));
+    int dstH = std::max(1, (int)(height * scale));
+    int level = 0;
+    int w = std::max(1, width), h = std::max(1, height);
+    while (w > 1 || h > 1) {
+        int nw = std::max(1, w / 2);
+        int nh = std::max(1, h / 2);
+        if (nw < dstW || nh < dstH) break;
+        level++;
+        w = nw;
+        h = nh;
+    }
+    return level;
+}
+
+bool VisibleTileRect(const TileView& view, int level, TileRect* out) {
+    if (view.imageW <= 0 || view.imageH <= 0 || view.scale <= 0.0f || view.viewW <= 0 || view.viewH <= 0) {
+        return false;
+    }
+
+    // 视口四角逆变换回原图坐标：平移到图片中心 → 逆时针转回 → 除以缩放
+    double rad = view.rotation * 3.14159265358979 / 180.0;
+    double c = cos(rad), s = sin(rad);
+    const double corners[4][2] = {
+        { 0.0, 0.0 }, { (double)view.viewW, 0.0 }, { 0.0, (double)view.viewH }, { (double)view.viewW, (double)view.viewH }
+    };
+    double minX = 1e300, minY = 1e300, maxX = -1e300, maxY = -1e300;
+    for (const auto& p : corners) {
+        double dx = p[0] - view.centerX;
+        double dy = p[1] - view.centerY;
+        double ix = ( dx * c + dy * s) / view.scale + view.imageW * 0.5;
+        double iy = (-dx * s + dy * c) / view.scale + view.imageH * 0.5;
+        minX = std::min(minX, ix);
+        minY = std::min(minY, iy);
+        maxX = std::max(maxX, ix);
+        maxY = std::max(maxY, iy);
+    }
+    minX = std::max(minX, 0.0);
+    minY = std::max(minY, 0.0);
+    maxX = std::min(maxX, (double)view.imageW);
+    maxY = std::min(maxY, (double)view.imageH);
+    if (minX >= maxX || minY >= maxY) return false;
+
+    // 换算到第 level 级，外扩滤波核半径后对齐块边界
+    int levelW, levelH;
+    TileLevelSize(view.imageW, view.imageH, level, &levelW, &levelH);
+    double sx = (double)levelW / view.imageW;
+    double sy = (double)levelH / view.imageH;
+    int x0 = std::max(0, (int)floor(minX * sx) - 2);
+    int y0 = std::max(0, (int)floor(minY * sy) - 2);
+    int x1 = std::min(levelW, (int)ceil(maxX * sx) + 2);
+    int y1 = std::min(levelH, (int)ceil(maxY * sy) + 2);
+    x0 = x0 / kTileSize * kTileSize;
+    y0 = y0 / kTileSize * kTileSize;
+    x1 = std::min(levelW, (x1 + kTileSize - 1) / kTileSize * kTileSize);
+    y1 = std::min(levelH, (y1 + kTileSize - 1) / kTileSize * kTileSize);
+    if (x0 >= x1 || y0 >= y1) return false;
+
+    out->x = x0;
+    out->y = y0;
+    out->width = x1 - x0;
+    out->height = y1 - y0;
+    return true;
+}
+
+std::vector<TileKey> TilesInRect(int level, const TileRect& rect, float focusX, float focusY) {
+    std::vector<TileKey> tiles;
+    if (rect.width <= 0 || rect.height <= 0) return tiles;
+    int tx0 = rect.x / kTileSize, tx1 = (rect.x + rect.width - 1) / kTileSize;
+    int ty0 = rect.y / kTileSize, ty1 = (rect.y + rect.height - 1) / kTileSize;
+    for (int ty = ty0; ty <= ty1; ty++) {
+        for (int tx = tx0; tx <= tx1; tx++) tiles.push_back({ level, tx, ty });
+    }
+
+    auto distance = [&](const TileKey& t) {
+        float dx = (t.x + 0.5f) * kTileSize - focusX;
+        float dy = (t.y + 0.5f) * kTileSize - focusY;
+        return dx * dx + dy * dy;
+    };
+    std::stable_sort(tiles.begin(), tiles.end(),
+                     [&](const TileKey& a, const TileKey& b) { return distance(a) < distance(b); });
+    return tiles;
+}
+
+// ============ 块缓存 ============
+
+static size_t TileBytes(const TilePixels& tile) {
+    return tile.pixels.size() * sizeof(uint32_t);
+}
+
+void TileCache::SetCapacity(size_t bytes) {
+    m_capacity = bytes;
+    Trim();
+}
+
+bool TileCache::Contains(const TileKey& key) const {
+    return m_index.count(key) != 0;
+}
+
+std::shared_ptr<const TilePixels> TileCache::Find(const TileKey& key) {
+    auto it = m_index.find(key);
+    if (it == m_index.end()) return nullptr;
+    m_lru.splice(m_lru.begin(), m_lru, it->second);
+    return it->second->second;
+}
+
+void TileCache::Insert(const TileKey& key, std::shared_ptr<const TilePixels> tile) {
+    if (!tile) return;
+    auto it = m_index.find(key);
+    if (it != m_index.end()) {
+        m_bytes -= TileBytes(*it->second->second);
+        m_lru.erase(it->second);
+        m_index.erase(it);
+    }
+    m_bytes += TileBytes(*tile);
+    m_lru.emplace_front(key, std::move(tile));
+    m_index[key] = m_lru.begin();
+    Trim();
+}
+
+void TileCache::Clear() {
+    m_lru.clear();
+    m_index.clear();
+    m_bytes = 0;
+}
+
+void TileCache::Trim() {
+    while (m_bytes > m_capacity && !m_lru.empty()) {
+        m_bytes -= TileBytes(*m_lru.back().second);
+        m_index.erase(m_lru.back().first);
+        m_lru.pop_back();
+    }
+}
+
+// ============ 区域拼接 ============
+
+int ComposeTileRegion(TileCache& cache, int level, int levelW, int levelH, const TileRect& rect,
+                      const uint32_t* fallback, int fallbackW, int fallbackH, uint32_t* dst) {
+    int missing = 0;
+    int tx0 = rect.x / kTileSize, tx1 = (rect.x + rect.width - 1) / kTileSize;
+    int ty0 = rect.y / kTileSize, ty1 = (rect.y + rect.height - 1) / kTileSize;
+    std::vector<int> fallbackX;
+
+    for (int ty = ty0; ty <= ty1; ty++) {
+        for (int tx = tx0; tx <= tx1; tx++) {
+            // 块与 rect 的交集（rect 坐标）
+            int x0 = std::max(rect.x, tx * kTileSize), x1 = std::min(rect.x + rect.width, (tx + 1) * kTileSize);
+            int y0 = std::max(rect.y, ty * kTileSize), y1 = std::min(rect.y + rect.height, (ty + 1) * kTileSize);
+            x1 = std::min(x1, levelW);
+            y1 = std::min(y1, levelH);
+            if (x0 >= x1 || y0 >= y1) continue;
+
+            std::shared_ptr<const TilePixels> tile = cache.Find({ level, tx, ty });
+            if (tile && tile->width >= x1 - tx * kTileSize && tile->height >= y1 - ty * kTileSize) {
+                size_t rowBytes = (size_t)(x1 - x0) * 4;
+                for (int y = y0; y < y1; y++) {
+                    const uint32_t* src = tile->pixels.data() + (size_t)(y - ty * kTileSize) * tile->width +
+                                          (x0 - tx * kTileSize);
+                    memcpy(dst + (size_t)(y - rect.y) * rect.width + (x0 - rect.x), src, rowBytes);
+                }
+                continue;
+            }
+
+            // 缺失：从低分辨率版本最近邻取样
+            missing++;
+            if (!fallback || fallbackW <= 0 || fallbackH <= 0) {
+                for (int y = y0; y < y1; y++) {
+                    uint32_t* row = dst + (size_t)(y - rect.y) * rect.width;
+                    std::fill(row + (x0 - rect.x), row + (x1 - rect.x), 0u);
+                }
+                continue;
+            }
+            fallbackX.resize(x1 - x0);
+            for (int x = x0; x < x1; x++) {
+                fallbackX[x - x0] = std::min(fallbackW - 1, (int)((int64_t)x * fallbackW / levelW));
+            }
+            for (int y = y0; y < y1; y++) {
+                int fy = std::min(fallbackH - 1, (int)((int64_t)y * fallbackH / levelH));
+                const uint32_t* src = fallback + (size_t)fy * fallbackW;
+                uint32_t* row = dst + (size_t)(y - rect.y) * rect.width + (x0 - rect.x);
+                for (int x = 0; x < x1 - x0; x++) row[x] = src[fallbackX[x]];
+            }
+        }
+    }
+    return missing;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <vector>
+
+// ============ 分块图像（与 Win32 无关，可在任意平台编译） ============
+// 超大图片不整张解码：每个分辨率级别按 kTileSize 见方切块，只取与视口相交的块，
+// 内存随屏幕尺寸而不是原图尺寸增长。级别尺寸与 MipChain 相同：每级宽高为上一级的一半（向下取整，至少为 1）
+
+constexpr int kTileSize = 256;
+
+struct TileKey {
+    int level = 0;
+    int x = 0;  // 块列号
+    int y = 0;  // 块行号
+
+    bool operator==(const TileKey&) const = default;
+    auto operator<=>(const TileKey&) const = default;
+};
+
+// 解码后的一块像素（直通 alpha 的 32 位 BGRA），边缘块可能小于 kTileSize
+struct TilePixels {
+    int width = 0;
+    int height = 0;
+    std::vector<uint32_t> pixels;
+};
+
+// 某一级中的像素矩形
+struct TileRect {
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+
+    bool operator==(const TileRect&) const = default;
+};
+
+// 第 level 级的宽高
+void TileLevelSize(int width, int height, int level, int* levelW, int* levelH);
+// 宽高都不小于 (width, height) * scale 的最小级别，与 MipChain::SelectLevel 的选择一致
+int SelectTileLevel(int width, int height, float scale);
+
+// 视口：原图按 scale 缩放、绕自身中心顺时针旋转 rotation 度后，中心位于视口内 (centerX, centerY)
+struct TileView {
+    int imageW = 0;
+    int imageH = 0;
+    float scale = 1.0f;
+    int rotation = 0;
+    float centerX = 0.0f;
+    float centerY = 0.0f;
+    int viewW = 0;
+    int viewH = 0;
+};
+
+// 视口内可见部分在第 level 级中的包围矩形：外扩 2 像素留给重采样滤波核，再对齐到块边界
+// 图片完全不在视口内时返回 false
+bool VisibleTileRect(const TileView& view, int level, TileRect* out);
+
+// rect 覆盖的全部块，按块中心到 (focusX, focusY)（第 level 级坐标）的距离由近及远
+std::vector<TileKey> TilesInRect(int level, const TileRect& rect, float focusX, float focusY);
+
+// 有内存上限的块缓存（LRU）；不加锁，由调用方保证互斥
+class TileCache {
+public:
+    void SetCapacity(size_t bytes);          // 缩小容量时立即淘汰
+    bool Contains(const TileKey& key) const;
+    std::shared_ptr<const TilePixels> Find(const TileKey& key); // 命中时移到 LRU 头部
+    void Insert(const TileKey& key, std::shared_ptr<const TilePixels> tile); // 超出容量时从最久未用的块开始淘汰
+    void Clear();
+
+    size_t Bytes() const { return m_bytes; }
+    size_t Count() const { return m_index.size(); }
+
+private:
+    using Entry = std::pair<TileKey, std::shared_ptr<const TilePixels>>;
+
+    void Trim();
+
+    size_t m_capacity = 0;
+    size_t m_bytes = 0;
+    std::list<Entry> m_lru;                                   // 头部为最近使用
+    std::map<TileKey, std::list<Entry>::iterator> m_index;
+};
+
+// 把第 level 级（尺寸 levelW x levelH）中 rect 覆盖的块拼到 dst（stride = rect.width）
+// 尚未解码的块用 fallback（整图的低分辨率版本，fallbackW x fallbackH）最近邻放大填充，画面不会出现空洞
+// 返回缺失的块数
+int ComposeTileRegion(TileCache& cache, int level, int levelW, int levelH, const TileRect& rect,
+                      const uint32_t* fallback, int fallbackW, int fallbackH, uint32_t* dst);
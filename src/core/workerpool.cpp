@@ -0,0 +1,108 @@
+#include "workerpool.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 工作线程数上限（加上调用线程最多 16 路并行）
+static const int kMaxWorkers = 15;
+
+// 一次 ParallelFor 调用：各线程用 next 领取分段，done 计数完成的分段
+struct ParallelJob {
+    const std::function<void(int, int)>* fn = nullptr;
+    int count = 0;
+    int chunk = 0;
+    int chunks = 0;
+    std::atomic<int> next{0};
+    std::atomic<int> done{0};
+    std::mutex mutex;
+    std::condition_variable finished;
+
+    // 领取并执行分段直到没有剩余
+    void Run() {
+        for (;;) {
+            int i = next.fetch_add(1);
+            if (i >= chunks) return;
+            int begin = i * chunk;
+            (*fn)(begin, std::min(count, begin + chunk));
+            if (done.fetch_add(1) + 1 == chunks) {
+                std::lock_guard<std::mutex> lock(mutex);
+                finished.notify_all();
+            }
+        }
+    }
+};
+
+class WorkerPool {
+public:
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_all();
+        for (auto& t : m_workers) t.join();
+    }
+
+    // 请 helpers 个工作线程协助执行 job；线程不足时先补齐
+    void Submit(const std::shared_ptr<ParallelJob>& job, int helpers) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            helpers = std::min(helpers, kMaxWorkers);
+            while ((int)m_workers.size() < helpers) m_workers.emplace_back([this] { WorkerLoop(); });
+            // 同一任务入队多份，每份由一个工作线程领取；调用线程已做完时多余的几份直接丢弃
+            for (int i = 0; i < helpers; i++) m_queue.push_back(job);
+        }
+        m_wake.notify_all();
+    }
+
+private:
+    void WorkerLoop() {
+        for (;;) {
+            std::shared_ptr<ParallelJob> job;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wake.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+                if (m_stop) return;
+                job = std::move(m_queue.front());
+                m_queue.pop_front();
+            }
+            job->Run();
+        }
+    }
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::deque<std::shared_ptr<ParallelJob>> m_queue;
+    std::vector<std::thread> m_workers;
+    bool m_stop = false;
+};
+
+static WorkerPool& SharedPool() {
+    static WorkerPool pool;
+    return pool;
+}
+
+void ParallelFor(int count, int threads, const std::function<void(int, int)>& fn, int minPerThread) {
+    if (count <= 0) return;
+    if (threads <= 1 || count < threads * minPerThread) {
+        fn(0, count);
+        return;
+    }
+
+    auto job = std::make_shared<ParallelJob>();
+    job->fn = &fn;
+    job->count = count;
+    job->chunk = (count + threads - 1) / threads;
+    job->chunks = (count + job->chunk - 1) / job->chunk;
+    SharedPool().Submit(job, job->chunks - 1);
+    job->Run();
+
+    // 调用线程领不到分段后，等待工作线程做完手上的分段
+    std::unique_lock<std::mutex> lock(job->mutex);
+    job->finished.wait(lock, [&job] { return job->done.load() == job->chunks; });
+}
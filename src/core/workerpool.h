@@ -0,0 +1,11 @@
+#pragma once
+
+#include <functional>
+
+// ============ 常驻工作线程池（与 Win32 无关，可在任意平台编译） ============
+// 并行阶段共用一组常驻线程，避免每次调用都创建、销毁线程：按住缩放快捷键时每帧要做两趟重采样，
+// 逐次建线程的开销与帧时间同一量级。线程在第一次需要时创建，按请求的并行度增长，进程退出时回收
+
+// 把 [0, count) 切成 threads 段并行执行 fn(begin, end)，调用线程也参与，全部完成后返回。
+// 任务太小（每段不足 minPerThread）或 threads <= 1 时直接在当前线程完成。可从多个线程同时调用
+void ParallelFor(int count, int threads, const std::function<void(int, int)>& fn, int minPerThread = 8);
@@ -4,6 +4,14 @@
 #include "settings.h"
 #include "hotkeys.h"
 #include "screenshot.h"
+#include "dirwatch.h"
+#include "imagecache.h"
+#include "tiledimage.h"
+#include "diskcache.h"
+#include "render.h"
+#include "monitor.h"
+#include "lastframe.h"
+#include "startuptrace.h"
 #include <thread>
 #include <filesystem>
 
@@ -16,12 +24,20 @@ std::atomic<float> scaleFactor(0.5f);
 std::atomic<float> opacityFactor(0.5f);
 std::atomic<bool> grayscaleEnabled(false);
 std::atomic<bool> removeWhiteBg(false);
-std::atomic<bool> reloadImage(false);
 std::atomic<bool> autoLoadLatest(true);
 std::atomic<int> rotationAngle(0);
-
-std::wstring currentImagePath;
-std::wstring imageDirectory;
+std::atomic<bool> mirrorHorizontal(false);
+std::atomic<bool> mirrorVertical(false);
+std::atomic<bool> fitWindowToImage(true);
+std::atomic<int> targetMonitor(0);
+std::atomic<int> refineDelayMs(150);
+std::atomic<int> prefetchCount(2);
+std::atomic<int> cacheMemoryMB(768);
+std::atomic<int> tileMemoryMB(256);
+std::atomic<int> diskCacheMB(1024);
+std::atomic<int> screenshotFormat(0);
+std::atomic<int> pngCompression(2);
+std::atomic<bool> showFrameStats(false);
 
 std::atomic<int> windowOffsetX(0);
 std::atomic<int> windowOffsetY(0);
@@ -53,7 +69,9 @@ void UnregisterScreenshotHotkey(HWND hwnd) {
 LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
     switch (uMsg) {
     case WM_PAINT:
-        DrawTransparentWindow(hwnd);
+        // 分层窗口由渲染线程通过 UpdateLayeredWindow 提交，这里只转交请求
+        ValidateRect(hwnd, nullptr);
+        RequestRender();
         return 0;
 
     case WM_TRAYICON:
@@ -77,12 +95,17 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
             break;
         case IDM_RELOAD:
             ReloadLatestImage();
-            reloadImage = true;
-            DrawTransparentWindow(hwnd);
+            RequestRender();
             break;
         case IDM_SETTINGS:
             CreateSettingsWindow();
             break;
+        case IDM_EXPORT_TRACE: {
+            std::wstring path, range;
+            if (ExportFrameTrace(&path, &range)) ShowTrayNotice(L"帧耗时记录已导出", range + L"\n" + path);
+            else ShowTrayNotice(L"帧耗时记录导出失败", L"图片目录不可写");
+            break;
+        }
         case IDM_EXIT:
             RemoveTrayIcon();
             running = false;
@@ -91,10 +114,20 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
         }
         return 0;
 
+    case WM_DISPLAYCHANGE:
+    case WM_DPICHANGED:
+        // 分辨率、显示器增减或缩放比例变化：渲染线程重新解析目标显示器并重建后备缓冲
+        RequestDisplayChange();
+        return 0;
+
     case WM_START_SCREENSHOT:
         StartScreenshot(hwnd);
         return 0;
 
+    case WM_HOTKEY_ACTION:
+        RunHotkeyAction((int)wParam);
+        return 0;
+
     case WM_HOTKEY:
         if (wParam == HOTKEY_ID_SCREENSHOT) {
             StartScreenshot(hwnd);
@@ -118,28 +151,22 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 // ============ 主函数 ============
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow) {
     g_hInstance = hInstance;
+    MarkStartupPhase(L"winmain");
 
     // 默认图片目录：用户图片文件夹\zGuess
-    if (imageDirectory.empty()) {
+    if (GetImageDirectory().empty()) {
         wchar_t picPath[MAX_PATH];
         SHGetFolderPathW(nullptr, CSIDL_MYPICTURES, nullptr, 0, picPath);
-        imageDirectory = std::wstring(picPath) + L"\\zGuess";
+        SetImageDirectory(std::wstring(picPath) + L"\\zGuess");
     }
     // 确保目录存在
-    std::filesystem::create_directories(imageDirectory);
+    std::filesystem::create_directories(GetImageDirectory());
 
     LoadConfig();
 
-    // LoadConfig 可能更新了 imageDirectory，再次确保目录存在
-    std::filesystem::create_directories(imageDirectory);
-
-    // 初始化通用控件（滑块等）
-    INITCOMMONCONTROLSEX icex = { sizeof(INITCOMMONCONTROLSEX), ICC_BAR_CLASSES };
-    InitCommonControlsEx(&icex);
-
-    GdiplusStartupInput gdiplusStartupInput;
-    ULONG_PTR gdiplusToken;
-    GdiplusStartup(&gdiplusToken, &gdiplusStartupInput, nullptr);
+    // LoadConfig 可能更新了图片目录，再次确保目录存在
+    std::filesystem::create_directories(GetImageDirectory());
+    MarkStartupPhase(L"config");
 
     const wchar_t CLASS_NAME[] = L"GuessDraw_Main";
     WNDCLASSW wc = {};
@@ -149,42 +176,81 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow) {
     wc.hIcon = LoadIcon(hInstance, MAKEINTRESOURCE(IDI_APPICON));
     RegisterClassW(&wc);
 
-    int screenWidth = GetSystemMetrics(SM_CXSCREEN);
-    int screenHeight = GetSystemMetrics(SM_CYSCREEN);
-
     // 创建分层窗口：置顶 + 透明 + 鼠标穿透
-    g_hwndMain = CreateWindowExW(
-        WS_EX_LAYERED | WS_EX_TOPMOST | WS_EX_TRANSPARENT,
-        CLASS_NAME,
-        L"GuessDraw",
-        WS_POPUP,
-        0, 0, screenWidth, screenHeight,
-        nullptr, nullptr, hInstance, nullptr
-    );
+    // 窗口按每显示器 DPI 感知创建，系统不再对其做位图拉伸；初始覆盖目标显示器，之后由渲染线程定位
+    // 窗口一创建就提交上次退出时的画面，GDI+、解码和渲染都在画面出现之后进行
+    MonitorTarget monitor;
+    ResolveTargetMonitor(&monitor);
+    std::shared_ptr<LastFrame> lastFrame = LoadLastFrame(GetCurrentImagePath());
+    {
+        ScopedPerMonitorDpi dpiScope;
+        g_hwndMain = CreateWindowExW(
+            WS_EX_LAYERED | WS_EX_TOPMOST | WS_EX_TRANSPARENT,
+            CLASS_NAME,
+            L"GuessDraw",
+            WS_POPUP,
+            monitor.rect.left, monitor.rect.top,
+            monitor.rect.right - monitor.rect.left, monitor.rect.bottom - monitor.rect.top,
+            nullptr, nullptr, hInstance, nullptr
+        );
+        MarkStartupPhase(L"window");
+        if (lastFrame && PresentLastFrame(g_hwndMain, *lastFrame, monitor.rect)) {
+            MarkStartupPhase(L"frame-restored");
+        } else {
+            lastFrame.reset();
+        }
+    }
+    ShowWindow(g_hwndMain, nCmdShow);
+
+    // 初始化通用控件（滑块等）
+    INITCOMMONCONTROLSEX icex = { sizeof(INITCOMMONCONTROLSEX), ICC_BAR_CLASSES };
+    InitCommonControlsEx(&icex);
+
+    GdiplusStartupInput gdiplusStartupInput;
+    ULONG_PTR gdiplusToken;
+    GdiplusStartup(&gdiplusToken, &gdiplusStartupInput, nullptr);
+    MarkStartupPhase(L"gdiplus");
 
     CreateTrayIcon(g_hwndMain);
     RegisterScreenshotHotkey(g_hwndMain);
-    ShowWindow(g_hwndMain, nCmdShow);
-    DrawTransparentWindow(g_hwndMain);
+    SetRestoredFrame(std::move(lastFrame));
+    StartRenderThread(g_hwndMain);
 
     std::thread keyListenerThread(KeyListener, g_hwndMain);
 
-    // 消息循环，处理设置窗口的 Tab 切换和重绘请求
+    // 消息循环，处理设置窗口的 Tab 切换（绘制全部在渲染线程中进行）
     MSG msg = {};
     while (GetMessage(&msg, nullptr, 0, 0)) {
         if (g_hwndSettings && IsDialogMessage(g_hwndSettings, &msg)) continue;
 
         TranslateMessage(&msg);
         DispatchMessage(&msg);
-
-        if (reloadImage) {
-            reloadImage = false;
-            DrawTransparentWindow(g_hwndMain);
-        }
     }
+    FlushConfig();
 
-    running = false;
+    StopKeyListener();
     keyListenerThread.join();
+    StopRenderThread();
+    FinishStartupTrace(); // 一帧都没提交过（如目录为空）时在这里写出
+
+    // 保存最后的画面供下次启动直接显示；没有可复用的画面时删除旧文件
+    LastFrame frame;
+    bool captured = CaptureLastFrame(&frame);
+    SaveLastFrame(captured ? &frame : nullptr);
+
+    // 输出帧统计，便于用调试器/DebugView 观察请求合并效果
+    RenderCounters counters = GetRenderCounters();
+    wchar_t stats[192];
+    swprintf(stats, 192, L"GuessDraw frames: requested=%llu processed=%llu skipped=%llu rendered=%llu presented=%llu\n",
+             (unsigned long long)counters.requested, (unsigned long long)counters.frames,
+             (unsigned long long)counters.skipped, (unsigned long long)counters.rendered,
+             (unsigned long long)counters.presented);
+    OutputDebugStringW(stats);
+    StopScreenshotSaver();
+    StopTileLoader();
+    StopImageCache();
+    StopDiskCache();
+    StopDirectoryWatcher();
 
     RemoveTrayIcon();
     GdiplusShutdown(gdiplusToken);
@@ -1,153 +1,271 @@
 #include "hotkeys.h"
 #include "globals.h"
 #include "drawing.h"
+#include "render.h"
+#include "monitor.h"
 
 using namespace std;
 
-// 检查快捷键是否被按下（主键 + 修饰键全部满足）
-static bool IsHotkeyPressed(const HotkeyBinding& hk) {
-    if (!(GetAsyncKeyState(hk.vkey) & 0x8000)) return false;
-    if (hk.ctrl  && !(GetAsyncKeyState(VK_CONTROL) & 0x8000)) return false;
-    if (hk.shift && !(GetAsyncKeyState(VK_SHIFT) & 0x8000))   return false;
-    if (hk.alt   && !(GetAsyncKeyState(VK_MENU) & 0x8000))    return false;
+// ============ 事件驱动的快捷键监听 ============
+// 监听线程安装 WH_KEYBOARD_LL / WH_MOUSE_LL 钩子后阻塞在消息循环里：空闲时不唤醒，
+// 按键在事件到达时立即处理，不再依赖 Sleep 轮询和去抖。
+// 钩子线程只做边沿检测和自动重复，动作投递给主窗口执行：切换图片可能要重扫目录或等待渲染线程，
+// 在钩子线程里阻塞会卡住整个桌面的输入，超过 LowLevelHooksTimeout 后钩子还会被系统静默移除
+
+// 连续调节类动作（透明度/缩放）按住时的自动重复
+static const ULONGLONG kRepeatDelayMs = 250;
+static const UINT kRepeatIntervalMs = 100;
+
+static HWND s_hwnd = nullptr;
+static std::atomic<DWORD> s_listenerThreadId(0);
+
+static bool s_keyDown[256] = {};                // 钩子维护的按键状态（含鼠标键）
+static bool s_actionDown[HK_COUNT] = {};        // 各动作上一次的按下状态，用于边沿检测
+static ULONGLONG s_actionPressTick[HK_COUNT] = {};
+static UINT_PTR s_repeatTimer = 0;
+
+static bool s_dragging = false;
+static POINT s_dragLast = { 0, 0 };
+static HMONITOR s_cursorMonitor = nullptr; // 跟随鼠标模式下鼠标所在的显示器
+
+static bool IsRepeatAction(int action) {
+    return action == HK_OPACITY_UP || action == HK_OPACITY_DOWN ||
+           action == HK_SCALE_UP   || action == HK_SCALE_DOWN;
+}
+
+// 检查快捷键是否按下（主键 + 修饰键全部满足）
+static bool IsBindingDown(const HotkeyBinding& hk) {
+    if (hk.vkey <= 0 || hk.vkey > 255 || !s_keyDown[hk.vkey]) return false;
+    if (hk.ctrl  && !s_keyDown[VK_CONTROL]) return false;
+    if (hk.shift && !s_keyDown[VK_SHIFT])   return false;
+    if (hk.alt   && !s_keyDown[VK_MENU])    return false;
     return true;
 }
 
-// 快捷键监听线程，轮询检测按键并触发对应动作
-void KeyListener(HWND hwnd) {
-    while (running) {
-        // 退出
-        if (IsHotkeyPressed(g_hotkeys[HK_EXIT])) {
-            PostMessage(hwnd, WM_CLOSE, 0, 0);
-            break;
+// 执行动作（在主窗口线程中调用）
+void RunHotkeyAction(int action) {
+    HWND hwnd = g_hwndMain;
+    switch (action) {
+    case HK_EXIT:
+        PostMessage(hwnd, WM_CLOSE, 0, 0);
+        break;
+    case HK_TOGGLE_VISIBLE:
+        if (isWindowVisible) {
+            ShowWindow(hwnd, SW_HIDE);
+            isWindowVisible = false;
+        } else {
+            ShowWindow(hwnd, SW_SHOW);
+            isWindowVisible = true;
         }
+        break;
+    case HK_RELOAD:
+        // 重新加载（强制加载目录中最新图片）
+        ReloadLatestImage();
+        RequestRender();
+        break;
+    case HK_OPACITY_UP:
+        opacityFactor = min(1.0f, opacityFactor.load() + 0.05f);
+        MarkInteraction();
+        RequestRender();
+        break;
+    case HK_OPACITY_DOWN:
+        opacityFactor = max(0.05f, opacityFactor.load() - 0.05f);
+        MarkInteraction();
+        RequestRender();
+        break;
+    case HK_SCALE_UP:
+        scaleFactor = scaleFactor + 0.05f;
+        MarkInteraction();
+        RequestRender();
+        break;
+    case HK_SCALE_DOWN:
+        scaleFactor = max(0.1f, scaleFactor.load() - 0.05f);
+        MarkInteraction();
+        RequestRender();
+        break;
+    case HK_PREV_IMAGE:
+    case HK_NEXT_IMAGE:
+        SwitchImage(action == HK_PREV_IMAGE ? -1 : 1);
+        RequestRender();
+        break;
+    case HK_ROTATE_CW:
+        rotationAngle = (rotationAngle.load() + 10) % 360;
+        RequestRender();
+        break;
+    case HK_ROTATE_CCW:
+        rotationAngle = (rotationAngle.load() + 350) % 360;
+        RequestRender();
+        break;
+    case HK_MIRROR_H:
+        mirrorHorizontal = !mirrorHorizontal.load();
+        RequestRender();
+        break;
+    case HK_MIRROR_V:
+        mirrorVertical = !mirrorVertical.load();
+        RequestRender();
+        break;
+    case HK_TOGGLE_STATS:
+        showFrameStats = !showFrameStats.load();
+        RequestRender();
+        break;
+    }
+}
 
-        // 显示/隐藏
-        if (IsHotkeyPressed(g_hotkeys[HK_TOGGLE_VISIBLE])) {
-            if (isWindowVisible) {
-                ShowWindow(hwnd, SW_HIDE);
-                isWindowVisible = false;
-            } else {
-                ShowWindow(hwnd, SW_SHOW);
-                isWindowVisible = true;
+// 按键状态变化后逐个动作做边沿检测：仅在从未按下变为按下时触发一次
+// 连续调节类动作另外登记按下时间，由重复定时器处理按住不放
+static void UpdateActions() {
+    for (int i = 0; i < HK_COUNT; i++) {
+        if (i == HK_DRAG_MODIFIER || i == HK_SCREENSHOT) continue; // 拖动单独处理，截图走 RegisterHotKey
+        bool down = IsBindingDown(g_hotkeys[i]);
+        if (down && !s_actionDown[i]) {
+            s_actionDown[i] = true;
+            PostMessageW(s_hwnd, WM_HOTKEY_ACTION, i, 0);
+            if (IsRepeatAction(i)) {
+                s_actionPressTick[i] = GetTickCount64();
+                if (!s_repeatTimer) s_repeatTimer = SetTimer(nullptr, 0, kRepeatIntervalMs, nullptr);
             }
-            Sleep(200);
+        } else if (!down && s_actionDown[i]) {
+            s_actionDown[i] = false;
         }
+    }
+}
 
-        // 重新加载（强制加载目录中最新图片）
-        if (IsHotkeyPressed(g_hotkeys[HK_RELOAD])) {
-            ReloadLatestImage();
-            reloadImage = true;
-            PostMessage(hwnd, WM_USER, 0, 0);
-            Sleep(200);
-        }
+// 按住超过 kRepeatDelayMs 后每个间隔重复一次；全部松开后停止定时器，空闲时不再唤醒
+static void OnRepeatTimer() {
+    ULONGLONG now = GetTickCount64();
+    bool anyHeld = false;
+    for (int i = 0; i < HK_COUNT; i++) {
+        if (!IsRepeatAction(i) || !s_actionDown[i]) continue;
 
-        // 提高透明度
-        if (IsHotkeyPressed(g_hotkeys[HK_OPACITY_UP])) {
-            float cur = opacityFactor.load();
-            opacityFactor = min(1.0f, cur + 0.05f);
-            InvalidateRect(hwnd, nullptr, TRUE);
-            Sleep(100);
+        // 钩子超时或安全桌面可能吞掉抬起事件，按住期间顺带校正一次真实按键状态
+        int vkey = g_hotkeys[i].vkey;
+        if (vkey > 0 && vkey <= 255 && !(GetAsyncKeyState(vkey) & 0x8000)) {
+            s_keyDown[vkey] = false;
+            s_actionDown[i] = false;
+            continue;
         }
+        anyHeld = true;
+        if (now - s_actionPressTick[i] >= kRepeatDelayMs) PostMessageW(s_hwnd, WM_HOTKEY_ACTION, i, 0);
+    }
+    if (!anyHeld) {
+        KillTimer(nullptr, s_repeatTimer);
+        s_repeatTimer = 0;
+    }
+}
 
-        // 降低透明度
-        if (IsHotkeyPressed(g_hotkeys[HK_OPACITY_DOWN])) {
-            float cur = opacityFactor.load();
-            opacityFactor = max(0.05f, cur - 0.05f);
-            InvalidateRect(hwnd, nullptr, TRUE);
-            Sleep(100);
-        }
+// 拖动：修饰键(vkey==0表示无修饰键) + 鼠标键
+static bool IsDragChordDown() {
+    int modVkey = g_hotkeys[HK_DRAG_MODIFIER].vkey;
+    int button = g_dragMouseButton.load();
+    bool modDown = modVkey == 0 || (modVkey > 0 && modVkey <= 255 && s_keyDown[modVkey]);
+    return modDown && button > 0 && button <= 255 && s_keyDown[button];
+}
 
-        // 放大图片
-        if (IsHotkeyPressed(g_hotkeys[HK_SCALE_UP])) {
-            scaleFactor = scaleFactor + 0.05f;
-            InvalidateRect(hwnd, nullptr, TRUE);
-            Sleep(100);
-        }
+static void SetKeyState(DWORD vkey, bool down) {
+    if (vkey > 255) return;
+    s_keyDown[vkey] = down;
+    // 低级钩子只报告左右区分的修饰键，同步维护通用 VK 码供快捷键匹配
+    s_keyDown[VK_CONTROL] = s_keyDown[VK_LCONTROL] || s_keyDown[VK_RCONTROL];
+    s_keyDown[VK_SHIFT]   = s_keyDown[VK_LSHIFT]   || s_keyDown[VK_RSHIFT];
+    s_keyDown[VK_MENU]    = s_keyDown[VK_LMENU]    || s_keyDown[VK_RMENU];
+}
 
-        // 缩小图片
-        if (IsHotkeyPressed(g_hotkeys[HK_SCALE_DOWN])) {
-            float cur = scaleFactor.load();
-            scaleFactor = max(0.1f, cur - 0.05f);
-            InvalidateRect(hwnd, nullptr, TRUE);
-            Sleep(100);
+static LRESULT CALLBACK KeyboardHookProc(int nCode, WPARAM wParam, LPARAM lParam) {
+    if (nCode == HC_ACTION) {
+        const KBDLLHOOKSTRUCT* kb = (const KBDLLHOOKSTRUCT*)lParam;
+        bool down = !(kb->flags & LLKHF_UP);
+        // 系统自动重复的 KEYDOWN 不改变状态，边沿检测自然忽略
+        if (kb->vkCode < 256 && s_keyDown[kb->vkCode] != down) {
+            SetKeyState(kb->vkCode, down);
+            UpdateActions();
+            if (!IsDragChordDown()) s_dragging = false;
         }
+    }
+    return CallNextHookEx(nullptr, nCode, wParam, lParam);
+}
 
-        // 上一张图片（边沿检测：仅在按键从未按下变为按下时触发）
-        {
-            static bool prevDown = false;
-            bool nowDown = IsHotkeyPressed(g_hotkeys[HK_PREV_IMAGE]);
-            if (nowDown && !prevDown) {
-                SwitchImage(-1);
-                reloadImage = true;
-                PostMessage(hwnd, WM_USER, 0, 0);
-            }
-            prevDown = nowDown;
+static LRESULT CALLBACK MouseHookProc(int nCode, WPARAM wParam, LPARAM lParam) {
+    if (nCode == HC_ACTION) {
+        const MSLLHOOKSTRUCT* ms = (const MSLLHOOKSTRUCT*)lParam;
+        DWORD button = 0;
+        bool down = false;
+        switch (wParam) {
+        case WM_LBUTTONDOWN: button = VK_LBUTTON; down = true; break;
+        case WM_LBUTTONUP:   button = VK_LBUTTON; break;
+        case WM_RBUTTONDOWN: button = VK_RBUTTON; down = true; break;
+        case WM_RBUTTONUP:   button = VK_RBUTTON; break;
+        case WM_MBUTTONDOWN: button = VK_MBUTTON; down = true; break;
+        case WM_MBUTTONUP:   button = VK_MBUTTON; break;
+        case WM_XBUTTONDOWN:
+        case WM_XBUTTONUP:
+            button = (HIWORD(ms->mouseData) == XBUTTON1) ? VK_XBUTTON1 : VK_XBUTTON2;
+            down = wParam == WM_XBUTTONDOWN;
+            break;
         }
-
-        // 下一张图片（边沿检测）
-        {
-            static bool nextDown = false;
-            bool nowDown = IsHotkeyPressed(g_hotkeys[HK_NEXT_IMAGE]);
-            if (nowDown && !nextDown) {
-                SwitchImage(1);
-                reloadImage = true;
-                PostMessage(hwnd, WM_USER, 0, 0);
-            }
-            nextDown = nowDown;
+        if (button) {
+            SetKeyState(button, down);
+            UpdateActions();
         }
 
-        // 顺时针旋转（边沿检测）
-        {
-            static bool cwDown = false;
-            bool nowDown = IsHotkeyPressed(g_hotkeys[HK_ROTATE_CW]);
-            if (nowDown && !cwDown) {
-                rotationAngle = (rotationAngle.load() + 10) % 360;
-                InvalidateRect(hwnd, nullptr, TRUE);
+        // 跟随鼠标模式：鼠标移到另一个显示器时叠加层跟过去
+        if (wParam == WM_MOUSEMOVE && targetMonitor.load() < 0) {
+            HMONITOR monitor = MonitorFromPoint(ms->pt, MONITOR_DEFAULTTONEAREST);
+            if (monitor != s_cursorMonitor) {
+                s_cursorMonitor = monitor;
+                RequestRender();
             }
-            cwDown = nowDown;
         }
 
-        // 逆时针旋转（边沿检测）
-        {
-            static bool ccwDown = false;
-            bool nowDown = IsHotkeyPressed(g_hotkeys[HK_ROTATE_CCW]);
-            if (nowDown && !ccwDown) {
-                rotationAngle = (rotationAngle.load() + 350) % 360;
-                InvalidateRect(hwnd, nullptr, TRUE);
+        if (!IsDragChordDown()) {
+            s_dragging = false;
+        } else if (!s_dragging) {
+            s_dragLast = ms->pt;
+            s_dragging = true;
+        } else if (wParam == WM_MOUSEMOVE) {
+            int dx = ms->pt.x - s_dragLast.x;
+            int dy = ms->pt.y - s_dragLast.y;
+            s_dragLast = ms->pt;
+            if (dx != 0 || dy != 0) {
+                windowOffsetX += dx;
+                windowOffsetY += dy;
+                MarkInteraction();
+                RequestRender();
             }
-            ccwDown = nowDown;
         }
+    }
+    return CallNextHookEx(nullptr, nCode, wParam, lParam);
+}
 
-        // 拖动：修饰键(vkey==0表示无修饰键) + 鼠标键
-        {
-            static POINT lastPos = {0, 0};
-            static bool dragging = false;
-
-            int modVkey = g_hotkeys[HK_DRAG_MODIFIER].vkey;
-            bool modDown = (modVkey == 0) || (GetAsyncKeyState(modVkey) & 0x8000) != 0;
-            bool mbtnDown = (GetAsyncKeyState(g_dragMouseButton.load()) & 0x8000) != 0;
-
-            if (modDown && mbtnDown) {
-                POINT curPos;
-                GetCursorPos(&curPos);
-
-                if (!dragging) {
-                    lastPos = curPos;
-                    dragging = true;
-                } else {
-                    int dx = curPos.x - lastPos.x;
-                    int dy = curPos.y - lastPos.y;
-                    windowOffsetX += dx;
-                    windowOffsetY += dy;
-                    lastPos = curPos;
-                    InvalidateRect(hwnd, nullptr, TRUE);
-                }
-            } else {
-                dragging = false;
-            }
-        }
+// 快捷键监听线程：安装低级钩子并运行消息循环，直到 StopKeyListener 投递 WM_QUIT
+void KeyListener(HWND hwnd) {
+    s_hwnd = hwnd;
+    ScopedPerMonitorDpi dpiScope; // 钩子报告的是物理像素坐标，拖动偏移与叠加层保持一致
+
+    // 先建立线程消息队列，再公开线程 ID，保证 StopKeyListener 投递的 WM_QUIT 不会丢失
+    MSG msg;
+    PeekMessageW(&msg, nullptr, 0, 0, PM_NOREMOVE);
+    s_listenerThreadId = GetCurrentThreadId();
+    if (!running) return;
 
-        Sleep(10);
+    HMODULE module = GetModuleHandleW(nullptr);
+    HHOOK keyboardHook = SetWindowsHookExW(WH_KEYBOARD_LL, KeyboardHookProc, module, 0);
+    HHOOK mouseHook = SetWindowsHookExW(WH_MOUSE_LL, MouseHookProc, module, 0);
+
+    while (GetMessageW(&msg, nullptr, 0, 0) > 0) {
+        if (msg.hwnd) {
+            DispatchMessageW(&msg);
+        } else if (msg.message == WM_TIMER && msg.wParam == s_repeatTimer) {
+            OnRepeatTimer();
+        }
     }
+
+    if (s_repeatTimer) KillTimer(nullptr, s_repeatTimer);
+    if (mouseHook) UnhookWindowsHookEx(mouseHook);
+    if (keyboardHook) UnhookWindowsHookEx(keyboardHook);
+}
+
+void StopKeyListener() {
+    running = false;
+    DWORD tid = s_listenerThreadId.load();
+    if (tid) PostThreadMessageW(tid, WM_QUIT, 0, 0);
 }
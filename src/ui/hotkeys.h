@@ -2,4 +2,6 @@
 
 #include <windows.h>
 
-void KeyListener(HWND hwnd); // 快捷键监听线程入口
+void KeyListener(HWND hwnd); // 快捷键监听线程入口（低级键盘/鼠标钩子 + 消息循环）
+void StopKeyListener();      // 通知监听线程退出，之后 join 即可
+void RunHotkeyAction(int action); // 执行快捷键动作（主窗口收到 WM_HOTKEY_ACTION 时调用）
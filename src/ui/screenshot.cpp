@@ -1,13 +1,26 @@
 #include "screenshot.h"
 #include "globals.h"
 #include "drawing.h"
+#include "render.h"
+#include "monitor.h"
+#include "imagecache.h"
+#include "qoi.h"
+#include <windowsx.h>
 #include <gdiplus.h>
+#include <wincodec.h>
+#include <wrl/client.h>
 #include <string>
 #include <ctime>
 #include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
 #include <shlobj.h>
 
 using namespace Gdiplus;
+using Microsoft::WRL::ComPtr;
 
 static const wchar_t* SCREENSHOT_CLASS = L"GuessDraw_Screenshot";
 static bool s_classRegistered = false;
@@ -16,7 +29,7 @@ static HCURSOR s_hCrossCursor = nullptr;
 // 截图状态
 static HWND s_hwndMain = nullptr;       // 主窗口句柄
 static HWND s_hwndScreenshot = nullptr; // 截图窗口句柄
-static HBITMAP s_hDesktop = nullptr;     // 桌面截图
+static int s_screenX = 0, s_screenY = 0; // 目标显示器左上角（虚拟桌面坐标）
 static int s_screenW = 0, s_screenH = 0;
 static const UINT_PTR TIMER_CAPTURE = 1;
 
@@ -30,34 +43,88 @@ static RECT s_selRect = {0, 0, 0, 0};  // 选区矩形
 static RECT s_btnConfirm = {0, 0, 0, 0};
 static RECT s_btnCancel = {0, 0, 0, 0};
 
-// 获取 PNG 编码器 CLSID
-static int GetEncoderClsid(const WCHAR* format, CLSID* pClsid) {
-    UINT num = 0, size = 0;
-    GetImageEncodersSize(&num, &size);
-    if (size == 0) return -1;
-
-    ImageCodecInfo* pInfo = (ImageCodecInfo*)malloc(size);
-    if (!pInfo) return -1;
-    GetImageEncoders(num, size, pInfo);
-
-    for (UINT i = 0; i < num; i++) {
-        if (wcscmp(pInfo[i].MimeType, format) == 0) {
-            *pClsid = pInfo[i].Clsid;
-            free(pInfo);
-            return i;
-        }
+// ============ 覆盖层缓冲 ============
+// 截图期间常驻的三张显示器尺寸 DIB：冻结的桌面、预先压暗的桌面、合成用的后备缓冲。
+// 重绘只处理更新区域：选区外拷贝压暗版本，选区内拷贝原图，再在其上画边框、尺寸标签和按钮
+struct ScreenDib {
+    HDC dc = nullptr;
+    HBITMAP bitmap = nullptr;
+    HGDIOBJ oldBitmap = nullptr;
+    uint32_t* bits = nullptr;
+    int width = 0;
+    int height = 0;
+};
+static ScreenDib s_desktop;              // 目标显示器截图
+static ScreenDib s_dimmed;               // 选区外的样子（与原先叠加 alpha 120 的黑色遮罩一致）
+static ScreenDib s_back;                 // 后备缓冲
+
+static bool CreateScreenDib(ScreenDib& dib, int width, int height) {
+    BITMAPINFO bi = {};
+    bi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    bi.bmiHeader.biWidth = width;
+    bi.bmiHeader.biHeight = -height; // 自上而下
+    bi.bmiHeader.biPlanes = 1;
+    bi.bmiHeader.biBitCount = 32;
+    bi.bmiHeader.biCompression = BI_RGB;
+    void* bits = nullptr;
+    HBITMAP bitmap = CreateDIBSection(nullptr, &bi, DIB_RGB_COLORS, &bits, nullptr, 0);
+    if (!bitmap || !bits) {
+        if (bitmap) DeleteObject(bitmap);
+        return false;
+    }
+    dib.dc = CreateCompatibleDC(nullptr);
+    dib.bitmap = bitmap;
+    dib.oldBitmap = SelectObject(dib.dc, bitmap);
+    dib.bits = (uint32_t*)bits;
+    dib.width = width;
+    dib.height = height;
+    return true;
+}
+
+static void ReleaseScreenDib(ScreenDib& dib) {
+    if (dib.dc) {
+        SelectObject(dib.dc, dib.oldBitmap);
+        DeleteDC(dib.dc);
     }
-    free(pInfo);
-    return -1;
+    if (dib.bitmap) DeleteObject(dib.bitmap);
+    dib = ScreenDib();
 }
 
-// 规范化选区矩形（确保 left < right, top < bottom）
+// 截图期间复用的 GDI+ 绘制对象，绑定到后备缓冲
+struct OverlayResources {
+    Graphics graphics;
+    Pen borderPen{ Color(255, 0, 120, 215), 2.0f };
+    Font labelFont{ L"Segoe UI", 11.0f };
+    Font hintFont{ L"Segoe UI", 14.0f };
+    Font buttonFont{ L"Segoe UI", 10.0f };
+    SolidBrush labelBg{ Color(180, 0, 0, 0) };
+    SolidBrush white{ Color(255, 255, 255, 255) };
+    SolidBrush hintBrush{ Color(200, 255, 255, 255) };
+    SolidBrush confirmBg{ Color(220, 0, 120, 215) };
+    SolidBrush cancelBg{ Color(220, 80, 80, 80) };
+    StringFormat centered;
+
+    explicit OverlayResources(HDC dc) : graphics(dc) {
+        centered.SetAlignment(StringAlignmentCenter);
+        centered.SetLineAlignment(StringAlignmentCenter);
+    }
+};
+static std::unique_ptr<OverlayResources> s_overlay;
+
+// 尺寸标签（随选区变化）
+static wchar_t s_labelText[64] = L"";
+static RectF s_labelRect;                // 标签背景
+
+// 规范化选区矩形（确保 left < right, top < bottom），并限制在本显示器内：
+// 拖动时鼠标被捕获，松开在相邻显示器上时坐标会超出桌面截图的范围
 static RECT NormalizeRect(POINT start, POINT end) {
     RECT r;
     r.left   = std::min(start.x, end.x);
     r.top    = std::min(start.y, end.y);
     r.right  = std::max(start.x, end.x);
     r.bottom = std::max(start.y, end.y);
+    RECT screen = { 0, 0, s_screenW, s_screenH };
+    IntersectRect(&r, &r, &screen);  // 不相交时 r 置为空
     return r;
 }
 
@@ -76,150 +143,268 @@ static void UpdateButtonRects() {
     s_btnCancel  = { cx + gap / 2, by, cx + gap / 2 + btnW, by + btnH };
 }
 
-// 保存选区为 PNG 文件
-static bool SaveSelection(HWND hwnd) {
-    int w = s_selRect.right - s_selRect.left;
-    int h = s_selRect.bottom - s_selRect.top;
-    if (w <= 0 || h <= 0) return false;
-
-    // 从桌面截图中裁剪选区
-    HDC hdcScreen = GetDC(nullptr);
-    HDC hdcSrc = CreateCompatibleDC(hdcScreen);
-    HDC hdcDst = CreateCompatibleDC(hdcScreen);
-    HBITMAP hCrop = CreateCompatibleBitmap(hdcScreen, w, h);
-
-    SelectObject(hdcSrc, s_hDesktop);
-    SelectObject(hdcDst, hCrop);
-    BitBlt(hdcDst, 0, 0, w, h, hdcSrc, s_selRect.left, s_selRect.top, SRCCOPY);
-
-    // 用 GDI+ 保存为 PNG
-    Bitmap bmp(hCrop, nullptr);
-    CLSID pngClsid;
-    bool ok = false;
-    if (GetEncoderClsid(L"image/png", &pngClsid) >= 0) {
-        // 生成文件名：screenshot_YYYYMMDD_HHMMSS.png
-        time_t now = time(nullptr);
-        struct tm* t = localtime(&now);
-        wchar_t filename[MAX_PATH];
-        swprintf(filename, MAX_PATH, L"%ls\\screenshot_%04d%02d%02d_%02d%02d%02d.png",
-                 imageDirectory.c_str(),
-                 t->tm_year + 1900, t->tm_mon + 1, t->tm_mday,
-                 t->tm_hour, t->tm_min, t->tm_sec);
-
-        ok = (bmp.Save(filename, &pngClsid, nullptr) == Ok);
+// 后台编码写盘，同一时间最多一个；先写临时文件再改名，目录监视不会看到写了一半的图片
+static std::thread s_saveThread;
+
+// PNG 经 WIC 编码。WIC 与 GDI+ 都不开放 zlib 压缩级别，能调节速度与体积的只有行过滤方式
+static bool WritePngFile(const DecodedImage& image, const std::wstring& path) {
+    static const WICPngFilterOption filters[] = { WICPngFilterNone, WICPngFilterSub, WICPngFilterAdaptive };
+    WICPngFilterOption filter = filters[std::clamp(pngCompression.load(), 0, 2)];
+
+    ComPtr<IWICImagingFactory> factory;
+    ComPtr<IWICStream> stream;
+    ComPtr<IWICBitmapEncoder> encoder;
+    ComPtr<IWICBitmapFrameEncode> frame;
+    ComPtr<IPropertyBag2> options;
+    ComPtr<IWICBitmap> source;
+    if (FAILED(CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&factory))) ||
+        FAILED(factory->CreateStream(&stream)) ||
+        FAILED(stream->InitializeFromFilename(path.c_str(), GENERIC_WRITE)) ||
+        FAILED(factory->CreateEncoder(GUID_ContainerFormatPng, nullptr, &encoder)) ||
+        FAILED(encoder->Initialize(stream.Get(), WICBitmapEncoderNoCache)) ||
+        FAILED(encoder->CreateNewFrame(&frame, &options))) {
+        return false;
     }
 
-    DeleteDC(hdcDst);
-    DeleteDC(hdcSrc);
-    ReleaseDC(nullptr, hdcScreen);
-    DeleteObject(hCrop);
+    PROPBAG2 option = {};
+    option.pstrName = (LPOLESTR)L"FilterOption";
+    VARIANT value;
+    VariantInit(&value);
+    value.vt = VT_UI1;
+    value.bVal = (BYTE)filter;
+    options->Write(1, &option, &value);
+
+    // 缓存中的像素按 32bppBGR 解释（alpha 恒为 255），由 WIC 转为不带 alpha 通道的 24 位 PNG
+    UINT stride = (UINT)image.width * 4;
+    return SUCCEEDED(frame->Initialize(options.Get())) &&
+           SUCCEEDED(frame->SetSize((UINT)image.width, (UINT)image.height)) &&
+           SUCCEEDED(factory->CreateBitmapFromMemory((UINT)image.width, (UINT)image.height, GUID_WICPixelFormat32bppBGR,
+                                                     stride, stride * (UINT)image.height,
+                                                     (BYTE*)image.pixels.data(), &source)) &&
+           SUCCEEDED(frame->WriteSource(source.Get(), nullptr)) &&
+           SUCCEEDED(frame->Commit()) && SUCCEEDED(encoder->Commit());
+}
+
+static bool WriteQoiFile(const DecodedImage& image, const std::wstring& path) {
+    std::vector<uint8_t> data = EncodeQoi(image.pixels.data(), image.width, image.height, 3);
+    if (data.empty()) return false;
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    DWORD written = 0;
+    bool ok = WriteFile(file, data.data(), (DWORD)data.size(), &written, nullptr) && written == data.size();
+    CloseHandle(file);
     return ok;
 }
 
-// 绘制覆盖窗口
+static void WriteScreenshotFile(std::shared_ptr<const DecodedImage> image, std::wstring path, bool qoi) {
+    CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+    std::wstring temp = path + L".tmp";
+    bool ok = (qoi ? WriteQoiFile(*image, temp) : WritePngFile(*image, temp)) &&
+              MoveFileExW(temp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING);
+    if (!ok) DeleteFileW(temp.c_str());
+    FinishCapturedImage(path, ok);
+    CoUninitialize();
+}
+
+// 保存选区为 PNG/QOI 文件：裁剪出的像素立即放入解码缓存供主窗口显示，编码和写盘交给后台线程
+static bool SaveSelection(HWND hwnd, std::wstring* savedPath) {
+    // 直接读 DIB 内存，没有 GDI 的裁剪兜底，越界的选区必须先截到截图范围内
+    RECT sel;
+    RECT bounds = { 0, 0, s_desktop.width, s_desktop.height };
+    if (!s_desktop.bits || !IntersectRect(&sel, &s_selRect, &bounds)) return false;
+    int w = sel.right - sel.left;
+    int h = sel.bottom - sel.top;
+
+    // 直接从桌面截图的 DIB 中裁剪选区；屏幕 DC 复制出的 alpha 不确定，统一置为不透明
+    std::vector<uint32_t> pixels((size_t)w * h);
+    for (int y = 0; y < h; y++) {
+        const uint32_t* src = s_desktop.bits + (size_t)(sel.top + y) * s_desktop.width + sel.left;
+        uint32_t* dst = pixels.data() + (size_t)y * w;
+        for (int x = 0; x < w; x++) dst[x] = src[x] | 0xFF000000;
+    }
+
+    // 生成文件名：screenshot_YYYYMMDD_HHMMSS.png（或 .qoi）
+    bool qoi = screenshotFormat == 1;
+    time_t now = time(nullptr);
+    struct tm* t = localtime(&now);
+    wchar_t filename[MAX_PATH];
+    swprintf(filename, MAX_PATH, L"%ls\\screenshot_%04d%02d%02d_%02d%02d%02d.%ls",
+             GetImageDirectory().c_str(),
+             t->tm_year + 1900, t->tm_mon + 1, t->tm_mday,
+             t->tm_hour, t->tm_min, t->tm_sec, qoi ? L"qoi" : L"png");
+
+    // 上一张仍在写入时先等它完成（极少发生），同名文件不会被两个线程同时写
+    if (s_saveThread.joinable()) s_saveThread.join();
+    std::shared_ptr<const DecodedImage> image = InsertCapturedImage(filename, std::move(pixels), w, h);
+    s_saveThread = std::thread(WriteScreenshotFile, image, std::wstring(filename), qoi);
+    *savedPath = filename;
+    return true;
+}
+
+void StopScreenshotSaver() {
+    if (s_saveThread.joinable()) s_saveThread.join();
+}
+
+// 选区外的像素：叠加 alpha 120 的黑色，即各通道乘以 135/255
+static void BuildDimmedDesktop() {
+    uint8_t table[256];
+    for (int v = 0; v < 256; v++) table[v] = (uint8_t)((v * 135 + 127) / 255);
+    size_t count = (size_t)s_desktop.width * s_desktop.height;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t p = s_desktop.bits[i];
+        s_dimmed.bits[i] = table[p & 0xFF] | (table[(p >> 8) & 0xFF] << 8) | (table[(p >> 16) & 0xFF] << 16);
+    }
+}
+
+// 拷贝 src 中 r 覆盖的像素到后备缓冲（调用方保证 r 在屏幕内）
+static void CopyDibRect(const ScreenDib& src, const RECT& r) {
+    if (r.left >= r.right || r.top >= r.bottom) return;
+    size_t rowBytes = (size_t)(r.right - r.left) * 4;
+    for (LONG y = r.top; y < r.bottom; y++) {
+        size_t offset = (size_t)y * s_back.width + r.left;
+        memcpy(s_back.bits + offset, src.bits + offset, rowBytes);
+    }
+}
+
+// 在后备缓冲中还原 r 的底图：选区外为压暗的桌面，选区内为原图
+static void ComposeBackground(RECT r) {
+    RECT screen = { 0, 0, s_back.width, s_back.height };
+    if (!IntersectRect(&r, &r, &screen)) return;
+    CopyDibRect(s_dimmed, r);
+    RECT inside;
+    if ((s_selecting || s_hasSelection) && IntersectRect(&inside, &r, &s_selRect)) CopyDibRect(s_desktop, inside);
+}
+
+// 选区变化后重新生成尺寸标签并定位：优先放在选区上方，放不下时放进选区内
+static void UpdateSizeLabel() {
+    swprintf(s_labelText, 64, L"%d × %d", (int)(s_selRect.right - s_selRect.left), (int)(s_selRect.bottom - s_selRect.top));
+    RectF text;
+    s_overlay->graphics.MeasureString(s_labelText, -1, &s_overlay->labelFont, PointF(0, 0), &text);
+    float tx = (float)s_selRect.left;
+    float ty = (float)s_selRect.top - text.Height - 4;
+    if (ty < 0) ty = (float)s_selRect.top + 4;
+    s_labelRect = RectF(tx, ty, text.Width + 8, text.Height + 2);
+}
+
+// 当前画面中边框、标签、按钮和提示文字覆盖的区域（边框外扩 2 像素，覆盖画笔宽度与抗锯齿）
+static HRGN DecorationRegion() {
+    HRGN rgn = CreateRectRgn(0, 0, 0, 0);
+    auto add = [rgn](const RECT& r) {
+        HRGN part = CreateRectRgnIndirect(&r);
+        CombineRgn(rgn, rgn, part, RGN_OR);
+        DeleteObject(part);
+    };
+    if (s_selecting || s_hasSelection) {
+        RECT outer = s_selRect, inner = s_selRect;
+        InflateRect(&outer, 2, 2);
+        InflateRect(&inner, -2, -2);
+        HRGN frame = CreateRectRgnIndirect(&outer);
+        if (inner.left < inner.right && inner.top < inner.bottom) {
+            HRGN hole = CreateRectRgnIndirect(&inner);
+            CombineRgn(frame, frame, hole, RGN_DIFF);
+            DeleteObject(hole);
+        }
+        CombineRgn(rgn, rgn, frame, RGN_OR);
+        DeleteObject(frame);
+
+        RECT label = { (LONG)floorf(s_labelRect.X) - 1, (LONG)floorf(s_labelRect.Y) - 1,
+                       (LONG)ceilf(s_labelRect.X + s_labelRect.Width) + 1,
+                       (LONG)ceilf(s_labelRect.Y + s_labelRect.Height) + 1 };
+        add(label);
+        if (s_hasSelection && !s_selecting) {
+            add(s_btnConfirm);
+            add(s_btnCancel);
+        }
+    } else {
+        RECT screen = { 0, 0, s_screenW, s_screenH }; // 提示文字居中于整屏
+        add(screen);
+    }
+    return rgn;
+}
+
+// 选区状态变化：只重绘前后两个选区的差异以及前后两次的装饰区域
+// before 为变化前的装饰区域（DecorationRegion 的返回值，由本函数释放）
+static void InvalidateSelectionChange(HWND hwnd, const RECT& oldSel, bool oldActive, HRGN before) {
+    RECT empty = { 0, 0, 0, 0 };
+    bool active = s_selecting || s_hasSelection;
+    HRGN a = CreateRectRgnIndirect(oldActive ? &oldSel : &empty);
+    HRGN b = CreateRectRgnIndirect(active ? &s_selRect : &empty);
+    HRGN changed = CreateRectRgn(0, 0, 0, 0);
+    CombineRgn(changed, a, b, RGN_XOR);
+    CombineRgn(changed, changed, before, RGN_OR);
+    HRGN after = DecorationRegion();
+    CombineRgn(changed, changed, after, RGN_OR);
+    InvalidateRgn(hwnd, changed, FALSE);
+    DeleteObject(a);
+    DeleteObject(b);
+    DeleteObject(changed);
+    DeleteObject(before);
+    DeleteObject(after);
+}
+
+// 在后备缓冲上画边框、尺寸标签、按钮或提示文字（已按更新区域裁剪）
+static void DrawDecorations() {
+    OverlayResources& res = *s_overlay;
+    Graphics& g = res.graphics;
+    if (s_selecting || s_hasSelection) {
+        RECT r = s_selRect;
+        g.DrawRectangle(&res.borderPen, (INT)r.left, (INT)r.top, (INT)(r.right - r.left), (INT)(r.bottom - r.top));
+        g.FillRectangle(&res.labelBg, s_labelRect);
+        g.DrawString(s_labelText, -1, &res.labelFont, PointF(s_labelRect.X + 4, s_labelRect.Y + 1), &res.white);
+    } else {
+        RectF area(0, 0, (float)s_screenW, (float)s_screenH);
+        g.DrawString(L"拖拽鼠标选择截图区域，ESC 取消", -1, &res.hintFont, area, &res.centered, &res.hintBrush);
+    }
+
+    if (s_hasSelection && !s_selecting) {
+        auto button = [&](const RECT& b, Brush* bg, const wchar_t* text) {
+            RectF area((float)b.left, (float)b.top, (float)(b.right - b.left), (float)(b.bottom - b.top));
+            g.FillRectangle(bg, area);
+            g.DrawString(text, -1, &res.buttonFont, area, &res.centered, &res.white);
+        };
+        button(s_btnConfirm, &res.confirmBg, L"\u2714 确认");
+        button(s_btnCancel, &res.cancelBg, L"\u2716 取消");
+    }
+}
+
+// 绘制覆盖窗口：只合成并提交更新区域
 static void PaintOverlay(HWND hwnd) {
+    HRGN update = CreateRectRgn(0, 0, 0, 0);
+    GetUpdateRgn(hwnd, update, FALSE);
     PAINTSTRUCT ps;
     HDC hdc = BeginPaint(hwnd, &ps);
-    HDC hdcMem = CreateCompatibleDC(hdc);
-    HBITMAP hBuf = CreateCompatibleBitmap(hdc, s_screenW, s_screenH);
-    HBITMAP hOld = (HBITMAP)SelectObject(hdcMem, hBuf);
-
-    // 绘制桌面截图
-    HDC hdcDesktop = CreateCompatibleDC(hdc);
-    SelectObject(hdcDesktop, s_hDesktop);
-    BitBlt(hdcMem, 0, 0, s_screenW, s_screenH, hdcDesktop, 0, 0, SRCCOPY);
-    DeleteDC(hdcDesktop);
-
-    // 半透明遮罩（选区外变暗）
-    {
-        Graphics g(hdcMem);
-        SolidBrush dimBrush(Color(120, 0, 0, 0));
-
-        if (s_selecting || s_hasSelection) {
-            // 用四个矩形覆盖选区外的区域
-            RECT r = s_selRect;
-            // 上
-            g.FillRectangle(&dimBrush, (INT)0, (INT)0, (INT)s_screenW, (INT)r.top);
-            // 下
-            g.FillRectangle(&dimBrush, (INT)0, (INT)r.bottom, (INT)s_screenW, (INT)(s_screenH - r.bottom));
-            // 左
-            g.FillRectangle(&dimBrush, (INT)0, (INT)r.top, (INT)r.left, (INT)(r.bottom - r.top));
-            // 右
-            g.FillRectangle(&dimBrush, (INT)r.right, (INT)r.top, (INT)(s_screenW - r.right), (INT)(r.bottom - r.top));
-
-            // 选区边框
-            Pen borderPen(Color(255, 0, 120, 215), 2.0f);
-            g.DrawRectangle(&borderPen, (INT)r.left, (INT)r.top, (INT)(r.right - r.left), (INT)(r.bottom - r.top));
-
-            // 选区尺寸文字
-            int sw = r.right - r.left;
-            int sh = r.bottom - r.top;
-            wchar_t sizeText[64];
-            swprintf(sizeText, 64, L"%d × %d", sw, sh);
-            Font font(L"Segoe UI", 11.0f);
-            SolidBrush textBg(Color(180, 0, 0, 0));
-            SolidBrush textBrush(Color(255, 255, 255, 255));
-            RectF textRect;
-            g.MeasureString(sizeText, -1, &font, PointF(0, 0), &textRect);
-            float tx = (float)r.left;
-            float ty = (float)r.top - textRect.Height - 4;
-            if (ty < 0) ty = (float)r.top + 4;
-            g.FillRectangle(&textBg, tx, ty, textRect.Width + 8, textRect.Height + 2);
-            g.DrawString(sizeText, -1, &font, PointF(tx + 4, ty + 1), &textBrush);
+
+    if (s_back.bits && s_overlay) {
+        // 更新区域可能是若干分散的矩形（如选区四周的细条），逐个还原底图，不按包围盒整块处理
+        DWORD bytes = GetRegionData(update, 0, nullptr);
+        std::vector<BYTE> buffer(bytes);
+        RGNDATA* data = (RGNDATA*)buffer.data();
+        if (bytes && GetRegionData(update, bytes, data)) {
+            const RECT* rects = (const RECT*)data->Buffer;
+            for (DWORD i = 0; i < data->rdh.nCount; i++) ComposeBackground(rects[i]);
         } else {
-            // 无选区时全屏变暗
-            g.FillRectangle(&dimBrush, (INT)0, (INT)0, (INT)s_screenW, (INT)s_screenH);
-
-            // 提示文字
-            Font font(L"Segoe UI", 14.0f);
-            SolidBrush textBrush(Color(200, 255, 255, 255));
-            StringFormat sf;
-            sf.SetAlignment(StringAlignmentCenter);
-            sf.SetLineAlignment(StringAlignmentCenter);
-            RectF area(0, 0, (float)s_screenW, (float)s_screenH);
-            g.DrawString(L"拖拽鼠标选择截图区域，ESC 取消", -1, &font, area, &sf, &textBrush);
+            ComposeBackground(ps.rcPaint);
         }
 
-        // 确认/取消按钮
-        if (s_hasSelection && !s_selecting) {
-            // 确认按钮
-            SolidBrush confirmBg(Color(220, 0, 120, 215));
-            g.FillRectangle(&confirmBg, (INT)s_btnConfirm.left, (INT)s_btnConfirm.top,
-                            (INT)(s_btnConfirm.right - s_btnConfirm.left), (INT)(s_btnConfirm.bottom - s_btnConfirm.top));
-            Font btnFont(L"Segoe UI", 10.0f);
-            SolidBrush btnText(Color(255, 255, 255, 255));
-            StringFormat btnSf;
-            btnSf.SetAlignment(StringAlignmentCenter);
-            btnSf.SetLineAlignment(StringAlignmentCenter);
-            RectF confirmArea((float)s_btnConfirm.left, (float)s_btnConfirm.top,
-                              (float)(s_btnConfirm.right - s_btnConfirm.left),
-                              (float)(s_btnConfirm.bottom - s_btnConfirm.top));
-            g.DrawString(L"\u2714 确认", -1, &btnFont, confirmArea, &btnSf, &btnText);
-
-            // 取消按钮
-            SolidBrush cancelBg(Color(220, 80, 80, 80));
-            g.FillRectangle(&cancelBg, (INT)s_btnCancel.left, (INT)s_btnCancel.top,
-                            (INT)(s_btnCancel.right - s_btnCancel.left), (INT)(s_btnCancel.bottom - s_btnCancel.top));
-            RectF cancelArea((float)s_btnCancel.left, (float)s_btnCancel.top,
-                             (float)(s_btnCancel.right - s_btnCancel.left),
-                             (float)(s_btnCancel.bottom - s_btnCancel.top));
-            g.DrawString(L"\u2716 取消", -1, &btnFont, cancelArea, &btnSf, &btnText);
-        }
+        s_overlay->graphics.SetClip(update);
+        DrawDecorations();
+        s_overlay->graphics.Flush(FlushIntentionSync);
+
+        // BeginPaint 返回的 DC 已按更新区域裁剪
+        BitBlt(hdc, ps.rcPaint.left, ps.rcPaint.top, ps.rcPaint.right - ps.rcPaint.left,
+               ps.rcPaint.bottom - ps.rcPaint.top, s_back.dc, ps.rcPaint.left, ps.rcPaint.top, SRCCOPY);
     }
 
-    BitBlt(hdc, 0, 0, s_screenW, s_screenH, hdcMem, 0, 0, SRCCOPY);
-    SelectObject(hdcMem, hOld);
-    DeleteObject(hBuf);
-    DeleteDC(hdcMem);
     EndPaint(hwnd, &ps);
+    DeleteObject(update);
 }
 
 // 清理并关闭截图窗口
 static void CloseScreenshot(HWND hwnd) {
-    if (s_hDesktop) {
-        DeleteObject(s_hDesktop);
-        s_hDesktop = nullptr;
-    }
+    s_overlay.reset();
+    ReleaseScreenDib(s_back);
+    ReleaseScreenDib(s_dimmed);
+    ReleaseScreenDib(s_desktop);
     DestroyWindow(hwnd);
     s_hwndScreenshot = nullptr;
     // 恢复主窗口
@@ -238,17 +423,17 @@ LRESULT CALLBACK ScreenshotProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lPar
             break;
 
         case WM_LBUTTONDOWN: {
-            POINT pt = { LOWORD(lParam), HIWORD(lParam) };
+            POINT pt = { GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam) };
 
             // 如果已有选区，检查是否点击了按钮
             if (s_hasSelection && !s_selecting) {
                 if (PtInRect(&s_btnConfirm, pt)) {
-                    SaveSelection(hwnd);
+                    std::wstring saved;
+                    bool ok = SaveSelection(hwnd, &saved);
                     CloseScreenshot(hwnd);
-                    // 触发主窗口重绘以自动加载新截图
-                    reloadImage = true;
-                    // PostMessage(s_hwndMain, WM_USER, 0, 0);
-                    InvalidateRect(s_hwndMain, nullptr, TRUE);
+                    // 自动加载模式下直接切换到新截图：像素已在缓存中，下一帧即可显示
+                    if (ok && autoLoadLatest) SetCurrentImagePath(saved);
+                    RequestRender();
                     return 0;
                 }
                 if (PtInRect(&s_btnCancel, pt)) {
@@ -258,29 +443,40 @@ LRESULT CALLBACK ScreenshotProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lPar
             }
 
             // 开始新选区
+            RECT oldSel = s_selRect;
+            bool oldActive = s_selecting || s_hasSelection;
+            HRGN before = DecorationRegion();
             s_selecting = true;
             s_hasSelection = false;
             s_startPt = pt;
             s_selRect = { pt.x, pt.y, pt.x, pt.y };
+            UpdateSizeLabel();
             SetCapture(hwnd);
-            InvalidateRect(hwnd, nullptr, FALSE);
+            InvalidateSelectionChange(hwnd, oldSel, oldActive, before);
             return 0;
         }
 
         case WM_MOUSEMOVE: {
             if (s_selecting) {
-                POINT pt = { LOWORD(lParam), HIWORD(lParam) };
-                s_selRect = NormalizeRect(s_startPt, pt);
-                InvalidateRect(hwnd, nullptr, FALSE);
+                POINT pt = { GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam) };
+                RECT next = NormalizeRect(s_startPt, pt);
+                if (EqualRect(&next, &s_selRect)) return 0;
+                RECT oldSel = s_selRect;
+                HRGN before = DecorationRegion();
+                s_selRect = next;
+                UpdateSizeLabel();
+                InvalidateSelectionChange(hwnd, oldSel, true, before);
             }
             return 0;
         }
 
         case WM_LBUTTONUP: {
             if (s_selecting) {
+                RECT oldSel = s_selRect;
+                HRGN before = DecorationRegion();
                 s_selecting = false;
                 ReleaseCapture();
-                POINT pt = { LOWORD(lParam), HIWORD(lParam) };
+                POINT pt = { GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam) };
                 s_selRect = NormalizeRect(s_startPt, pt);
 
                 int w = s_selRect.right - s_selRect.left;
@@ -291,7 +487,8 @@ LRESULT CALLBACK ScreenshotProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lPar
                 } else {
                     s_hasSelection = false;
                 }
-                InvalidateRect(hwnd, nullptr, FALSE);
+                UpdateSizeLabel();
+                InvalidateSelectionChange(hwnd, oldSel, true, before);
             }
             return 0;
         }
@@ -310,16 +507,30 @@ LRESULT CALLBACK ScreenshotProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lPar
 
 // 实际执行桌面截取和创建覆盖窗口
 static void DoCapture() {
-    // 截取整个桌面
-    s_screenW = GetSystemMetrics(SM_CXSCREEN);
-    s_screenH = GetSystemMetrics(SM_CYSCREEN);
+    // 只截取鼠标所在的显示器（物理像素），覆盖窗口也只铺满该显示器
+    ScopedPerMonitorDpi dpiScope;
+    MonitorTarget monitor;
+    if (!GetCursorMonitor(&monitor)) {
+        if (s_hwndMain && isWindowVisible) ShowWindow(s_hwndMain, SW_SHOW);
+        return;
+    }
+    s_screenX = monitor.rect.left;
+    s_screenY = monitor.rect.top;
+    s_screenW = monitor.rect.right - monitor.rect.left;
+    s_screenH = monitor.rect.bottom - monitor.rect.top;
+    if (!CreateScreenDib(s_desktop, s_screenW, s_screenH) || !CreateScreenDib(s_dimmed, s_screenW, s_screenH) ||
+        !CreateScreenDib(s_back, s_screenW, s_screenH)) {
+        ReleaseScreenDib(s_back);
+        ReleaseScreenDib(s_dimmed);
+        ReleaseScreenDib(s_desktop);
+        if (s_hwndMain && isWindowVisible) ShowWindow(s_hwndMain, SW_SHOW);
+        return;
+    }
     HDC hdcScreen = GetDC(nullptr);
-    HDC hdcMem = CreateCompatibleDC(hdcScreen);
-    s_hDesktop = CreateCompatibleBitmap(hdcScreen, s_screenW, s_screenH);
-    SelectObject(hdcMem, s_hDesktop);
-    BitBlt(hdcMem, 0, 0, s_screenW, s_screenH, hdcScreen, 0, 0, SRCCOPY);
-    DeleteDC(hdcMem);
+    BitBlt(s_desktop.dc, 0, 0, s_screenW, s_screenH, hdcScreen, s_screenX, s_screenY, SRCCOPY);
     ReleaseDC(nullptr, hdcScreen);
+    BuildDimmedDesktop();
+    s_overlay = std::make_unique<OverlayResources>(s_back.dc);
 
     // 创建天蓝色十字准星光标（32位ARGB，背景完全透明）
     if (!s_hCrossCursor) {
@@ -395,12 +606,12 @@ static void DoCapture() {
         s_classRegistered = true;
     }
 
-    // 创建全屏无边框置顶窗口
+    // 创建覆盖目标显示器的无边框置顶窗口，客户区坐标即截图内的像素坐标
     s_hwndScreenshot = CreateWindowExW(
         WS_EX_TOPMOST,
         SCREENSHOT_CLASS, L"",
         WS_POPUP | WS_VISIBLE,
-        0, 0, s_screenW, s_screenH,
+        s_screenX, s_screenY, s_screenW, s_screenH,
         nullptr, nullptr, g_hInstance, nullptr
     );
 
@@ -11,3 +11,6 @@ LRESULT CALLBACK ScreenshotProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lPar
 // 注册/注销截图全局热键（阻止其他程序捕获）
 void RegisterScreenshotHotkey(HWND hwnd);
 void UnregisterScreenshotHotkey(HWND hwnd);
+
+// 退出前等待后台的截图写盘完成（须在 StopImageCache 与 GdiplusShutdown 之前调用）
+void StopScreenshotSaver();
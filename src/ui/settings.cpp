@@ -1,6 +1,8 @@
 #include "settings.h"
 #include "globals.h"
 #include "screenshot.h"
+#include "drawing.h"
+#include "render.h"
 #include <filesystem>
 
 // 临时快捷键配置（编辑中，应用时写入 g_hotkeys）
@@ -104,7 +106,7 @@ void CreateSettingsWindow() {
         WS_EX_TOOLWINDOW,
         SETTINGS_CLASS, L"GuessDraw 设置",
         WS_OVERLAPPED | WS_CAPTION | WS_SYSMENU,
-        CW_USEDEFAULT, CW_USEDEFAULT, 420, 770,
+        CW_USEDEFAULT, CW_USEDEFAULT, 420, 854,
         nullptr, nullptr, g_hInstance, nullptr
     );
 
@@ -167,7 +169,7 @@ LRESULT CALLBACK SettingsProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam
         y += 30;
         // 图片目录
         CreateWindowW(L"STATIC", L"图片目录:", WS_CHILD | WS_VISIBLE, 15, y + 2, 75, 20, hwnd, nullptr, g_hInstance, nullptr);
-        hEditPath = CreateWindowW(L"EDIT", imageDirectory.c_str(),
+        hEditPath = CreateWindowW(L"EDIT", GetImageDirectory().c_str(),
             WS_CHILD | WS_VISIBLE | WS_BORDER | ES_AUTOHSCROLL,
             ctrlX, y, 220, 24, hwnd, (HMENU)IDC_EDIT_PATH, g_hInstance, nullptr);
         hBtnBrowse = CreateWindowW(L"BUTTON", L"...", WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON,
@@ -225,7 +227,8 @@ LRESULT CALLBACK SettingsProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam
             wchar_t buf[32];
             swprintf(buf, 32, L"%d%%", val);
             SetWindowTextW(GetDlgItem(hwnd, IDC_LABEL_OPACITY), buf);
-            InvalidateRect(g_hwndMain, nullptr, TRUE);
+            MarkInteraction();
+            RequestRender();
         }
         if ((HWND)lParam == GetDlgItem(hwnd, IDC_SLIDER_SCALE)) {
             int val = (int)SendMessage((HWND)lParam, TBM_GETPOS, 0, 0);
@@ -233,7 +236,8 @@ LRESULT CALLBACK SettingsProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam
             wchar_t buf[32];
             swprintf(buf, 32, L"%d%%", val);
             SetWindowTextW(GetDlgItem(hwnd, IDC_LABEL_SCALE), buf);
-            InvalidateRect(g_hwndMain, nullptr, TRUE);
+            MarkInteraction();
+            RequestRender();
         }
         return 0;
     }
@@ -249,7 +253,7 @@ LRESULT CALLBACK SettingsProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam
             if (pidl) {
                 wchar_t path[MAX_PATH];
                 SHGetPathFromIDListW(pidl, path);
-                imageDirectory = path;
+                SetImageDirectory(path);
                 SetWindowTextW(GetDlgItem(hwnd, IDC_EDIT_PATH), path);
                 CoTaskMemFree(pidl);
             }
@@ -269,7 +273,10 @@ LRESULT CALLBACK SettingsProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam
                 { VK_RIGHT,   false, false, false },
                 { VK_NUMPAD6, false, false, false },
                 { VK_NUMPAD4, false, false, false },
+                { VK_NUMPAD5, false, false, false },
+                { VK_NUMPAD7, false, false, false },
                 { VK_F1,      false, false, false },
+                { VK_F9,      false, false, false },
             };
             for (int i = 0; i < HK_COUNT; i++) {
                 s_tempHotkeys[i] = defaults[i];
@@ -297,10 +304,12 @@ LRESULT CALLBACK SettingsProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam
             SendMessageW(s_comboDragMouse, CB_SETCURSEL, 0, 0);
             g_dragMouseButton = VK_LBUTTON;
 
-            // 恢复旋转角度
+            // 恢复旋转角度与镜像
             rotationAngle = 0;
+            mirrorHorizontal = false;
+            mirrorVertical = false;
 
-            InvalidateRect(g_hwndMain, nullptr, TRUE);
+            RequestRender();
         }
         if (wmId == IDC_BTN_APPLY) {
             // 应用图片设置
@@ -313,10 +322,10 @@ LRESULT CALLBACK SettingsProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam
             std::wstring newDir = pathBuf;
 
             // 目录变化时迁移配置文件
-            if (newDir != imageDirectory) {
+            if (newDir != GetImageDirectory()) {
                 std::wstring oldConfig = std::wstring(GetConfigPath());
-                imageDirectory = newDir;
-                std::filesystem::create_directories(imageDirectory);
+                SetImageDirectory(newDir);
+                std::filesystem::create_directories(newDir);
                 std::wstring newConfig = std::wstring(GetConfigPath());
                 try {
                     if (std::filesystem::exists(oldConfig)) {
@@ -334,14 +343,13 @@ LRESULT CALLBACK SettingsProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam
             int sel = (int)SendMessageW(s_comboDragMouse, CB_GETCURSEL, 0, 0);
             g_dragMouseButton = (sel == 1) ? VK_RBUTTON : VK_LBUTTON;
 
-            // 保存配置到文件
-            SaveConfig();
+            // 保存配置到文件（连续点击应用时合并为一次写盘）
+            RequestSaveConfig();
 
             // 重新注册截图全局热键（快捷键可能已变更）
             RegisterScreenshotHotkey(g_hwndMain);
 
-            reloadImage = true;
-            PostMessage(g_hwndMain, WM_PAINT, 0, 0);
+            RequestRender();
         }
         return 0;
     }
@@ -24,6 +24,7 @@ void ShowTrayMenu(HWND hwnd) {
     AppendMenuW(hMenu, MF_STRING, IDM_SHOW_HIDE, isWindowVisible ? L"隐藏图片" : L"显示图片");
     AppendMenuW(hMenu, MF_STRING, IDM_RELOAD, L"重新加载");
     AppendMenuW(hMenu, MF_STRING, IDM_SETTINGS, L"设置");
+    AppendMenuW(hMenu, MF_STRING, IDM_EXPORT_TRACE, L"导出帧耗时记录");
     AppendMenuW(hMenu, MF_SEPARATOR, 0, nullptr);
     AppendMenuW(hMenu, MF_STRING, IDM_EXIT, L"退出");
 
@@ -33,3 +34,13 @@ void ShowTrayMenu(HWND hwnd) {
     TrackPopupMenu(hMenu, TPM_RIGHTBUTTON, pt.x, pt.y, 0, hwnd, nullptr);
     DestroyMenu(hMenu);
 }
+
+// 在托盘图标上弹出气泡通知
+void ShowTrayNotice(const wchar_t* title, const std::wstring& text) {
+    NOTIFYICONDATAW nid = g_nid;
+    nid.uFlags = NIF_INFO;
+    nid.dwInfoFlags = NIIF_INFO;
+    lstrcpynW(nid.szInfoTitle, title, ARRAYSIZE(nid.szInfoTitle));
+    lstrcpynW(nid.szInfo, text.c_str(), ARRAYSIZE(nid.szInfo));
+    Shell_NotifyIconW(NIM_MODIFY, &nid);
+}
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <windows.h>
+#include <string>
 
 void CreateTrayIcon(HWND hwnd);
 void RemoveTrayIcon();
 void ShowTrayMenu(HWND hwnd);
+void ShowTrayNotice(const wchar_t* title, const std::wstring& text); // 托盘气泡通知